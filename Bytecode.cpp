@@ -0,0 +1,1778 @@
+#include "Bytecode.h"
+#include "Resolver.h"
+
+//
+//
+//
+
+struct Bytecode_Value
+{
+	enum Kind
+	{
+		NONE,
+		FRAME,
+		GLOBAL,
+		STATIC,
+		INDIRECT,
+	};
+
+	Kind       kind         = NONE;
+	uint32_t   offset       = 0;       // FRAME and GLOBAL offset, or the frame slot holding the pointer for INDIRECT
+	uint64_t   displacement = 0;       // INDIRECT
+	uint8_t *  address      = nullptr; // STATIC
+	Code_Type *type         = nullptr;
+};
+
+enum Bytecode_Field
+{
+	BYTECODE_FIELD_A,
+	BYTECODE_FIELD_B,
+	BYTECODE_FIELD_IMM,
+};
+
+// Operands that refer to the callee area are emitted relative to the end of the
+// caller's frame and fixed up once the frame size of the caller is known
+struct Bytecode_Patch
+{
+	uint32_t       instruction;
+	Bytecode_Field field;
+};
+
+struct Bytecode_Loop
+{
+	Array<uint32_t> breaks;
+	Array<uint32_t> continues;
+};
+
+struct Bytecode_Compiler
+{
+	Interpreter *        interp    = nullptr;
+	Bytecode_Program *   program   = nullptr;
+	Bytecode_Procedure * procedure = nullptr;
+
+	Array<Bytecode_Patch>       patches;
+	Array<Bytecode_Loop *>      loops;
+	Array<Bytecode_Procedure *> pending;
+
+	uint32_t locals_size   = 0;
+	uint32_t temporary_top = 0;
+	uint32_t temporary_max = 0;
+};
+
+static Bytecode_Value bytecode_lower_expression(Bytecode_Compiler *compiler, Code_Node *root, int64_t dst = -1);
+
+//
+//
+//
+
+static inline Bytecode_Value bytecode_frame_value(uint32_t offset, Code_Type *type)
+{
+	Bytecode_Value value;
+	value.kind   = Bytecode_Value::FRAME;
+	value.offset = offset;
+	value.type   = type;
+	return value;
+}
+
+static inline Bytecode_Value bytecode_indirect_value(uint32_t pointer, uint64_t displacement, Code_Type *type)
+{
+	Bytecode_Value value;
+	value.kind         = Bytecode_Value::INDIRECT;
+	value.offset       = pointer;
+	value.displacement = displacement;
+	value.type         = type;
+	return value;
+}
+
+static inline Bytecode_Value bytecode_static_value(void *address, Code_Type *type)
+{
+	Bytecode_Value value;
+	value.kind    = Bytecode_Value::STATIC;
+	value.address = (uint8_t *)address;
+	value.type    = type;
+	return value;
+}
+
+static inline Bytecode_Value bytecode_member_value(Bytecode_Value value, uint64_t offset, Code_Type *type)
+{
+	switch (value.kind)
+	{
+		case Bytecode_Value::FRAME:
+		case Bytecode_Value::GLOBAL: value.offset += (uint32_t)offset; break;
+		case Bytecode_Value::INDIRECT: value.displacement += offset; break;
+		case Bytecode_Value::STATIC: value.address += offset; break;
+		NoDefaultCase();
+	}
+	value.type = type;
+	return value;
+}
+
+static inline uint32_t bytecode_emit(Bytecode_Compiler *compiler, Bytecode_Op op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0)
+{
+	auto code        = &compiler->procedure->code;
+	auto instruction = code->Add();
+	*instruction     = Bytecode_Instruction{};
+	instruction->op  = op;
+	instruction->a   = a;
+	instruction->b   = b;
+	instruction->c   = c;
+	return (uint32_t)(code->count - 1);
+}
+
+static inline Bytecode_Instruction *bytecode_instruction(Bytecode_Compiler *compiler, uint32_t index)
+{
+	return &compiler->procedure->code[index];
+}
+
+static inline uint32_t bytecode_label(Bytecode_Compiler *compiler)
+{
+	return (uint32_t)compiler->procedure->code.count;
+}
+
+static inline void bytecode_bind(Bytecode_Compiler *compiler, uint32_t jump, uint32_t target)
+{
+	bytecode_instruction(compiler, jump)->imm.int_value = target;
+}
+
+static inline void bytecode_patch_frame(Bytecode_Compiler *compiler, uint32_t instruction, Bytecode_Field field)
+{
+	compiler->patches.Add(Bytecode_Patch{ instruction, field });
+}
+
+static uint32_t bytecode_temporary(Bytecode_Compiler *compiler, uint32_t size, uint32_t alignment)
+{
+	alignment = Maximum(alignment, 1u);
+
+	auto offset                = (uint32_t)AlignPower2Up(compiler->temporary_top, alignment);
+	compiler->temporary_top    = offset + size;
+	compiler->temporary_max    = Maximum(compiler->temporary_max, compiler->temporary_top);
+	return offset;
+}
+
+static inline uint32_t bytecode_temporary(Bytecode_Compiler *compiler, Code_Type *type)
+{
+	return bytecode_temporary(compiler, type->runtime_size, type->alignment);
+}
+
+static inline uint32_t bytecode_result(Bytecode_Compiler *compiler, Code_Type *type, int64_t dst)
+{
+	if (dst >= 0)
+		return (uint32_t)dst;
+	return bytecode_temporary(compiler, type);
+}
+
+static Bytecode_Procedure *bytecode_procedure_for(Bytecode_Compiler *compiler, Code_Node_Block *block, Code_Type_Procedure *type)
+{
+	auto program = compiler->program;
+
+	auto found = program->lookup.Find((uint64_t)block);
+	if (found)
+		return *found;
+
+	auto procedure   = new Bytecode_Procedure;
+	procedure->block = block;
+	procedure->type  = type;
+
+	program->lookup.Put((uint64_t)block, procedure);
+	program->procedures.Add(procedure);
+	compiler->pending.Add(procedure);
+
+	return procedure;
+}
+
+//
+//
+//
+
+static bool bytecode_has_side_effects(Code_Node *root)
+{
+	switch (root->kind)
+	{
+		case CODE_NODE_LITERAL: return false;
+
+		case CODE_NODE_ADDRESS: {
+			auto node = (Code_Node_Address *)root;
+			if (node->subscript && (bytecode_has_side_effects(node->subscript->expression) || bytecode_has_side_effects(node->subscript->subscript)))
+				return true;
+			for (int64_t index = 0; index < node->index_count; ++index)
+			{
+				if (bytecode_has_side_effects(node->indices[index].expression))
+					return true;
+			}
+			return false;
+		}
+
+		case CODE_NODE_EXPRESSION: return bytecode_has_side_effects(((Code_Node_Expression *)root)->child);
+		case CODE_NODE_TYPE_CAST: return bytecode_has_side_effects(((Code_Node_Type_Cast *)root)->child);
+		case CODE_NODE_UNARY_OPERATOR: return bytecode_has_side_effects(((Code_Node_Unary_Operator *)root)->child);
+		case CODE_NODE_OFFSET: return bytecode_has_side_effects(((Code_Node_Offset *)root)->expression);
+
+		case CODE_NODE_BINARY_OPERATOR: {
+			auto node = (Code_Node_Binary_Operator *)root;
+			if (node->op_kind >= BINARY_OPERATOR_COMPOUND_ADDITION && node->op_kind <= BINARY_OPERATOR_COMPOUND_BITWISE_OR)
+				return true;
+			return bytecode_has_side_effects(node->left) || bytecode_has_side_effects(node->right);
+		}
+	}
+
+	return true;
+}
+
+// Copies the value into a fresh temporary unless it can not be changed by the code emitted after it
+static Bytecode_Value bytecode_snapshot(Bytecode_Compiler *compiler, Bytecode_Value value);
+
+static uint32_t bytecode_load_into(Bytecode_Compiler *compiler, Bytecode_Value value, uint32_t dst)
+{
+	auto size = value.type->runtime_size;
+
+	switch (value.kind)
+	{
+		case Bytecode_Value::FRAME: {
+			auto op = (size == 1) ? BYTECODE_MOV_1 : ((size == 8) ? BYTECODE_MOV_8 : BYTECODE_MOV_N);
+			return bytecode_emit(compiler, op, dst, value.offset, size);
+		}
+
+		case Bytecode_Value::GLOBAL: {
+			auto op = (size == 1) ? BYTECODE_LOAD_GLOBAL_1 : ((size == 8) ? BYTECODE_LOAD_GLOBAL_8 : BYTECODE_LOAD_GLOBAL_N);
+			return bytecode_emit(compiler, op, dst, value.offset, size);
+		}
+
+		case Bytecode_Value::INDIRECT: {
+			auto op          = (size == 1) ? BYTECODE_LOAD_1 : ((size == 8) ? BYTECODE_LOAD_8 : BYTECODE_LOAD_N);
+			auto instruction = bytecode_emit(compiler, op, dst, value.offset, size);
+			bytecode_instruction(compiler, instruction)->imm.int_value = (Kano_Int)value.displacement;
+			return instruction;
+		}
+
+		case Bytecode_Value::STATIC: {
+			if (size == 1)
+			{
+				auto instruction = bytecode_emit(compiler, BYTECODE_MOVI_1, dst);
+				bytecode_instruction(compiler, instruction)->imm.int_value = *(Kano_Char *)value.address;
+				return instruction;
+			}
+			else if (size == 8)
+			{
+				auto instruction = bytecode_emit(compiler, BYTECODE_MOVI_8, dst);
+				bytecode_instruction(compiler, instruction)->imm.int_value = *(Kano_Int *)value.address;
+				return instruction;
+			}
+
+			auto instruction = bytecode_emit(compiler, BYTECODE_LOAD_STATIC, dst, 0, size);
+			bytecode_instruction(compiler, instruction)->imm.pointer = value.address;
+			return instruction;
+		}
+
+		NoDefaultCase();
+	}
+
+	Unreachable();
+	return 0;
+}
+
+static void bytecode_move(Bytecode_Compiler *compiler, Bytecode_Value value, uint32_t dst)
+{
+	if (value.kind == Bytecode_Value::FRAME && value.offset == dst)
+		return;
+	bytecode_load_into(compiler, value, dst);
+}
+
+static uint32_t bytecode_load(Bytecode_Compiler *compiler, Bytecode_Value value)
+{
+	if (value.kind == Bytecode_Value::FRAME)
+		return value.offset;
+
+	auto dst = bytecode_temporary(compiler, value.type);
+	bytecode_load_into(compiler, value, dst);
+	return dst;
+}
+
+static Bytecode_Value bytecode_snapshot(Bytecode_Compiler *compiler, Bytecode_Value value)
+{
+	if (value.kind == Bytecode_Value::NONE || value.kind == Bytecode_Value::STATIC)
+		return value;
+
+	if (value.kind == Bytecode_Value::FRAME && value.offset >= compiler->locals_size)
+		return value;
+
+	auto dst = bytecode_temporary(compiler, value.type);
+	bytecode_load_into(compiler, value, dst);
+	return bytecode_frame_value(dst, value.type);
+}
+
+static uint32_t bytecode_address_of(Bytecode_Compiler *compiler, Bytecode_Value value)
+{
+	if (value.kind == Bytecode_Value::INDIRECT && value.displacement == 0)
+		return value.offset;
+
+	auto dst = bytecode_temporary(compiler, sizeof(void *), sizeof(void *));
+
+	switch (value.kind)
+	{
+		case Bytecode_Value::FRAME: {
+			auto instruction = bytecode_emit(compiler, BYTECODE_ADDRESS_FRAME, dst);
+			bytecode_instruction(compiler, instruction)->imm.int_value = value.offset;
+		}
+		break;
+
+		case Bytecode_Value::GLOBAL: {
+			auto instruction = bytecode_emit(compiler, BYTECODE_ADDRESS_GLOBAL, dst);
+			bytecode_instruction(compiler, instruction)->imm.int_value = value.offset;
+		}
+		break;
+
+		case Bytecode_Value::INDIRECT: {
+			auto instruction = bytecode_emit(compiler, BYTECODE_OFFSET_POINTER, dst, value.offset);
+			bytecode_instruction(compiler, instruction)->imm.int_value = (Kano_Int)value.displacement;
+		}
+		break;
+
+		case Bytecode_Value::STATIC: {
+			auto instruction = bytecode_emit(compiler, BYTECODE_MOVI_8, dst);
+			bytecode_instruction(compiler, instruction)->imm.pointer = value.address;
+		}
+		break;
+
+		NoDefaultCase();
+	}
+
+	return dst;
+}
+
+static void bytecode_store(Bytecode_Compiler *compiler, Bytecode_Value dst, uint32_t src)
+{
+	auto size = dst.type->runtime_size;
+
+	switch (dst.kind)
+	{
+		case Bytecode_Value::FRAME: {
+			bytecode_move(compiler, bytecode_frame_value(src, dst.type), dst.offset);
+		}
+		break;
+
+		case Bytecode_Value::GLOBAL: {
+			auto op = (size == 1) ? BYTECODE_STORE_GLOBAL_1 : ((size == 8) ? BYTECODE_STORE_GLOBAL_8 : BYTECODE_STORE_GLOBAL_N);
+			bytecode_emit(compiler, op, dst.offset, src, size);
+		}
+		break;
+
+		case Bytecode_Value::INDIRECT: {
+			auto op          = (size == 1) ? BYTECODE_STORE_1 : ((size == 8) ? BYTECODE_STORE_8 : BYTECODE_STORE_N);
+			auto instruction = bytecode_emit(compiler, op, dst.offset, src, size);
+			bytecode_instruction(compiler, instruction)->imm.int_value = (Kano_Int)dst.displacement;
+		}
+		break;
+
+		NoDefaultCase();
+	}
+}
+
+//
+//
+//
+
+static Bytecode_Op bytecode_binary_op(Binary_Operator_Kind kind, Code_Type_Kind operand)
+{
+	switch (operand)
+	{
+		case CODE_TYPE_INTEGER: {
+			static const Bytecode_Op ops[] = {
+				BYTECODE_ADD_INT, BYTECODE_SUB_INT, BYTECODE_MUL_INT, BYTECODE_DIV_INT, BYTECODE_MOD_INT,
+				BYTECODE_SHR_INT, BYTECODE_SHL_INT, BYTECODE_AND_INT, BYTECODE_XOR_INT, BYTECODE_OR_INT,
+				BYTECODE_GT_INT, BYTECODE_LT_INT, BYTECODE_GE_INT, BYTECODE_LE_INT, BYTECODE_EQ_INT, BYTECODE_NE_INT };
+			if (kind < ArrayCount(ops)) return ops[kind];
+		}
+		break;
+
+		case CODE_TYPE_CHARACTER: {
+			static const Bytecode_Op ops[] = {
+				BYTECODE_ADD_CHAR, BYTECODE_SUB_CHAR, BYTECODE_MUL_CHAR, BYTECODE_DIV_CHAR, BYTECODE_MOD_CHAR,
+				BYTECODE_SHR_CHAR, BYTECODE_SHL_CHAR, BYTECODE_AND_CHAR, BYTECODE_XOR_CHAR, BYTECODE_OR_CHAR,
+				BYTECODE_GT_CHAR, BYTECODE_LT_CHAR, BYTECODE_GE_CHAR, BYTECODE_LE_CHAR, BYTECODE_EQ_CHAR, BYTECODE_NE_CHAR };
+			if (kind < ArrayCount(ops)) return ops[kind];
+		}
+		break;
+
+		case CODE_TYPE_REAL: {
+			switch (kind)
+			{
+				case BINARY_OPERATOR_ADDITION: return BYTECODE_ADD_REAL;
+				case BINARY_OPERATOR_SUBTRACTION: return BYTECODE_SUB_REAL;
+				case BINARY_OPERATOR_MULTIPLICATION: return BYTECODE_MUL_REAL;
+				case BINARY_OPERATOR_DIVISION: return BYTECODE_DIV_REAL;
+				case BINARY_OPERATOR_RELATIONAL_GREATER: return BYTECODE_GT_REAL;
+				case BINARY_OPERATOR_RELATIONAL_LESS: return BYTECODE_LT_REAL;
+				case BINARY_OPERATOR_RELATIONAL_GREATER_EQUAL: return BYTECODE_GE_REAL;
+				case BINARY_OPERATOR_RELATIONAL_LESS_EQUAL: return BYTECODE_LE_REAL;
+				case BINARY_OPERATOR_COMPARE_EQUAL: return BYTECODE_EQ_REAL;
+				case BINARY_OPERATOR_COMPARE_NOT_EQUAL: return BYTECODE_NE_REAL;
+			}
+		}
+		break;
+
+		case CODE_TYPE_POINTER: {
+			switch (kind)
+			{
+				case BINARY_OPERATOR_ADDITION: return BYTECODE_ADD_POINTER;
+				case BINARY_OPERATOR_SUBTRACTION: return BYTECODE_SUB_POINTER;
+				case BINARY_OPERATOR_RELATIONAL_GREATER: return BYTECODE_GT_POINTER;
+				case BINARY_OPERATOR_RELATIONAL_LESS: return BYTECODE_LT_POINTER;
+				case BINARY_OPERATOR_RELATIONAL_GREATER_EQUAL: return BYTECODE_GE_POINTER;
+				case BINARY_OPERATOR_RELATIONAL_LESS_EQUAL: return BYTECODE_LE_POINTER;
+				case BINARY_OPERATOR_COMPARE_EQUAL: return BYTECODE_EQ_POINTER;
+				case BINARY_OPERATOR_COMPARE_NOT_EQUAL: return BYTECODE_NE_POINTER;
+			}
+		}
+		break;
+
+		case CODE_TYPE_BOOL: {
+			switch (kind)
+			{
+				case BINARY_OPERATOR_COMPARE_EQUAL: return BYTECODE_EQ_BOOL;
+				case BINARY_OPERATOR_COMPARE_NOT_EQUAL: return BYTECODE_NE_BOOL;
+			}
+		}
+		break;
+	}
+
+	Unreachable();
+	return _BYTECODE_OP_COUNT;
+}
+
+static uint32_t bytecode_load_bool(Bytecode_Compiler *compiler, Bytecode_Value value)
+{
+	auto src = bytecode_load(compiler, value);
+
+	Bytecode_Op op;
+	switch (value.type->kind)
+	{
+		case CODE_TYPE_BOOL: return src;
+		case CODE_TYPE_CHARACTER: op = BYTECODE_BOOL_FROM_CHAR; break;
+		case CODE_TYPE_INTEGER: op = BYTECODE_BOOL_FROM_INT; break;
+		case CODE_TYPE_REAL: op = BYTECODE_BOOL_FROM_REAL; break;
+		case CODE_TYPE_POINTER: op = BYTECODE_BOOL_FROM_POINTER; break;
+		NoDefaultCase();
+	}
+
+	auto dst = bytecode_temporary(compiler, sizeof(Kano_Bool), sizeof(Kano_Bool));
+	bytecode_emit(compiler, op, dst, src);
+	return dst;
+}
+
+static uint32_t bytecode_load_index(Bytecode_Compiler *compiler, Bytecode_Value value)
+{
+	auto src = bytecode_load(compiler, value);
+	if (value.type->kind == CODE_TYPE_INTEGER)
+		return src;
+
+	Assert(value.type->kind == CODE_TYPE_CHARACTER);
+	auto dst = bytecode_temporary(compiler, sizeof(Kano_Int), sizeof(Kano_Int));
+	bytecode_emit(compiler, BYTECODE_INT_FROM_CHAR, dst, src);
+	return dst;
+}
+
+static bool bytecode_constant_index(Code_Node *root, Kano_Int *index)
+{
+	while (root->kind == CODE_NODE_EXPRESSION)
+		root = ((Code_Node_Expression *)root)->child;
+
+	if (root->kind != CODE_NODE_LITERAL)
+		return false;
+
+	auto literal = (Code_Node_Literal *)root;
+	if (literal->type->kind == CODE_TYPE_INTEGER)
+		*index = literal->data.integer.value;
+	else if (literal->type->kind == CODE_TYPE_CHARACTER)
+		*index = (Kano_Char)literal->data.integer.value;
+	else
+		return false;
+
+	return true;
+}
+
+//
+//
+//
+
+static Bytecode_Value bytecode_lower_subscript(Bytecode_Compiler *compiler, Code_Node_Address *node)
+{
+	auto subscript  = node->subscript;
+	auto expression = bytecode_lower_expression(compiler, subscript->expression);
+
+	auto element_size = (Kano_Int)subscript->type->runtime_size;
+
+	Kano_Int constant = 0;
+	bool     is_constant = bytecode_constant_index(subscript->subscript, &constant);
+
+	uint32_t index = 0;
+	if (!is_constant)
+		index = bytecode_load_index(compiler, bytecode_lower_expression(compiler, subscript->subscript));
+
+	if (expression.type->kind == CODE_TYPE_STATIC_ARRAY)
+	{
+		if (is_constant)
+			return bytecode_member_value(expression, node->offset + constant * element_size, node->type);
+
+		auto dst = bytecode_temporary(compiler, sizeof(void *), sizeof(void *));
+
+		uint32_t instruction;
+		if (expression.kind == Bytecode_Value::FRAME)
+		{
+			instruction = bytecode_emit(compiler, BYTECODE_INDEX_FRAME, dst, expression.offset, index);
+		}
+		else if (expression.kind == Bytecode_Value::GLOBAL)
+		{
+			instruction = bytecode_emit(compiler, BYTECODE_INDEX_GLOBAL, dst, expression.offset, index);
+		}
+		else
+		{
+			auto base   = bytecode_address_of(compiler, expression);
+			instruction = bytecode_emit(compiler, BYTECODE_INDEX, dst, base, index);
+		}
+		bytecode_instruction(compiler, instruction)->imm.int_value = element_size;
+
+		return bytecode_indirect_value(dst, node->offset, node->type);
+	}
+
+	// Array views and strings both store the data pointer after the 8 byte count
+	Assert(expression.type->kind == CODE_TYPE_ARRAY_VIEW || expression.type->kind == CODE_TYPE_STRUCT);
+
+	static Code_Type_Pointer pointer_type;
+	auto base = bytecode_load(compiler, bytecode_member_value(expression, sizeof(Kano_Int), &pointer_type));
+
+	if (is_constant)
+		return bytecode_indirect_value(base, node->offset + constant * element_size, node->type);
+
+	auto dst         = bytecode_temporary(compiler, sizeof(void *), sizeof(void *));
+	auto instruction = bytecode_emit(compiler, BYTECODE_INDEX, dst, base, index);
+	bytecode_instruction(compiler, instruction)->imm.int_value = element_size;
+
+	return bytecode_indirect_value(dst, node->offset, node->type);
+}
+
+// Applies the collapsed static array subscripts of an address on top of its base, constant indices
+// only move the displacement and the others become one index instruction each
+static Bytecode_Value bytecode_lower_strides(Bytecode_Compiler *compiler, Code_Node_Address *node, Bytecode_Value value)
+{
+	for (int64_t index = 0; index < node->index_count; ++index)
+	{
+		auto stride = (Kano_Int)node->indices[index].stride;
+
+		Kano_Int constant = 0;
+		if (bytecode_constant_index(node->indices[index].expression, &constant))
+		{
+			value = bytecode_member_value(value, constant * stride, node->type);
+			continue;
+		}
+
+		auto subscript = bytecode_load_index(compiler, bytecode_lower_expression(compiler, node->indices[index].expression));
+		auto dst       = bytecode_temporary(compiler, sizeof(void *), sizeof(void *));
+
+		uint64_t displacement = 0;
+		uint32_t instruction;
+		if (value.kind == Bytecode_Value::FRAME)
+		{
+			instruction = bytecode_emit(compiler, BYTECODE_INDEX_FRAME, dst, value.offset, subscript);
+		}
+		else if (value.kind == Bytecode_Value::GLOBAL)
+		{
+			instruction = bytecode_emit(compiler, BYTECODE_INDEX_GLOBAL, dst, value.offset, subscript);
+		}
+		else if (value.kind == Bytecode_Value::INDIRECT)
+		{
+			instruction  = bytecode_emit(compiler, BYTECODE_INDEX, dst, value.offset, subscript);
+			displacement = value.displacement;
+		}
+		else
+		{
+			auto base   = bytecode_address_of(compiler, value);
+			instruction = bytecode_emit(compiler, BYTECODE_INDEX, dst, base, subscript);
+		}
+		bytecode_instruction(compiler, instruction)->imm.int_value = stride;
+
+		value = bytecode_indirect_value(dst, displacement, node->type);
+	}
+
+	return value;
+}
+
+static Bytecode_Value bytecode_lower_address(Bytecode_Compiler *compiler, Code_Node_Address *node)
+{
+	if (node->subscript)
+	{
+		Assert(node->address == nullptr);
+		return bytecode_lower_strides(compiler, node, bytecode_lower_subscript(compiler, node));
+	}
+
+	if (!node->address)
+	{
+		return bytecode_lower_strides(compiler, node, bytecode_frame_value((uint32_t)node->offset, node->type));
+	}
+
+	auto address = node->address;
+
+	switch (address->kind)
+	{
+		case Symbol_Address::STACK: {
+			auto value = bytecode_frame_value((uint32_t)(address->offset + node->offset), node->type);
+			return bytecode_lower_strides(compiler, node, value);
+		}
+
+		case Symbol_Address::GLOBAL: {
+			Bytecode_Value value;
+			value.kind   = Bytecode_Value::GLOBAL;
+			value.offset = (uint32_t)(address->offset + node->offset);
+			value.type   = node->type;
+			return bytecode_lower_strides(compiler, node, value);
+		}
+
+		case Symbol_Address::CODE: {
+			bytecode_procedure_for(compiler, address->code, (Code_Type_Procedure *)node->type);
+
+			auto procedure   = new Code_Value_Procedure;
+			procedure->block = address->code;
+			procedure->ccall = nullptr;
+			return bytecode_static_value(procedure, node->type);
+		}
+
+		case Symbol_Address::CCALL: {
+			auto procedure   = new Code_Value_Procedure;
+			procedure->block = nullptr;
+			procedure->ccall = address->ccall;
+			return bytecode_static_value(procedure, node->type);
+		}
+
+		NoDefaultCase();
+	}
+
+	Unreachable();
+	return Bytecode_Value{};
+}
+
+static Bytecode_Value bytecode_lower_type_cast(Bytecode_Compiler *compiler, Code_Node_Type_Cast *cast, int64_t dst)
+{
+	auto value = bytecode_lower_expression(compiler, cast->child);
+
+	auto from = value.type->kind;
+	auto to   = cast->type->kind;
+
+	if (from == to && to != CODE_TYPE_ARRAY_VIEW)
+	{
+		value.type = cast->type;
+		return value;
+	}
+
+	if (to == CODE_TYPE_ARRAY_VIEW)
+	{
+		Assert(from == CODE_TYPE_STATIC_ARRAY);
+
+		auto data        = bytecode_address_of(compiler, value);
+		auto result      = bytecode_result(compiler, cast->type, dst);
+		auto instruction = bytecode_emit(compiler, BYTECODE_MAKE_ARRAY_VIEW, result, data);
+		bytecode_instruction(compiler, instruction)->imm.int_value = ((Code_Type_Static_Array *)value.type)->element_count;
+		return bytecode_frame_value(result, cast->type);
+	}
+
+	Bytecode_Op op = _BYTECODE_OP_COUNT;
+
+	switch (to)
+	{
+		case CODE_TYPE_REAL: {
+			if (from == CODE_TYPE_INTEGER) op = BYTECODE_REAL_FROM_INT;
+			else if (from == CODE_TYPE_CHARACTER) op = BYTECODE_REAL_FROM_CHAR;
+			else if (from == CODE_TYPE_BOOL) op = BYTECODE_REAL_FROM_BOOL;
+		}
+		break;
+
+		case CODE_TYPE_INTEGER: {
+			if (from == CODE_TYPE_BOOL) op = BYTECODE_INT_FROM_BOOL;
+			else if (from == CODE_TYPE_CHARACTER) op = BYTECODE_INT_FROM_CHAR;
+			else if (from == CODE_TYPE_REAL) op = BYTECODE_INT_FROM_REAL;
+		}
+		break;
+
+		case CODE_TYPE_BOOL: {
+			auto src = bytecode_load_bool(compiler, value);
+			if (dst >= 0)
+			{
+				bytecode_move(compiler, bytecode_frame_value(src, cast->type), (uint32_t)dst);
+				return bytecode_frame_value((uint32_t)dst, cast->type);
+			}
+			return bytecode_frame_value(src, cast->type);
+		}
+		break;
+
+		case CODE_TYPE_CHARACTER: {
+			if (from == CODE_TYPE_BOOL) op = BYTECODE_CHAR_FROM_BOOL;
+			else if (from == CODE_TYPE_INTEGER) op = BYTECODE_CHAR_FROM_INT;
+			else if (from == CODE_TYPE_REAL) op = BYTECODE_CHAR_FROM_REAL;
+		}
+		break;
+	}
+
+	Assert(op != _BYTECODE_OP_COUNT);
+
+	auto src    = bytecode_load(compiler, value);
+	auto result = bytecode_result(compiler, cast->type, dst);
+	bytecode_emit(compiler, op, result, src);
+	return bytecode_frame_value(result, cast->type);
+}
+
+static Bytecode_Value bytecode_lower_unary_operator(Bytecode_Compiler *compiler, Code_Node_Unary_Operator *node, int64_t dst)
+{
+	switch (node->op_kind)
+	{
+		case UNARY_OPERATOR_PLUS: {
+			return bytecode_lower_expression(compiler, node->child, dst);
+		}
+
+		case UNARY_OPERATOR_MINUS:
+		case UNARY_OPERATOR_BITWISE_NOT:
+		case UNARY_OPERATOR_LOGICAL_NOT: {
+			auto value = bytecode_lower_expression(compiler, node->child);
+
+			Bytecode_Op op = _BYTECODE_OP_COUNT;
+			auto        kind = value.type->kind;
+
+			if (node->op_kind == UNARY_OPERATOR_MINUS)
+				op = (kind == CODE_TYPE_INTEGER) ? BYTECODE_NEG_INT : ((kind == CODE_TYPE_REAL) ? BYTECODE_NEG_REAL : BYTECODE_NEG_CHAR);
+			else if (node->op_kind == UNARY_OPERATOR_BITWISE_NOT)
+				op = (kind == CODE_TYPE_INTEGER) ? BYTECODE_NOT_INT : BYTECODE_NOT_CHAR;
+			else
+				op = BYTECODE_NOT_BOOL;
+
+			auto src    = (op == BYTECODE_NOT_BOOL) ? bytecode_load_bool(compiler, value) : bytecode_load(compiler, value);
+			auto result = bytecode_result(compiler, node->type, dst);
+			bytecode_emit(compiler, op, result, src);
+			return bytecode_frame_value(result, node->type);
+		}
+
+		case UNARY_OPERATOR_DEREFERENCE: {
+			auto pointer = bytecode_load(compiler, bytecode_lower_expression(compiler, node->child));
+			return bytecode_indirect_value(pointer, 0, node->type);
+		}
+
+		case UNARY_OPERATOR_POINTER_TO: {
+			auto value   = bytecode_lower_expression(compiler, node->child);
+			auto pointer = bytecode_address_of(compiler, value);
+			return bytecode_frame_value(pointer, node->type);
+		}
+
+		NoDefaultCase();
+	}
+
+	Unreachable();
+	return Bytecode_Value{};
+}
+
+static void bytecode_lower_branch(Bytecode_Compiler *compiler, Code_Node *root, bool when, Array<uint32_t> *jumps);
+
+static Bytecode_Value bytecode_lower_binary_operator(Bytecode_Compiler *compiler, Code_Node_Binary_Operator *node, int64_t dst)
+{
+	auto op_kind = node->op_kind;
+
+	if (op_kind == BINARY_OPERATOR_LOGICAL_AND || op_kind == BINARY_OPERATOR_LOGICAL_OR)
+	{
+		auto result = bytecode_result(compiler, node->type, dst);
+
+		Array<uint32_t> jumps;
+		bytecode_lower_branch(compiler, node, false, &jumps);
+
+		bytecode_instruction(compiler, bytecode_emit(compiler, BYTECODE_MOVI_1, result))->imm.int_value = 1;
+		auto jump_end = bytecode_emit(compiler, BYTECODE_JUMP);
+
+		auto false_label = bytecode_label(compiler);
+		for (auto jump : jumps)
+			bytecode_bind(compiler, jump, false_label);
+		bytecode_instruction(compiler, bytecode_emit(compiler, BYTECODE_MOVI_1, result))->imm.int_value = 0;
+		bytecode_bind(compiler, jump_end, bytecode_label(compiler));
+
+		Free(&jumps);
+		return bytecode_frame_value(result, node->type);
+	}
+
+	// @Note: Same order as the tree walker, right operand is evaluated before the left operand
+	auto right = bytecode_lower_expression(compiler, node->right);
+	if (bytecode_has_side_effects(node->left))
+		right = bytecode_snapshot(compiler, right);
+
+	auto left = bytecode_lower_expression(compiler, node->left);
+
+	if (op_kind >= BINARY_OPERATOR_COMPOUND_ADDITION && op_kind <= BINARY_OPERATOR_COMPOUND_BITWISE_OR)
+	{
+		auto kind = (Binary_Operator_Kind)(op_kind - BINARY_OPERATOR_COMPOUND_ADDITION + BINARY_OPERATOR_ADDITION);
+		auto op   = bytecode_binary_op(kind, left.type->kind);
+		auto src  = bytecode_load(compiler, right);
+
+		if (left.kind == Bytecode_Value::FRAME)
+		{
+			bytecode_emit(compiler, op, left.offset, left.offset, src);
+		}
+		else
+		{
+			auto value = bytecode_temporary(compiler, left.type);
+			bytecode_load_into(compiler, left, value);
+			bytecode_emit(compiler, op, value, value, src);
+			bytecode_store(compiler, left, value);
+		}
+
+		left.type = node->type;
+		return left;
+	}
+
+	auto op     = bytecode_binary_op(op_kind, left.type->kind);
+	auto a      = bytecode_load(compiler, left);
+	auto b      = bytecode_load(compiler, right);
+	auto result = bytecode_result(compiler, node->type, dst);
+	bytecode_emit(compiler, op, result, a, b);
+	return bytecode_frame_value(result, node->type);
+}
+
+static Bytecode_Value bytecode_lower_assignment(Bytecode_Compiler *compiler, Code_Node_Assignment *node)
+{
+	auto destination = node->destination->child;
+
+	// Plain locals are written in place, computing the value straight into the variable
+	if (destination->kind == CODE_NODE_ADDRESS)
+	{
+		auto address = (Code_Node_Address *)destination;
+		if (!address->subscript && !address->index_count && address->address && address->address->kind == Symbol_Address::STACK)
+		{
+			auto dst   = bytecode_lower_address(compiler, address);
+			auto value = bytecode_lower_expression(compiler, node->value, dst.offset);
+			bytecode_move(compiler, value, dst.offset);
+			return dst;
+		}
+	}
+
+	auto value = bytecode_lower_expression(compiler, node->value);
+	if (bytecode_has_side_effects(destination))
+		value = bytecode_snapshot(compiler, value);
+
+	auto dst = bytecode_lower_expression(compiler, node->destination);
+
+	if (dst.kind == Bytecode_Value::FRAME)
+	{
+		bytecode_move(compiler, value, dst.offset);
+	}
+	else
+	{
+		auto src = bytecode_load(compiler, value);
+		bytecode_store(compiler, dst, src);
+	}
+
+	return dst;
+}
+
+static Bytecode_Value bytecode_lower_procedure_call(Bytecode_Compiler *compiler, Code_Node_Procedure_Call *root, int64_t dst, bool tail = false)
+{
+	struct Argument
+	{
+		Code_Node_Expression *expression;
+		Bytecode_Value        value;
+	};
+
+	// @Note: Callee frame layout is the same as the tree walker's, variadics are packed unaligned
+	// at the start of the callee area as [Code_Type *][value] pairs and the frame starts after them
+	auto frame_offset = (uint32_t)AlignPower2Up(root->variadics_size, sizeof(int64_t));
+
+	auto procedure_node = root->procedure->child;
+
+	auto call  = new Bytecode_Call;
+	call->type = root->procedure_type;
+
+	Bytecode_Op call_op = BYTECODE_CALL_INDIRECT;
+
+	if (root->callee)
+	{
+		if (root->callee->kind == Symbol_Address::CODE)
+		{
+			call->procedure = bytecode_procedure_for(compiler, root->callee->code, root->procedure_type);
+			call_op         = BYTECODE_CALL;
+		}
+		else if (root->callee->kind == Symbol_Address::CCALL)
+		{
+			call->ccall = root->callee->ccall;
+			call_op     = BYTECODE_CCALL;
+		}
+	}
+	else if (procedure_node->kind == CODE_NODE_LITERAL)
+	{
+		auto literal = (Code_Node_Literal *)procedure_node;
+		if (literal->data.procedure.block)
+		{
+			call->procedure = bytecode_procedure_for(compiler, literal->data.procedure.block, root->procedure_type);
+			call_op         = BYTECODE_CALL;
+		}
+	}
+
+	bool va_pointer = root->variadic_count != 0;
+
+	// Evaluation order follows the tree walker: variadics, parameters, then the procedure
+	int64_t          parameter_count = va_pointer ? root->parameter_count - 1 : root->parameter_count;
+	int64_t          argument_count  = root->variadic_count + parameter_count + (call_op == BYTECODE_CALL_INDIRECT ? 1 : 0);
+	Array<Argument>  arguments;
+	arguments.Resize(argument_count);
+
+	{
+		int64_t index = 0;
+		for (int64_t variadic = 0; variadic < root->variadic_count; ++variadic)
+			arguments[index++].expression = root->variadics[variadic];
+		for (int64_t parameter = 0; parameter < parameter_count; ++parameter)
+			arguments[index++].expression = root->parameters[parameter];
+		if (call_op == BYTECODE_CALL_INDIRECT)
+			arguments[index++].expression = root->procedure;
+		Assert(index == argument_count);
+	}
+
+	for (int64_t index = 0; index < argument_count; ++index)
+	{
+		auto argument   = &arguments[index];
+		argument->value = bytecode_lower_expression(compiler, argument->expression);
+
+		for (int64_t next = index + 1; next < argument_count; ++next)
+		{
+			if (bytecode_has_side_effects(arguments[next].expression))
+			{
+				argument->value = bytecode_snapshot(compiler, argument->value);
+				break;
+			}
+		}
+	}
+
+	{
+		uint32_t offset = 0;
+		for (int64_t index = 0; index < root->variadic_count; ++index)
+		{
+			auto variadic = &arguments[index];
+			auto type     = root->variadics[index]->type;
+
+			auto instruction = bytecode_emit(compiler, BYTECODE_MOVI_8, offset);
+			bytecode_instruction(compiler, instruction)->imm.pointer = (uint8_t *)type;
+			bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_A);
+			offset += sizeof(Code_Type *);
+
+			instruction = bytecode_load_into(compiler, variadic->value, offset);
+			bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_A);
+			offset += type->runtime_size;
+		}
+	}
+
+	{
+		for (int64_t index = 0; index < root->parameter_count; ++index)
+		{
+			auto slot = frame_offset + (uint32_t)root->parameter_offsets[index];
+
+			if (index < parameter_count)
+			{
+				auto instruction = bytecode_load_into(compiler, arguments[root->variadic_count + index].value, slot);
+				bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_A);
+			}
+			else
+			{
+				auto instruction = bytecode_emit(compiler, BYTECODE_ADDRESS_FRAME, slot);
+				bytecode_instruction(compiler, instruction)->imm.int_value = 0;
+				bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_A);
+				bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_IMM);
+			}
+		}
+	}
+
+	if (tail)
+	{
+		Assert(call_op == BYTECODE_CALL && !root->variadic_count);
+
+		uint32_t begin = 0, size = 0;
+		if (root->parameter_count)
+		{
+			auto last = root->parameter_count - 1;
+			begin     = (uint32_t)root->parameter_offsets[0];
+			size      = (uint32_t)(root->parameter_offsets[last] + root->parameters[last]->type->runtime_size) - begin;
+		}
+
+		call->caller = compiler->procedure->block;
+
+		auto instruction = bytecode_emit(compiler, BYTECODE_TAIL_CALL, frame_offset, begin, size);
+		bytecode_instruction(compiler, instruction)->imm.call = call;
+		bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_A);
+
+		return Bytecode_Value{};
+	}
+
+	uint32_t procedure_slot = 0;
+	if (call_op == BYTECODE_CALL_INDIRECT)
+		procedure_slot = bytecode_load(compiler, arguments[argument_count - 1].value);
+
+	auto instruction = bytecode_emit(compiler, call_op, frame_offset, procedure_slot);
+	bytecode_instruction(compiler, instruction)->imm.call = call;
+	bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_A);
+
+	if (!root->type)
+		return Bytecode_Value{};
+
+	// @Note: The tree walker runs the callee at the frame offset of the call, so a local of the caller that
+	// lives there already holds the result when procedure_return is traced. Traced returns copy it there
+	// too, the local is dead during the call and the temporaries start after the locals
+	if ((compiler->program->policy & INTERCEPT_POLICY_PROCEDURE) && call_op != BYTECODE_CCALL &&
+		root->frame_offset + root->type->runtime_size <= compiler->locals_size)
+	{
+		call->result_offset = (uint32_t)root->frame_offset;
+		call->result_size   = root->type->runtime_size;
+	}
+
+	auto result = bytecode_result(compiler, root->type, dst);
+	instruction = bytecode_load_into(compiler, bytecode_frame_value(frame_offset, root->type), result);
+	bytecode_patch_frame(compiler, instruction, BYTECODE_FIELD_B);
+
+	return bytecode_frame_value(result, root->type);
+}
+
+static Bytecode_Value bytecode_lower_expression(Bytecode_Compiler *compiler, Code_Node *root, int64_t dst)
+{
+	switch (root->kind)
+	{
+		case CODE_NODE_EXPRESSION: {
+			return bytecode_lower_expression(compiler, ((Code_Node_Expression *)root)->child, dst);
+		}
+
+		case CODE_NODE_LITERAL: {
+			auto literal = (Code_Node_Literal *)root;
+			if (literal->type->kind == CODE_TYPE_PROCEDURE && literal->data.procedure.block)
+				bytecode_procedure_for(compiler, literal->data.procedure.block, (Code_Type_Procedure *)literal->type);
+			return bytecode_static_value(&literal->data, literal->type);
+		}
+
+		case CODE_NODE_ADDRESS: return bytecode_lower_address(compiler, (Code_Node_Address *)root);
+
+		case CODE_NODE_OFFSET: {
+			auto node  = (Code_Node_Offset *)root;
+			auto value = bytecode_lower_expression(compiler, node->expression);
+			return bytecode_member_value(value, node->offset, node->type);
+		}
+
+		case CODE_NODE_TYPE_CAST: return bytecode_lower_type_cast(compiler, (Code_Node_Type_Cast *)root, dst);
+		case CODE_NODE_UNARY_OPERATOR: return bytecode_lower_unary_operator(compiler, (Code_Node_Unary_Operator *)root, dst);
+		case CODE_NODE_BINARY_OPERATOR: return bytecode_lower_binary_operator(compiler, (Code_Node_Binary_Operator *)root, dst);
+		case CODE_NODE_ASSIGNMENT: return bytecode_lower_assignment(compiler, (Code_Node_Assignment *)root);
+		case CODE_NODE_PROCEDURE_CALL: return bytecode_lower_procedure_call(compiler, (Code_Node_Procedure_Call *)root, dst);
+
+		case CODE_NODE_RETURN: {
+			auto node = (Code_Node_Return *)root;
+			// The traced runs keep every frame, the procedure intercepts report the callstack
+			if (node->tail_call && !(compiler->program->policy & INTERCEPT_POLICY_PROCEDURE))
+			{
+				bytecode_lower_procedure_call(compiler, node->tail_call, -1, true);
+				return Bytecode_Value{};
+			}
+			if (node->expression)
+			{
+				auto value = bytecode_lower_expression(compiler, node->expression, 0);
+				bytecode_move(compiler, value, 0);
+			}
+			auto instruction = bytecode_emit(compiler, BYTECODE_RETURN);
+			bytecode_instruction(compiler, instruction)->imm.block = compiler->procedure->block;
+			return Bytecode_Value{};
+		}
+
+		case CODE_NODE_BREAK: {
+			Assert(compiler->loops.count);
+			compiler->loops.Last()->breaks.Add(bytecode_emit(compiler, BYTECODE_JUMP));
+			return Bytecode_Value{};
+		}
+
+		case CODE_NODE_CONTINUE: {
+			Assert(compiler->loops.count);
+			compiler->loops.Last()->continues.Add(bytecode_emit(compiler, BYTECODE_JUMP));
+			return Bytecode_Value{};
+		}
+
+		NoDefaultCase();
+	}
+
+	Unreachable();
+	return Bytecode_Value{};
+}
+
+//
+//
+//
+
+static void bytecode_lower_statement(Bytecode_Compiler *compiler, Code_Node_Statement *root);
+
+static void bytecode_begin_statement(Bytecode_Compiler *compiler, Code_Node_Statement *root)
+{
+	compiler->temporary_top = compiler->locals_size;
+
+	if (compiler->program->policy & INTERCEPT_POLICY_STATEMENT)
+	{
+		auto instruction = bytecode_emit(compiler, BYTECODE_STATEMENT);
+		bytecode_instruction(compiler, instruction)->imm.statement = root;
+	}
+}
+
+// Emits jumps that are taken when the condition evaluates to 'when' and falls through otherwise,
+// the jumps are added to 'jumps' and bound by the caller. && and || are lowered into control flow,
+// so the right operand is only evaluated when the left operand does not decide the result
+static void bytecode_lower_branch(Bytecode_Compiler *compiler, Code_Node *root, bool when, Array<uint32_t> *jumps)
+{
+	if (root->kind == CODE_NODE_EXPRESSION)
+	{
+		bytecode_lower_branch(compiler, ((Code_Node_Expression *)root)->child, when, jumps);
+		return;
+	}
+
+	if (root->kind == CODE_NODE_UNARY_OPERATOR && ((Code_Node_Unary_Operator *)root)->op_kind == UNARY_OPERATOR_LOGICAL_NOT)
+	{
+		bytecode_lower_branch(compiler, ((Code_Node_Unary_Operator *)root)->child, !when, jumps);
+		return;
+	}
+
+	if (root->kind == CODE_NODE_BINARY_OPERATOR)
+	{
+		auto node = (Code_Node_Binary_Operator *)root;
+		if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND || node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
+		{
+			bool is_and = (node->op_kind == BINARY_OPERATOR_LOGICAL_AND);
+
+			if (when != is_and)
+			{
+				// Either operand alone decides the result: false for &&, true for ||
+				bytecode_lower_branch(compiler, node->left, when, jumps);
+				bytecode_lower_branch(compiler, node->right, when, jumps);
+			}
+			else
+			{
+				Array<uint32_t> skip;
+				bytecode_lower_branch(compiler, node->left, !when, &skip);
+				bytecode_lower_branch(compiler, node->right, when, jumps);
+
+				auto label = bytecode_label(compiler);
+				for (auto jump : skip)
+					bytecode_bind(compiler, jump, label);
+				Free(&skip);
+			}
+			return;
+		}
+	}
+
+	auto condition = bytecode_load_bool(compiler, bytecode_lower_expression(compiler, root));
+	jumps->Add(bytecode_emit(compiler, when ? BYTECODE_JUMP_IF_TRUE : BYTECODE_JUMP_IF_FALSE, condition));
+}
+
+static void bytecode_lower_condition(Bytecode_Compiler *compiler, Code_Node_Statement *root, bool when, Array<uint32_t> *jumps)
+{
+	bytecode_begin_statement(compiler, root);
+	bytecode_lower_branch(compiler, root->node, when, jumps);
+}
+
+static void bytecode_bind_all(Bytecode_Compiler *compiler, Array<uint32_t> *jumps, uint32_t target)
+{
+	for (auto jump : *jumps)
+		bytecode_bind(compiler, jump, target);
+	Free(jumps);
+}
+
+static void bytecode_end_loop(Bytecode_Compiler *compiler, uint32_t continue_target, uint32_t break_target)
+{
+	auto loop = compiler->loops.Last();
+	for (auto jump : loop->continues)
+		bytecode_bind(compiler, jump, continue_target);
+	for (auto jump : loop->breaks)
+		bytecode_bind(compiler, jump, break_target);
+	compiler->loops.RemoveLast();
+	delete loop;
+}
+
+static void bytecode_lower_block(Bytecode_Compiler *compiler, Code_Node_Block *root)
+{
+	for (auto statement = root->statement_head; statement; statement = statement->next)
+		bytecode_lower_statement(compiler, statement);
+}
+
+static void bytecode_lower_if(Bytecode_Compiler *compiler, Code_Node_If *root)
+{
+	Array<uint32_t> jumps_false;
+	bytecode_lower_branch(compiler, root->condition, false, &jumps_false);
+
+	bytecode_lower_statement(compiler, root->true_statement);
+
+	if (root->false_statement)
+	{
+		auto jump_end = bytecode_emit(compiler, BYTECODE_JUMP);
+		bytecode_bind_all(compiler, &jumps_false, bytecode_label(compiler));
+		bytecode_lower_statement(compiler, root->false_statement);
+		bytecode_bind(compiler, jump_end, bytecode_label(compiler));
+	}
+	else
+	{
+		bytecode_bind_all(compiler, &jumps_false, bytecode_label(compiler));
+	}
+}
+
+static void bytecode_lower_for(Bytecode_Compiler *compiler, Code_Node_For *root)
+{
+	bytecode_lower_statement(compiler, root->initialization);
+
+	Array<uint32_t> jumps_end;
+	auto condition_label = bytecode_label(compiler);
+	bytecode_lower_condition(compiler, root->condition, false, &jumps_end);
+
+	compiler->loops.Add(new Bytecode_Loop);
+	bytecode_lower_statement(compiler, root->body);
+
+	auto increment_label = bytecode_label(compiler);
+	bytecode_lower_statement(compiler, root->increment);
+	bytecode_bind(compiler, bytecode_emit(compiler, BYTECODE_JUMP), condition_label);
+
+	auto end_label = bytecode_label(compiler);
+	bytecode_bind_all(compiler, &jumps_end, end_label);
+	bytecode_end_loop(compiler, increment_label, end_label);
+}
+
+static void bytecode_lower_while(Bytecode_Compiler *compiler, Code_Node_While *root)
+{
+	Array<uint32_t> jumps_end;
+	auto condition_label = bytecode_label(compiler);
+	bytecode_lower_condition(compiler, root->condition, false, &jumps_end);
+
+	compiler->loops.Add(new Bytecode_Loop);
+	bytecode_lower_statement(compiler, root->body);
+	bytecode_bind(compiler, bytecode_emit(compiler, BYTECODE_JUMP), condition_label);
+
+	auto end_label = bytecode_label(compiler);
+	bytecode_bind_all(compiler, &jumps_end, end_label);
+	bytecode_end_loop(compiler, condition_label, end_label);
+}
+
+static void bytecode_lower_do(Bytecode_Compiler *compiler, Code_Node_Do *root)
+{
+	auto body_label = bytecode_label(compiler);
+
+	compiler->loops.Add(new Bytecode_Loop);
+	bytecode_lower_statement(compiler, root->body);
+
+	Array<uint32_t> jumps_body;
+	auto condition_label = bytecode_label(compiler);
+	bytecode_lower_condition(compiler, root->condition, true, &jumps_body);
+	bytecode_bind_all(compiler, &jumps_body, body_label);
+
+	bytecode_end_loop(compiler, condition_label, bytecode_label(compiler));
+}
+
+static void bytecode_lower_statement(Bytecode_Compiler *compiler, Code_Node_Statement *root)
+{
+	Assert(root->symbol_table);
+
+	bytecode_begin_statement(compiler, root);
+
+	switch (root->node->kind)
+	{
+		case CODE_NODE_EXPRESSION: bytecode_lower_expression(compiler, root->node); break;
+		case CODE_NODE_ASSIGNMENT: bytecode_lower_assignment(compiler, (Code_Node_Assignment *)root->node); break;
+		case CODE_NODE_BLOCK: bytecode_lower_block(compiler, (Code_Node_Block *)root->node); break;
+		case CODE_NODE_IF: bytecode_lower_if(compiler, (Code_Node_If *)root->node); break;
+		case CODE_NODE_FOR: bytecode_lower_for(compiler, (Code_Node_For *)root->node); break;
+		case CODE_NODE_WHILE: bytecode_lower_while(compiler, (Code_Node_While *)root->node); break;
+		case CODE_NODE_DO: bytecode_lower_do(compiler, (Code_Node_Do *)root->node); break;
+		NoDefaultCase();
+	}
+}
+
+//
+//
+//
+
+static uint32_t bytecode_symbols_extent(Symbol_Table *symbols, uint32_t extent)
+{
+	for (auto &pair : symbols->map)
+	{
+		auto symbol = pair.value;
+		if ((symbol->flags & SYMBOL_BIT_TYPE) || symbol->address.kind != Symbol_Address::STACK)
+			continue;
+		extent = Maximum(extent, (uint32_t)(symbol->address.offset + symbol->type->runtime_size));
+	}
+	return extent;
+}
+
+static uint32_t bytecode_statement_extent(Code_Node_Statement *root, uint32_t extent)
+{
+	if (!root)
+		return extent;
+
+	switch (root->node->kind)
+	{
+		case CODE_NODE_BLOCK: {
+			auto block = (Code_Node_Block *)root->node;
+			extent     = bytecode_symbols_extent(&block->symbols, extent);
+			for (auto statement = block->statement_head; statement; statement = statement->next)
+				extent = bytecode_statement_extent(statement, extent);
+		}
+		break;
+
+		case CODE_NODE_IF: {
+			auto node = (Code_Node_If *)root->node;
+			extent    = bytecode_statement_extent(node->true_statement, extent);
+			extent    = bytecode_statement_extent(node->false_statement, extent);
+		}
+		break;
+
+		case CODE_NODE_FOR: {
+			auto node = (Code_Node_For *)root->node;
+			extent    = bytecode_symbols_extent(&node->symbols, extent);
+			extent    = bytecode_statement_extent(node->initialization, extent);
+			extent    = bytecode_statement_extent(node->body, extent);
+		}
+		break;
+
+		case CODE_NODE_WHILE: extent = bytecode_statement_extent(((Code_Node_While *)root->node)->body, extent); break;
+		case CODE_NODE_DO: extent = bytecode_statement_extent(((Code_Node_Do *)root->node)->body, extent); break;
+	}
+
+	return extent;
+}
+
+static void bytecode_begin_procedure(Bytecode_Compiler *compiler, Bytecode_Procedure *procedure, uint32_t locals_size)
+{
+	compiler->procedure     = procedure;
+	compiler->locals_size   = (uint32_t)AlignPower2Up(locals_size, sizeof(int64_t));
+	compiler->temporary_top = compiler->locals_size;
+	compiler->temporary_max = compiler->locals_size;
+	compiler->patches.Reset();
+}
+
+static void bytecode_end_procedure(Bytecode_Compiler *compiler)
+{
+	auto procedure = compiler->procedure;
+
+	auto frame_size       = (uint32_t)AlignPower2Up(Maximum(compiler->locals_size, compiler->temporary_max), sizeof(int64_t));
+	procedure->frame_size = frame_size;
+
+	for (auto &patch : compiler->patches)
+	{
+		auto instruction = &procedure->code[patch.instruction];
+		switch (patch.field)
+		{
+			case BYTECODE_FIELD_A: instruction->a += frame_size; break;
+			case BYTECODE_FIELD_B: instruction->b += frame_size; break;
+			case BYTECODE_FIELD_IMM: instruction->imm.int_value += frame_size; break;
+			NoDefaultCase();
+		}
+	}
+
+	procedure->code.Pack();
+
+	for (auto &instruction : procedure->code)
+	{
+		if (instruction.op == BYTECODE_JUMP || instruction.op == BYTECODE_JUMP_IF_FALSE || instruction.op == BYTECODE_JUMP_IF_TRUE)
+			instruction.imm.target = procedure->code.data + instruction.imm.int_value;
+	}
+}
+
+static void bytecode_compile_procedure(Bytecode_Compiler *compiler, Bytecode_Procedure *procedure)
+{
+	auto block = procedure->block;
+
+	uint32_t extent = 0;
+	if (procedure->type && procedure->type->return_type)
+		extent = procedure->type->return_type->runtime_size;
+
+	if (block->symbols.parent)
+		extent = bytecode_symbols_extent(block->symbols.parent, extent);
+	extent = bytecode_symbols_extent(&block->symbols, extent);
+	for (auto statement = block->statement_head; statement; statement = statement->next)
+		extent = bytecode_statement_extent(statement, extent);
+
+	bytecode_begin_procedure(compiler, procedure, extent);
+
+	bytecode_lower_block(compiler, block);
+
+	auto instruction = bytecode_emit(compiler, BYTECODE_RETURN);
+	bytecode_instruction(compiler, instruction)->imm.block = block;
+
+	bytecode_end_procedure(compiler);
+}
+
+Bytecode_Program *bytecode_compile(Interpreter *interp, Array_View<Code_Node_Assignment *> globals, Code_Node_Procedure_Call *entry, Intercept_Policy policy)
+{
+	auto program    = new Bytecode_Program;
+	program->policy = policy;
+
+	Bytecode_Compiler compiler;
+	compiler.interp  = interp;
+	compiler.program = program;
+
+	program->globals = new Bytecode_Procedure;
+	bytecode_begin_procedure(&compiler, program->globals, 0);
+	for (auto assignment : globals)
+	{
+		compiler.temporary_top = compiler.locals_size;
+		bytecode_lower_assignment(&compiler, assignment);
+	}
+	bytecode_emit(&compiler, BYTECODE_HALT);
+	bytecode_end_procedure(&compiler);
+
+	program->entry = new Bytecode_Procedure;
+	bytecode_begin_procedure(&compiler, program->entry, 0);
+	if (entry)
+		bytecode_lower_procedure_call(&compiler, entry, -1);
+	bytecode_emit(&compiler, BYTECODE_HALT);
+	bytecode_end_procedure(&compiler);
+
+	while (compiler.pending.count)
+	{
+		auto procedure = compiler.pending.Last();
+		compiler.pending.RemoveLast();
+		bytecode_compile_procedure(&compiler, procedure);
+	}
+
+	return program;
+}
+
+//
+//
+//
+
+struct Bytecode_Frame
+{
+	Bytecode_Instruction *pc;
+	uint8_t *             fp;
+	Code_Type_Procedure * procedure;
+};
+
+#define BytecodeValue(type, offset) (*(type *)(fp + (offset)))
+#define BytecodeGlobal(type, offset) (*(type *)(global + (offset)))
+
+#define BytecodeBinary(op, type, result, expr) \
+	case op: BytecodeValue(result, pc->a) = (result)(BytecodeValue(type, pc->b) expr BytecodeValue(type, pc->c)); break
+#define BytecodeUnary(op, type, result, expr) \
+	case op: BytecodeValue(result, pc->a) = (result)(expr BytecodeValue(type, pc->b)); break
+#define BytecodeConvert(op, from, to) \
+	case op: BytecodeValue(to, pc->a) = (to)BytecodeValue(from, pc->b); break
+
+template <Intercept_Policy Policy>
+static void bytecode_run(Interpreter *interp, Bytecode_Program *program, Bytecode_Procedure *chunk)
+{
+	uint8_t *stack  = interp->stack;
+	uint8_t *global = interp->global;
+	uint8_t *fp     = stack + interp->stack_top;
+
+	Array<Bytecode_Frame> frames;
+
+	Bytecode_Instruction *pc = chunk->code.data;
+
+	while (true)
+	{
+		switch (pc->op)
+		{
+			case BYTECODE_MOV_1: BytecodeValue(uint8_t, pc->a) = BytecodeValue(uint8_t, pc->b); break;
+			case BYTECODE_MOV_8: BytecodeValue(uint64_t, pc->a) = BytecodeValue(uint64_t, pc->b); break;
+			case BYTECODE_MOV_N: memmove(fp + pc->a, fp + pc->b, pc->c); break;
+			case BYTECODE_MOVI_1: BytecodeValue(uint8_t, pc->a) = (uint8_t)pc->imm.int_value; break;
+			case BYTECODE_MOVI_8: BytecodeValue(Kano_Int, pc->a) = pc->imm.int_value; break;
+			case BYTECODE_LOAD_STATIC: memcpy(fp + pc->a, pc->imm.pointer, pc->c); break;
+
+			case BYTECODE_LOAD_GLOBAL_1: BytecodeValue(uint8_t, pc->a) = BytecodeGlobal(uint8_t, pc->b); break;
+			case BYTECODE_LOAD_GLOBAL_8: BytecodeValue(uint64_t, pc->a) = BytecodeGlobal(uint64_t, pc->b); break;
+			case BYTECODE_LOAD_GLOBAL_N: memmove(fp + pc->a, global + pc->b, pc->c); break;
+			case BYTECODE_STORE_GLOBAL_1: BytecodeGlobal(uint8_t, pc->a) = BytecodeValue(uint8_t, pc->b); break;
+			case BYTECODE_STORE_GLOBAL_8: BytecodeGlobal(uint64_t, pc->a) = BytecodeValue(uint64_t, pc->b); break;
+			case BYTECODE_STORE_GLOBAL_N: memmove(global + pc->a, fp + pc->b, pc->c); break;
+
+			case BYTECODE_LOAD_1: BytecodeValue(uint8_t, pc->a) = *(BytecodeValue(uint8_t *, pc->b) + pc->imm.int_value); break;
+			case BYTECODE_LOAD_8: BytecodeValue(uint64_t, pc->a) = *(uint64_t *)(BytecodeValue(uint8_t *, pc->b) + pc->imm.int_value); break;
+			case BYTECODE_LOAD_N: memmove(fp + pc->a, BytecodeValue(uint8_t *, pc->b) + pc->imm.int_value, pc->c); break;
+			case BYTECODE_STORE_1: *(BytecodeValue(uint8_t *, pc->a) + pc->imm.int_value) = BytecodeValue(uint8_t, pc->b); break;
+			case BYTECODE_STORE_8: *(uint64_t *)(BytecodeValue(uint8_t *, pc->a) + pc->imm.int_value) = BytecodeValue(uint64_t, pc->b); break;
+			case BYTECODE_STORE_N: memmove(BytecodeValue(uint8_t *, pc->a) + pc->imm.int_value, fp + pc->b, pc->c); break;
+
+			case BYTECODE_ADDRESS_FRAME: BytecodeValue(uint8_t *, pc->a) = fp + pc->imm.int_value; break;
+			case BYTECODE_ADDRESS_GLOBAL: BytecodeValue(uint8_t *, pc->a) = global + pc->imm.int_value; break;
+			case BYTECODE_OFFSET_POINTER: BytecodeValue(uint8_t *, pc->a) = BytecodeValue(uint8_t *, pc->b) + pc->imm.int_value; break;
+			case BYTECODE_INDEX: BytecodeValue(uint8_t *, pc->a) = BytecodeValue(uint8_t *, pc->b) + BytecodeValue(Kano_Int, pc->c) * pc->imm.int_value; break;
+			case BYTECODE_INDEX_FRAME: BytecodeValue(uint8_t *, pc->a) = fp + pc->b + BytecodeValue(Kano_Int, pc->c) * pc->imm.int_value; break;
+			case BYTECODE_INDEX_GLOBAL: BytecodeValue(uint8_t *, pc->a) = global + pc->b + BytecodeValue(Kano_Int, pc->c) * pc->imm.int_value; break;
+
+			case BYTECODE_MAKE_ARRAY_VIEW: {
+				auto data = BytecodeValue(uint8_t *, pc->b);
+				BytecodeValue(Kano_Int, pc->a) = pc->imm.int_value;
+				BytecodeValue(uint8_t *, pc->a + sizeof(Kano_Int)) = data;
+			}
+			break;
+
+			BytecodeBinary(BYTECODE_ADD_INT, Kano_Int, Kano_Int, +);
+			BytecodeBinary(BYTECODE_SUB_INT, Kano_Int, Kano_Int, -);
+			BytecodeBinary(BYTECODE_MUL_INT, Kano_Int, Kano_Int, *);
+			BytecodeBinary(BYTECODE_DIV_INT, Kano_Int, Kano_Int, /);
+			BytecodeBinary(BYTECODE_MOD_INT, Kano_Int, Kano_Int, %);
+			BytecodeBinary(BYTECODE_SHR_INT, Kano_Int, Kano_Int, >>);
+			BytecodeBinary(BYTECODE_SHL_INT, Kano_Int, Kano_Int, <<);
+			BytecodeBinary(BYTECODE_AND_INT, Kano_Int, Kano_Int, &);
+			BytecodeBinary(BYTECODE_XOR_INT, Kano_Int, Kano_Int, ^);
+			BytecodeBinary(BYTECODE_OR_INT, Kano_Int, Kano_Int, |);
+
+			BytecodeBinary(BYTECODE_ADD_CHAR, Kano_Char, Kano_Char, +);
+			BytecodeBinary(BYTECODE_SUB_CHAR, Kano_Char, Kano_Char, -);
+			BytecodeBinary(BYTECODE_MUL_CHAR, Kano_Char, Kano_Char, *);
+			BytecodeBinary(BYTECODE_DIV_CHAR, Kano_Char, Kano_Char, /);
+			BytecodeBinary(BYTECODE_MOD_CHAR, Kano_Char, Kano_Char, %);
+			BytecodeBinary(BYTECODE_SHR_CHAR, Kano_Char, Kano_Char, >>);
+			BytecodeBinary(BYTECODE_SHL_CHAR, Kano_Char, Kano_Char, <<);
+			BytecodeBinary(BYTECODE_AND_CHAR, Kano_Char, Kano_Char, &);
+			BytecodeBinary(BYTECODE_XOR_CHAR, Kano_Char, Kano_Char, ^);
+			BytecodeBinary(BYTECODE_OR_CHAR, Kano_Char, Kano_Char, |);
+
+			BytecodeBinary(BYTECODE_ADD_REAL, Kano_Real, Kano_Real, +);
+			BytecodeBinary(BYTECODE_SUB_REAL, Kano_Real, Kano_Real, -);
+			BytecodeBinary(BYTECODE_MUL_REAL, Kano_Real, Kano_Real, *);
+			BytecodeBinary(BYTECODE_DIV_REAL, Kano_Real, Kano_Real, /);
+
+			case BYTECODE_ADD_POINTER: BytecodeValue(uint8_t *, pc->a) = BytecodeValue(uint8_t *, pc->b) + BytecodeValue(Kano_Int, pc->c); break;
+			case BYTECODE_SUB_POINTER: BytecodeValue(uint8_t *, pc->a) = BytecodeValue(uint8_t *, pc->b) - BytecodeValue(Kano_Int, pc->c); break;
+
+			BytecodeBinary(BYTECODE_GT_INT, Kano_Int, Kano_Bool, >);
+			BytecodeBinary(BYTECODE_LT_INT, Kano_Int, Kano_Bool, <);
+			BytecodeBinary(BYTECODE_GE_INT, Kano_Int, Kano_Bool, >=);
+			BytecodeBinary(BYTECODE_LE_INT, Kano_Int, Kano_Bool, <=);
+			BytecodeBinary(BYTECODE_EQ_INT, Kano_Int, Kano_Bool, ==);
+			BytecodeBinary(BYTECODE_NE_INT, Kano_Int, Kano_Bool, !=);
+
+			BytecodeBinary(BYTECODE_GT_CHAR, Kano_Char, Kano_Bool, >);
+			BytecodeBinary(BYTECODE_LT_CHAR, Kano_Char, Kano_Bool, <);
+			BytecodeBinary(BYTECODE_GE_CHAR, Kano_Char, Kano_Bool, >=);
+			BytecodeBinary(BYTECODE_LE_CHAR, Kano_Char, Kano_Bool, <=);
+			BytecodeBinary(BYTECODE_EQ_CHAR, Kano_Char, Kano_Bool, ==);
+			BytecodeBinary(BYTECODE_NE_CHAR, Kano_Char, Kano_Bool, !=);
+
+			BytecodeBinary(BYTECODE_GT_REAL, Kano_Real, Kano_Bool, >);
+			BytecodeBinary(BYTECODE_LT_REAL, Kano_Real, Kano_Bool, <);
+			BytecodeBinary(BYTECODE_GE_REAL, Kano_Real, Kano_Bool, >=);
+			BytecodeBinary(BYTECODE_LE_REAL, Kano_Real, Kano_Bool, <=);
+			BytecodeBinary(BYTECODE_EQ_REAL, Kano_Real, Kano_Bool, ==);
+			BytecodeBinary(BYTECODE_NE_REAL, Kano_Real, Kano_Bool, !=);
+
+			BytecodeBinary(BYTECODE_GT_POINTER, uint8_t *, Kano_Bool, >);
+			BytecodeBinary(BYTECODE_LT_POINTER, uint8_t *, Kano_Bool, <);
+			BytecodeBinary(BYTECODE_GE_POINTER, uint8_t *, Kano_Bool, >=);
+			BytecodeBinary(BYTECODE_LE_POINTER, uint8_t *, Kano_Bool, <=);
+			BytecodeBinary(BYTECODE_EQ_POINTER, uint8_t *, Kano_Bool, ==);
+			BytecodeBinary(BYTECODE_NE_POINTER, uint8_t *, Kano_Bool, !=);
+
+			BytecodeBinary(BYTECODE_EQ_BOOL, Kano_Bool, Kano_Bool, ==);
+			BytecodeBinary(BYTECODE_NE_BOOL, Kano_Bool, Kano_Bool, !=);
+
+			BytecodeUnary(BYTECODE_NEG_INT, Kano_Int, Kano_Int, -);
+			BytecodeUnary(BYTECODE_NEG_CHAR, Kano_Char, Kano_Char, -);
+			BytecodeUnary(BYTECODE_NEG_REAL, Kano_Real, Kano_Real, -);
+			BytecodeUnary(BYTECODE_NOT_INT, Kano_Int, Kano_Int, ~);
+			BytecodeUnary(BYTECODE_NOT_CHAR, Kano_Char, Kano_Char, ~);
+			BytecodeUnary(BYTECODE_NOT_BOOL, Kano_Bool, Kano_Bool, !);
+
+			BytecodeConvert(BYTECODE_INT_FROM_BOOL, Kano_Bool, Kano_Int);
+			BytecodeConvert(BYTECODE_INT_FROM_CHAR, Kano_Char, Kano_Int);
+			BytecodeConvert(BYTECODE_INT_FROM_REAL, Kano_Real, Kano_Int);
+			BytecodeConvert(BYTECODE_REAL_FROM_INT, Kano_Int, Kano_Real);
+			BytecodeConvert(BYTECODE_REAL_FROM_CHAR, Kano_Char, Kano_Real);
+			BytecodeConvert(BYTECODE_REAL_FROM_BOOL, Kano_Bool, Kano_Real);
+			BytecodeConvert(BYTECODE_CHAR_FROM_BOOL, Kano_Bool, Kano_Char);
+			BytecodeConvert(BYTECODE_CHAR_FROM_INT, Kano_Int, Kano_Char);
+			BytecodeConvert(BYTECODE_CHAR_FROM_REAL, Kano_Real, Kano_Char);
+
+			case BYTECODE_BOOL_FROM_INT: BytecodeValue(Kano_Bool, pc->a) = BytecodeValue(Kano_Int, pc->b) != 0; break;
+			case BYTECODE_BOOL_FROM_CHAR: BytecodeValue(Kano_Bool, pc->a) = BytecodeValue(Kano_Char, pc->b) != 0; break;
+			case BYTECODE_BOOL_FROM_REAL: BytecodeValue(Kano_Bool, pc->a) = BytecodeValue(Kano_Real, pc->b) != 0.0; break;
+			case BYTECODE_BOOL_FROM_POINTER: BytecodeValue(Kano_Bool, pc->a) = BytecodeValue(uint8_t *, pc->b) != nullptr; break;
+
+			case BYTECODE_JUMP: {
+				pc = pc->imm.target;
+			}
+			continue;
+
+			case BYTECODE_JUMP_IF_FALSE: {
+				if (!BytecodeValue(Kano_Bool, pc->a))
+				{
+					pc = pc->imm.target;
+					continue;
+				}
+			}
+			break;
+
+			case BYTECODE_JUMP_IF_TRUE: {
+				if (BytecodeValue(Kano_Bool, pc->a))
+				{
+					pc = pc->imm.target;
+					continue;
+				}
+			}
+			break;
+
+			case BYTECODE_STATEMENT: {
+				if constexpr ((Policy & INTERCEPT_POLICY_STATEMENT) != 0)
+				{
+					interp->current_row = pc->imm.statement->source_row;
+					interp->current_row_procedure = interp->current_procedure;
+					interp->intercept(interp, INTERCEPT_STATEMENT, pc->imm.statement);
+				}
+			}
+			break;
+
+			case BYTECODE_CALL:
+			case BYTECODE_CALL_INDIRECT:
+			case BYTECODE_CCALL: {
+				auto call      = pc->imm.call;
+				auto procedure = call->procedure;
+				auto ccall     = call->ccall;
+
+				if (pc->op == BYTECODE_CALL_INDIRECT)
+				{
+					auto value = BytecodeValue(Code_Value_Procedure, pc->b);
+					auto entry = code_call_cache_find(&call->cache, value);
+
+					if (entry)
+					{
+						interp->call_cache_hits += 1;
+					}
+					else
+					{
+						interp->call_cache_misses += 1;
+
+						Bytecode_Procedure *target = nullptr;
+						if (value.block)
+						{
+							auto found = program->lookup.Find((uint64_t)value.block);
+							Assert(found);
+							target = *found;
+						}
+						entry = code_call_cache_add(&call->cache, value, target);
+					}
+
+					procedure = (Bytecode_Procedure *)entry->dispatch;
+					ccall     = entry->procedure.ccall;
+				}
+
+				if (procedure)
+				{
+					if ((uint64_t)(fp + pc->a - stack) + procedure->frame_size > interp->stack_size)
+						interp_runtime_error(interp, "Stack overflow");
+
+					frames.Add(Bytecode_Frame{ pc + 1, fp, interp->current_procedure });
+
+					fp += pc->a;
+					interp->stack_top         = fp - stack;
+					interp->current_procedure = call->type;
+
+					if constexpr ((Policy & INTERCEPT_POLICY_PROCEDURE) != 0)
+						interp->intercept(interp, INTERCEPT_PROCEDURE_CALL, procedure->block);
+
+					pc = procedure->code.data;
+					continue;
+				}
+
+				auto prev_top  = interp->stack_top;
+				auto prev_proc = interp->current_procedure;
+
+				interp->stack_top         = (fp + pc->a) - stack;
+				interp->current_procedure = call->type;
+
+				ccall(interp);
+
+				interp->current_procedure = prev_proc;
+				interp->stack_top         = prev_top;
+			}
+			break;
+
+			case BYTECODE_TAIL_CALL: {
+				auto call = pc->imm.call;
+
+				if constexpr ((Policy & INTERCEPT_POLICY_PROCEDURE) != 0)
+					interp->intercept(interp, INTERCEPT_PROCEDURE_RETURN, call->caller);
+
+				if ((uint64_t)(fp - stack) + call->procedure->frame_size > interp->stack_size)
+					interp_runtime_error(interp, "Stack overflow");
+
+				memmove(fp + pc->b, fp + pc->a + pc->b, pc->c);
+				interp->current_procedure = call->type;
+
+				if constexpr ((Policy & INTERCEPT_POLICY_PROCEDURE) != 0)
+					interp->intercept(interp, INTERCEPT_PROCEDURE_CALL, call->procedure->block);
+
+				pc = call->procedure->code.data;
+			}
+			continue;
+
+			case BYTECODE_RETURN: {
+				if constexpr ((Policy & INTERCEPT_POLICY_PROCEDURE) != 0)
+				{
+					auto caller = frames.Last();
+					auto call   = (caller.pc - 1)->imm.call;
+					if (call->result_size)
+						memcpy(caller.fp + call->result_offset, fp, call->result_size);
+
+					interp->intercept(interp, INTERCEPT_PROCEDURE_RETURN, pc->imm.block);
+				}
+
+				auto frame = frames.Last();
+				frames.RemoveLast();
+
+				pc                        = frame.pc;
+				fp                        = frame.fp;
+				interp->current_procedure = frame.procedure;
+				interp->stack_top         = fp - stack;
+			}
+			continue;
+
+			case BYTECODE_HALT: {
+				Free(&frames);
+				return;
+			}
+
+			NoDefaultCase();
+		}
+
+		pc += 1;
+	}
+}
+
+#undef BytecodeConvert
+#undef BytecodeUnary
+#undef BytecodeBinary
+#undef BytecodeGlobal
+#undef BytecodeValue
+
+//
+//
+//
+
+struct Bytecode_Run
+{
+	Bytecode_Program *  program;
+	Bytecode_Procedure *chunk;
+};
+
+static void bytecode_run_policy(Interpreter *interp, void *data)
+{
+	auto run     = (Bytecode_Run *)data;
+	auto program = run->program;
+	auto chunk   = run->chunk;
+
+	switch (program->policy)
+	{
+		case INTERCEPT_POLICY_NONE: bytecode_run<INTERCEPT_POLICY_NONE>(interp, program, chunk); break;
+		case INTERCEPT_POLICY_STATEMENT: bytecode_run<INTERCEPT_POLICY_STATEMENT>(interp, program, chunk); break;
+		case INTERCEPT_POLICY_PROCEDURE: bytecode_run<INTERCEPT_POLICY_PROCEDURE>(interp, program, chunk); break;
+		case INTERCEPT_POLICY_ALL: bytecode_run<INTERCEPT_POLICY_ALL>(interp, program, chunk); break;
+		NoDefaultCase();
+	}
+}
+
+// @Note: A runtime error unwinds bytecode_run without freeing its frame list, the program is over anyway
+void bytecode_eval_globals(Interpreter *interp, Bytecode_Program *program)
+{
+	Bytecode_Run run = { program, program->globals };
+	interp_protect(interp, bytecode_run_policy, &run);
+}
+
+void bytecode_evaluate_procedure(Interpreter *interp, Bytecode_Program *program)
+{
+	Bytecode_Run run = { program, program->entry };
+	interp_protect(interp, bytecode_run_policy, &run);
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include "CodeNode.h"
+#include "Interp.h"
+
+//
+// Operands (a, b, c) are byte offsets relative to the frame pointer of the
+// running procedure unless noted otherwise. Locals keep the offsets assigned
+// by the resolver, temporaries live above them and callee frames are placed
+// after the temporaries, so the stack layout seen by intercepts and CCalls
+// is the same as with the tree walker.
+//
+
+enum Bytecode_Op : uint32_t
+{
+	BYTECODE_MOV_1,                // [a] = [b]
+	BYTECODE_MOV_8,
+	BYTECODE_MOV_N,                // c = size
+	BYTECODE_MOVI_1,               // [a] = imm
+	BYTECODE_MOVI_8,
+	BYTECODE_LOAD_STATIC,          // [a] = *imm.pointer, c = size
+
+	BYTECODE_LOAD_GLOBAL_1,        // [a] = global[b]
+	BYTECODE_LOAD_GLOBAL_8,
+	BYTECODE_LOAD_GLOBAL_N,
+	BYTECODE_STORE_GLOBAL_1,       // global[a] = [b]
+	BYTECODE_STORE_GLOBAL_8,
+	BYTECODE_STORE_GLOBAL_N,
+
+	BYTECODE_LOAD_1,               // [a] = *([b] + imm)
+	BYTECODE_LOAD_8,
+	BYTECODE_LOAD_N,
+	BYTECODE_STORE_1,              // *([a] + imm) = [b]
+	BYTECODE_STORE_8,
+	BYTECODE_STORE_N,
+
+	BYTECODE_ADDRESS_FRAME,        // [a] = fp + imm
+	BYTECODE_ADDRESS_GLOBAL,       // [a] = global + imm
+	BYTECODE_OFFSET_POINTER,       // [a] = [b] + imm
+	BYTECODE_INDEX,                // [a] = [b] + [c] * imm
+	BYTECODE_INDEX_FRAME,          // [a] = fp + b + [c] * imm
+	BYTECODE_INDEX_GLOBAL,         // [a] = global + b + [c] * imm
+	BYTECODE_MAKE_ARRAY_VIEW,      // [a] = { imm, [b] }
+
+	BYTECODE_ADD_INT,              // [a] = [b] op [c]
+	BYTECODE_SUB_INT,
+	BYTECODE_MUL_INT,
+	BYTECODE_DIV_INT,
+	BYTECODE_MOD_INT,
+	BYTECODE_SHR_INT,
+	BYTECODE_SHL_INT,
+	BYTECODE_AND_INT,
+	BYTECODE_XOR_INT,
+	BYTECODE_OR_INT,
+
+	BYTECODE_ADD_CHAR,
+	BYTECODE_SUB_CHAR,
+	BYTECODE_MUL_CHAR,
+	BYTECODE_DIV_CHAR,
+	BYTECODE_MOD_CHAR,
+	BYTECODE_SHR_CHAR,
+	BYTECODE_SHL_CHAR,
+	BYTECODE_AND_CHAR,
+	BYTECODE_XOR_CHAR,
+	BYTECODE_OR_CHAR,
+
+	BYTECODE_ADD_REAL,
+	BYTECODE_SUB_REAL,
+	BYTECODE_MUL_REAL,
+	BYTECODE_DIV_REAL,
+
+	BYTECODE_ADD_POINTER,
+	BYTECODE_SUB_POINTER,
+
+	BYTECODE_GT_INT,
+	BYTECODE_LT_INT,
+	BYTECODE_GE_INT,
+	BYTECODE_LE_INT,
+	BYTECODE_EQ_INT,
+	BYTECODE_NE_INT,
+
+	BYTECODE_GT_CHAR,
+	BYTECODE_LT_CHAR,
+	BYTECODE_GE_CHAR,
+	BYTECODE_LE_CHAR,
+	BYTECODE_EQ_CHAR,
+	BYTECODE_NE_CHAR,
+
+	BYTECODE_GT_REAL,
+	BYTECODE_LT_REAL,
+	BYTECODE_GE_REAL,
+	BYTECODE_LE_REAL,
+	BYTECODE_EQ_REAL,
+	BYTECODE_NE_REAL,
+
+	BYTECODE_GT_POINTER,
+	BYTECODE_LT_POINTER,
+	BYTECODE_GE_POINTER,
+	BYTECODE_LE_POINTER,
+	BYTECODE_EQ_POINTER,
+	BYTECODE_NE_POINTER,
+
+	BYTECODE_EQ_BOOL,
+	BYTECODE_NE_BOOL,
+
+	BYTECODE_NEG_INT,              // [a] = op [b]
+	BYTECODE_NEG_CHAR,
+	BYTECODE_NEG_REAL,
+	BYTECODE_NOT_INT,
+	BYTECODE_NOT_CHAR,
+	BYTECODE_NOT_BOOL,
+
+	BYTECODE_INT_FROM_BOOL,
+	BYTECODE_INT_FROM_CHAR,
+	BYTECODE_INT_FROM_REAL,
+	BYTECODE_REAL_FROM_INT,
+	BYTECODE_REAL_FROM_CHAR,
+	BYTECODE_REAL_FROM_BOOL,
+	BYTECODE_BOOL_FROM_INT,
+	BYTECODE_BOOL_FROM_CHAR,
+	BYTECODE_BOOL_FROM_REAL,
+	BYTECODE_BOOL_FROM_POINTER,
+	BYTECODE_CHAR_FROM_BOOL,
+	BYTECODE_CHAR_FROM_INT,
+	BYTECODE_CHAR_FROM_REAL,
+
+	BYTECODE_JUMP,                 // pc = imm.target
+	BYTECODE_JUMP_IF_FALSE,        // if ![a] pc = imm.target
+	BYTECODE_JUMP_IF_TRUE,
+
+	BYTECODE_STATEMENT,            // imm.statement, only emitted when the policy intercepts statements
+	BYTECODE_CALL,                 // callee frame at fp + a, imm.call
+	BYTECODE_CALL_INDIRECT,        // callee frame at fp + a, procedure value at [b], imm.call
+	BYTECODE_CCALL,                // callee frame at fp + a, imm.call
+	BYTECODE_TAIL_CALL,            // moves [fp + a + b, c bytes) to fp + b and runs the callee in the current frame, imm.call
+	BYTECODE_RETURN,               // imm.block
+	BYTECODE_HALT,
+
+	_BYTECODE_OP_COUNT
+};
+
+struct Bytecode_Instruction
+{
+	Bytecode_Op op = BYTECODE_HALT;
+	uint32_t    a  = 0;
+	uint32_t    b  = 0;
+	uint32_t    c  = 0;
+
+	union {
+		Kano_Int                     int_value;
+		Kano_Real                    real_value;
+		uint8_t *                    pointer;
+		Bytecode_Instruction *       target;
+		struct Bytecode_Call *       call;
+		struct Code_Node_Statement * statement;
+		struct Code_Node_Block *     block;
+	} imm = {};
+};
+
+struct Bytecode_Procedure
+{
+	Code_Node_Block *           block     = nullptr;
+	Code_Type_Procedure *       type      = nullptr;
+	Array<Bytecode_Instruction> code;
+	uint32_t                    frame_size = 0;
+};
+
+struct Bytecode_Call
+{
+	Bytecode_Procedure * procedure = nullptr;
+	CCall                ccall     = nullptr;
+	Code_Type_Procedure *type      = nullptr;
+	Code_Node_Block *    caller    = nullptr; // Only for tail calls, the block that returns
+	uint32_t             result_offset = 0;   // Only for traced calls, the caller frame offset the result is shown at
+	uint32_t             result_size   = 0;
+	Code_Call_Cache      cache;               // Only for indirect calls, dispatch is the Bytecode_Procedure
+};
+
+struct Bytecode_Program
+{
+	Array<Bytecode_Procedure *>               procedures;
+	Table<uint64_t, Bytecode_Procedure *>     lookup;
+
+	Bytecode_Procedure *globals = nullptr;
+	Bytecode_Procedure *entry   = nullptr;
+
+	Intercept_Policy policy = INTERCEPT_POLICY_NONE;
+};
+
+Bytecode_Program *bytecode_compile(Interpreter *interp, Array_View<Code_Node_Assignment *> globals, Code_Node_Procedure_Call *entry, Intercept_Policy policy);
+
+void bytecode_eval_globals(Interpreter *interp, Bytecode_Program *program);
+void bytecode_evaluate_procedure(Interpreter *interp, Bytecode_Program *program);
@@ -0,0 +1,1526 @@
+#include "CGen.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+//
+// The runtime is emitted in front of every program. It provides the frame accessors used by the
+// generated code and the builtins of include_basic, which read their arguments with the same
+// layout as Interp_Morph: the return value first, then the arguments at 8 byte aligned offsets.
+//
+
+static const char CGEN_RUNTIME[] = R"RUNTIME(
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+enum
+{
+	KANO_TYPE_NULL,
+	KANO_TYPE_CHARACTER,
+	KANO_TYPE_INTEGER,
+	KANO_TYPE_REAL,
+	KANO_TYPE_BOOL,
+	KANO_TYPE_POINTER,
+	KANO_TYPE_PROCEDURE,
+	KANO_TYPE_STRUCT,
+	KANO_TYPE_ARRAY_VIEW,
+	KANO_TYPE_STATIC_ARRAY,
+};
+
+typedef struct Kano_Type Kano_Type;
+
+typedef struct
+{
+	const char *     name;
+	const Kano_Type *type;
+	int64_t          offset;
+} Kano_Member;
+
+// (element) is the base type of pointers and the element type of arrays, (count) the element
+// count of static arrays and the member count of structs
+struct Kano_Type
+{
+	int32_t            kind;
+	int64_t            size;
+	const Kano_Type *  element;
+	int64_t            count;
+	const Kano_Member *members;
+};
+
+typedef struct { int64_t length; uint8_t *data; } Kano_String;
+typedef struct { int64_t count; uint8_t *data; } Kano_View;
+
+typedef void (*Kano_Code)(uint8_t *frame);
+typedef struct { Kano_Code code; void *unused; } Kano_Proc;
+
+static _Alignas(16) uint8_t kano_stack[KANO_STACK_SIZE];
+static _Alignas(16) uint8_t kano_global[KANO_GLOBAL_SIZE];
+
+static inline uint8_t kano_load_u8(const uint8_t *p) { return *p; }
+static inline int64_t kano_load_i64(const uint8_t *p) { int64_t v; memcpy(&v, p, sizeof(v)); return v; }
+static inline double kano_load_f64(const uint8_t *p) { double v; memcpy(&v, p, sizeof(v)); return v; }
+static inline uint8_t *kano_load_ptr(const uint8_t *p) { uint8_t *v; memcpy(&v, p, sizeof(v)); return v; }
+static inline Kano_Proc kano_load_proc(const uint8_t *p) { Kano_Proc v; memcpy(&v, p, sizeof(v)); return v; }
+
+static inline void kano_store_u8(uint8_t *p, uint8_t v) { *p = v; }
+static inline void kano_store_i64(uint8_t *p, int64_t v) { memcpy(p, &v, sizeof(v)); }
+static inline void kano_store_f64(uint8_t *p, double v) { memcpy(p, &v, sizeof(v)); }
+static inline void kano_store_ptr(uint8_t *p, const void *v) { memcpy(p, &v, sizeof(v)); }
+
+//
+// Heap blocks are linked, so that print can tell heap pointers from garbage like the interpreter
+//
+
+#define KANO_BLOCK_MAGIC 0x4b414e4f484541ull
+
+typedef struct Kano_Block
+{
+	struct Kano_Block *prev;
+	struct Kano_Block *next;
+	int64_t            size;
+	uint64_t           magic;
+} Kano_Block;
+
+static Kano_Block *kano_heap;
+
+// Arenas hand out memory from one block until they are reset or destroyed
+typedef struct Kano_Arena
+{
+	struct Kano_Arena *prev;
+	struct Kano_Arena *next;
+	int64_t            size;
+	int64_t            used;
+} Kano_Arena;
+
+static Kano_Arena *kano_arenas;
+
+static int kano_memory_valid(const uint8_t *ptr)
+{
+	if (ptr >= kano_stack && ptr < kano_stack + KANO_STACK_SIZE)
+		return 1;
+	if (ptr >= kano_global && ptr < kano_global + KANO_GLOBAL_SIZE)
+		return 1;
+	for (Kano_Block *block = kano_heap; block; block = block->next)
+	{
+		const uint8_t *data = (const uint8_t *)(block + 1);
+		if (ptr >= data && ptr < data + block->size)
+			return 1;
+	}
+	for (Kano_Arena *arena = kano_arenas; arena; arena = arena->next)
+	{
+		if (ptr >= (const uint8_t *)arena && ptr < (const uint8_t *)(arena + 1) + arena->used)
+			return 1;
+	}
+	return 0;
+}
+
+static void kano_print_value(const Kano_Type *type, const uint8_t *data)
+{
+	if (!data)
+	{
+		printf("(null)");
+		return;
+	}
+
+	switch (type->kind)
+	{
+		case KANO_TYPE_NULL: printf("(null)"); return;
+		case KANO_TYPE_CHARACTER: printf("%d", (int)kano_load_u8(data)); return;
+		case KANO_TYPE_INTEGER: printf("%lld", (long long)kano_load_i64(data)); return;
+		case KANO_TYPE_REAL: printf("%f", kano_load_f64(data)); return;
+		case KANO_TYPE_BOOL: printf("%s", kano_load_u8(data) ? "true" : "false"); return;
+		case KANO_TYPE_PROCEDURE: printf("%p", (const void *)data); return;
+
+		case KANO_TYPE_POINTER: {
+			uint8_t *raw = kano_load_ptr(data);
+			printf("{ ");
+			if (raw)
+				printf("raw: %p, ", (void *)raw);
+			else
+				printf("raw: (null), ");
+			printf("value: ");
+			if (raw && kano_memory_valid(raw))
+			{
+				kano_print_value(type->element, raw);
+				printf(" ");
+			}
+			else
+			{
+				printf("%s ", raw ? "(garbage)" : "(invalid)");
+			}
+			printf("}");
+			return;
+		}
+
+		case KANO_TYPE_STRUCT: {
+			printf("{ ");
+			for (int64_t index = 0; index < type->count; ++index)
+			{
+				const Kano_Member *member = &type->members[index];
+				printf("%s: ", member->name);
+				kano_print_value(member->type, data + member->offset);
+				if (index < type->count - 1)
+					printf(",");
+				printf(" ");
+			}
+			printf("}");
+			return;
+		}
+
+		case KANO_TYPE_ARRAY_VIEW:
+		case KANO_TYPE_STATIC_ARRAY: {
+			int64_t        count    = type->count;
+			const uint8_t *elements = data;
+			if (type->kind == KANO_TYPE_ARRAY_VIEW)
+			{
+				count    = kano_load_i64(data);
+				elements = kano_load_ptr(data + sizeof(int64_t));
+			}
+
+			printf("[ ");
+			for (int64_t index = 0; index < count; ++index)
+			{
+				kano_print_value(type->element, elements + index * type->element->size);
+				printf(" ");
+			}
+			printf("]");
+			return;
+		}
+	}
+}
+
+static void kano_rt_print(uint8_t *frame)
+{
+	Kano_String fmt;
+	memcpy(&fmt, frame, sizeof(fmt));
+	uint8_t *args = kano_load_ptr(frame + sizeof(Kano_String));
+
+	for (int64_t index = 0; index < fmt.length;)
+	{
+		if (fmt.data[index] == '%')
+		{
+			index += 1;
+			if (args)
+			{
+				const Kano_Type *type;
+				memcpy(&type, args, sizeof(type));
+				args += sizeof(type);
+				kano_print_value(type, args);
+				args += type->size;
+			}
+			else
+			{
+				printf("%%");
+			}
+		}
+		else if (fmt.data[index] == '\\')
+		{
+			index += 1;
+			if (index < fmt.length)
+			{
+				if (fmt.data[index] == 'n')
+				{
+					index += 1;
+					printf("\n");
+				}
+				else if (fmt.data[index] == '\\')
+				{
+					printf("\\");
+					index += 1;
+				}
+			}
+			else
+			{
+				printf("\\");
+			}
+		}
+		else
+		{
+			printf("%c", fmt.data[index]);
+			index += 1;
+		}
+	}
+}
+
+static void kano_rt_read_int(uint8_t *frame)
+{
+	int value = 0;
+	if (scanf("%d", &value) != 1)
+		value = 0;
+	kano_store_i64(frame, value);
+}
+
+static void kano_rt_read_float(uint8_t *frame)
+{
+	float value = 0;
+	if (scanf("%f", &value) != 1)
+		value = 0;
+	kano_store_f64(frame, value);
+}
+
+static void kano_rt_allocate(uint8_t *frame)
+{
+	int64_t     size  = kano_load_i64(frame + sizeof(void *));
+	Kano_Block *block = (Kano_Block *)calloc(1, sizeof(Kano_Block) + (size_t)(size > 0 ? size : 1));
+	uint8_t *   data  = NULL;
+	if (block)
+	{
+		block->prev  = NULL;
+		block->next  = kano_heap;
+		block->size  = size;
+		block->magic = KANO_BLOCK_MAGIC;
+		if (kano_heap)
+			kano_heap->prev = block;
+		kano_heap = block;
+		data      = (uint8_t *)(block + 1);
+	}
+	kano_store_ptr(frame, data);
+}
+
+static void kano_rt_free(uint8_t *frame)
+{
+	uint8_t *data = kano_load_ptr(frame);
+	if (!data)
+		return;
+
+	Kano_Block *block = (Kano_Block *)data - 1;
+	if (block->magic != KANO_BLOCK_MAGIC)
+		return;
+
+	block->magic = 0;
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		kano_heap = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+	free(block);
+}
+
+static void kano_rt_arena_create(uint8_t *frame)
+{
+	int64_t     size  = kano_load_i64(frame + sizeof(void *));
+	Kano_Arena *arena = size >= 0 ? (Kano_Arena *)malloc(sizeof(Kano_Arena) + (size_t)size) : NULL;
+	if (arena)
+	{
+		arena->prev  = NULL;
+		arena->next  = kano_arenas;
+		arena->size  = size;
+		arena->used  = 0;
+		if (kano_arenas)
+			kano_arenas->prev = arena;
+		kano_arenas = arena;
+	}
+	kano_store_ptr(frame, arena);
+}
+
+static Kano_Arena *kano_arena_argument(uint8_t *frame)
+{
+	// Destroyed arenas are freed, so they are looked up instead of trusting their magic
+	Kano_Arena *target = (Kano_Arena *)kano_load_ptr(frame);
+	Kano_Arena *arena  = kano_arenas;
+	while (arena && arena != target)
+		arena = arena->next;
+	if (!arena)
+	{
+		fflush(stdout);
+		fprintf(stderr, "Runtime error: Invalid arena\n");
+		exit(1);
+	}
+	return arena;
+}
+
+static void kano_rt_arena_alloc(uint8_t *frame)
+{
+	Kano_Arena *arena = kano_arena_argument(frame + sizeof(void *));
+	int64_t     size  = kano_load_i64(frame + 2 * sizeof(void *));
+	int64_t     bytes = size > 8 ? size : 8;
+	int64_t     start = (arena->used + 7) & ~(int64_t)7;
+	uint8_t *   data  = NULL;
+	if (size >= 0 && start + bytes <= arena->size)
+	{
+		data        = (uint8_t *)(arena + 1) + start;
+		arena->used = start + bytes;
+		memset(data, 0, (size_t)bytes);
+	}
+	kano_store_ptr(frame, data);
+}
+
+static void kano_rt_arena_reset(uint8_t *frame)
+{
+	kano_arena_argument(frame)->used = 0;
+}
+
+static void kano_rt_arena_destroy(uint8_t *frame)
+{
+	Kano_Arena *arena = kano_arena_argument(frame);
+	if (arena->prev)
+		arena->prev->next = arena->next;
+	else
+		kano_arenas = arena->next;
+	if (arena->next)
+		arena->next->prev = arena->prev;
+	free(arena);
+}
+
+static void kano_rt_sin(uint8_t *frame) { kano_store_f64(frame, sin(kano_load_f64(frame + sizeof(double)))); }
+static void kano_rt_cos(uint8_t *frame) { kano_store_f64(frame, cos(kano_load_f64(frame + sizeof(double)))); }
+static void kano_rt_tan(uint8_t *frame) { kano_store_f64(frame, tan(kano_load_f64(frame + sizeof(double)))); }
+
+static void kano_rt_va_arg(uint8_t *frame)
+{
+	uint8_t *arg = kano_load_ptr(frame + sizeof(void *));
+	kano_store_ptr(frame, arg + sizeof(const Kano_Type *));
+}
+
+static void kano_rt_va_arg_next(uint8_t *frame)
+{
+	uint8_t *        arg = kano_load_ptr(frame + sizeof(void *));
+	const Kano_Type *type;
+	memcpy(&type, arg, sizeof(type));
+	kano_store_ptr(frame, arg + sizeof(const Kano_Type *) + type->size);
+}
+)RUNTIME";
+
+// Builtins the runtime above implements, by the name they are registered with
+static const char *CGEN_RUNTIME_BUILTINS[] = {
+	"print", "read_int", "read_float", "allocate", "free", "arena_create", "arena_alloc", "arena_reset", "arena_destroy",
+	"sin", "cos", "tan", "va_arg", "va_arg_next",
+};
+
+//
+//
+//
+
+struct CGen_Value
+{
+	uint32_t   temp    = 0; // Zero when the expression has no value
+	bool       address = false;
+	Code_Type *type    = nullptr;
+};
+
+struct CGen_Loop
+{
+	uint32_t break_label;
+	uint32_t continue_label;
+};
+
+struct CGen
+{
+	Code_Type_Resolver *resolver = nullptr;
+	String_Builder *    error    = nullptr;
+	bool                failed   = false;
+
+	String_Builder literals;
+	String_Builder prototypes;
+	String_Builder code;
+
+	Table<uint64_t, uint32_t> procedure_ids;
+	Array<Code_Node_Block *>  procedures;
+
+	Table<uint64_t, uint32_t> type_ids;
+	Array<Code_Type *>        types;
+
+	Table<uint64_t, String>   builtins; // CCall -> name
+
+	Code_Node_Block *procedure    = nullptr;
+	uint32_t         body_label   = 0;
+	uint32_t         temp_count   = 0;
+	uint32_t         label_count  = 0;
+	uint32_t         literal_count = 0;
+	int32_t          indent       = 0;
+
+	Array<CGen_Loop> loops;
+};
+
+static CGen_Value cgen_expression(CGen *gen, Code_Node *root);
+static void       cgen_statement(CGen *gen, Code_Node_Statement *root);
+
+static void cgen_format(String_Builder *builder, const char *format, ...)
+{
+	char buffer[1024];
+
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	Assert(length >= 0 && length < (int)sizeof(buffer));
+	WriteBuffer(builder, buffer, length);
+}
+
+// Writes one line of procedure code at the current indentation
+static void cgen_line(CGen *gen, const char *format, ...)
+{
+	for (int32_t index = 0; index < gen->indent; ++index)
+		Write(&gen->code, '\t');
+
+	char buffer[1024];
+
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	Assert(length >= 0 && length < (int)sizeof(buffer));
+	WriteBuffer(&gen->code, buffer, length);
+	Write(&gen->code, '\n');
+}
+
+static CGen_Value cgen_fail(CGen *gen, const char *reason)
+{
+	if (!gen->failed)
+	{
+		gen->failed = true;
+		WriteFormatted(gen->error, "C backend: %\n", reason);
+	}
+	return CGen_Value{};
+}
+
+static inline uint32_t cgen_temp(CGen *gen)
+{
+	return ++gen->temp_count;
+}
+
+static inline uint32_t cgen_label(CGen *gen)
+{
+	return ++gen->label_count;
+}
+
+static inline void cgen_bind(CGen *gen, uint32_t label)
+{
+	gen->indent -= 1;
+	cgen_line(gen, "L%u:;", label);
+	gen->indent += 1;
+}
+
+static inline void cgen_goto(CGen *gen, uint32_t label)
+{
+	cgen_line(gen, "goto L%u;", label);
+}
+
+//
+//
+//
+
+static bool cgen_is_scalar(Code_Type *type)
+{
+	switch (type->kind)
+	{
+		case CODE_TYPE_CHARACTER:
+		case CODE_TYPE_INTEGER:
+		case CODE_TYPE_REAL:
+		case CODE_TYPE_BOOL:
+		case CODE_TYPE_POINTER: return true;
+	}
+	return false;
+}
+
+static const char *cgen_ctype(Code_Type *type)
+{
+	switch (type->kind)
+	{
+		case CODE_TYPE_CHARACTER:
+		case CODE_TYPE_BOOL: return "uint8_t";
+		case CODE_TYPE_INTEGER: return "int64_t";
+		case CODE_TYPE_REAL: return "double";
+		case CODE_TYPE_POINTER: return "uint8_t *";
+		NoDefaultCase();
+	}
+	return "";
+}
+
+// Suffix of the kano_load_ and kano_store_ accessors of the runtime
+static const char *cgen_accessor(Code_Type *type)
+{
+	switch (type->kind)
+	{
+		case CODE_TYPE_CHARACTER:
+		case CODE_TYPE_BOOL: return "u8";
+		case CODE_TYPE_INTEGER: return "i64";
+		case CODE_TYPE_REAL: return "f64";
+		case CODE_TYPE_POINTER: return "ptr";
+		NoDefaultCase();
+	}
+	return "";
+}
+
+static uint32_t cgen_type(CGen *gen, Code_Type *type)
+{
+	auto found = gen->type_ids.Find((uint64_t)type);
+	if (found)
+		return *found;
+
+	uint32_t id = (uint32_t)gen->types.count;
+	gen->type_ids.Put((uint64_t)type, id);
+	gen->types.Add(type);
+
+	switch (type->kind)
+	{
+		case CODE_TYPE_POINTER: {
+			auto base = ((Code_Type_Pointer *)type)->base_type;
+			if (base)
+				cgen_type(gen, base);
+		}
+		break;
+
+		case CODE_TYPE_ARRAY_VIEW: cgen_type(gen, ((Code_Type_Array_View *)type)->element_type); break;
+		case CODE_TYPE_STATIC_ARRAY: cgen_type(gen, ((Code_Type_Static_Array *)type)->element_type); break;
+
+		case CODE_TYPE_STRUCT: {
+			auto _struct = (Code_Type_Struct *)type;
+			for (int64_t index = 0; index < _struct->member_count; ++index)
+				cgen_type(gen, _struct->members[index].type);
+		}
+		break;
+	}
+
+	return id;
+}
+
+static uint32_t cgen_procedure(CGen *gen, Code_Node_Block *block)
+{
+	auto found = gen->procedure_ids.Find((uint64_t)block);
+	if (found)
+		return *found;
+
+	uint32_t id = (uint32_t)gen->procedures.count;
+	gen->procedure_ids.Put((uint64_t)block, id);
+	gen->procedures.Add(block);
+	cgen_format(&gen->prototypes, "static void kano_proc_%u(uint8_t *frame);\n", id);
+	return id;
+}
+
+// Writes the C name of a constant procedure, either generated code or a builtin of the runtime
+static bool cgen_callee_name(CGen *gen, Code_Value_Procedure procedure, char *buffer, size_t size)
+{
+	if (procedure.block)
+	{
+		snprintf(buffer, size, "kano_proc_%u", cgen_procedure(gen, procedure.block));
+		return true;
+	}
+
+	auto name = gen->builtins.Find((uint64_t)procedure.ccall);
+	if (name)
+	{
+		for (auto builtin : CGEN_RUNTIME_BUILTINS)
+		{
+			if (*name == String(builtin, strlen(builtin)))
+			{
+				snprintf(buffer, size, "kano_rt_%s", builtin);
+				return true;
+			}
+		}
+	}
+
+	cgen_fail(gen, "Call to a builtin procedure that the runtime does not provide");
+	return false;
+}
+
+//
+//
+//
+
+// Loads the value into a scalar temporary if it is only available through its address
+static CGen_Value cgen_load(CGen *gen, CGen_Value value)
+{
+	if (!value.temp || !value.address || !cgen_is_scalar(value.type))
+		return value;
+
+	CGen_Value result;
+	result.temp = cgen_temp(gen);
+	result.type = value.type;
+	cgen_line(gen, "%s t%u = kano_load_%s(t%u);", cgen_ctype(value.type), result.temp, cgen_accessor(value.type), value.temp);
+	return result;
+}
+
+static CGen_Value cgen_scalar(CGen *gen, Code_Node *root)
+{
+	auto value = cgen_load(gen, cgen_expression(gen, root));
+	if (!gen->failed && (!value.temp || value.address))
+		return cgen_fail(gen, "Expected a scalar value");
+	return value;
+}
+
+// Evaluates an rvalue: scalars are loaded, aggregates stay as their address
+static CGen_Value cgen_value(CGen *gen, Code_Node *root)
+{
+	auto value = cgen_load(gen, cgen_expression(gen, root));
+	if (!gen->failed && !value.temp)
+		return cgen_fail(gen, "Expected a value");
+	return value;
+}
+
+static CGen_Value cgen_address_temp(CGen *gen, Code_Type *type, const char *format, ...)
+{
+	char buffer[512];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	CGen_Value value;
+	value.temp    = cgen_temp(gen);
+	value.address = true;
+	value.type    = type;
+	cgen_line(gen, "uint8_t *t%u = %s;", value.temp, buffer);
+	return value;
+}
+
+// Stores the value to the address held by the temporary (destination) plus (offset)
+static void cgen_store(CGen *gen, CGen_Value value, Code_Type *type, const char *destination, uint64_t offset)
+{
+	if (value.address)
+	{
+		cgen_line(gen, "memmove(%s + %llu, t%u, %u);", destination, (unsigned long long)offset, value.temp, type->runtime_size);
+	}
+	else
+	{
+		cgen_line(gen, "kano_store_%s(%s + %llu, t%u);", cgen_accessor(type), destination, (unsigned long long)offset, value.temp);
+	}
+}
+
+//
+//
+//
+
+static CGen_Value cgen_procedure_constant(CGen *gen, Code_Type *type, Code_Value_Procedure procedure)
+{
+	char name[64];
+	if (!cgen_callee_name(gen, procedure, name, sizeof(name)))
+		return CGen_Value{};
+
+	auto constant = cgen_temp(gen);
+	cgen_line(gen, "Kano_Proc t%u = { %s, 0 };", constant, name);
+	return cgen_address_temp(gen, type, "(uint8_t *)&t%u", constant);
+}
+
+static CGen_Value cgen_literal(CGen *gen, Code_Node_Literal *node)
+{
+	auto type = node->type;
+
+	if (type->kind == CODE_TYPE_PROCEDURE)
+		return cgen_procedure_constant(gen, type, node->data.procedure);
+
+	if (type->kind == CODE_TYPE_STRUCT && ((Code_Type_Struct *)type)->name == "string")
+	{
+		// @Note: String literals are writable in the interpreter, so the data is not a C string literal
+		auto string = node->data.string.value;
+		auto id     = ++gen->literal_count;
+
+		cgen_format(&gen->literals, "static uint8_t kano_literal_data_%u[] = \"", id);
+		for (int64_t index = 0; index < string.length; ++index)
+			cgen_format(&gen->literals, "\\%03o", string.data[index]);
+		cgen_format(&gen->literals, "\";\nstatic Kano_String kano_literal_%u = { %lld, kano_literal_data_%u };\n", id,
+					(long long)string.length, id);
+
+		return cgen_address_temp(gen, type, "(uint8_t *)&kano_literal_%u", id);
+	}
+
+	CGen_Value value;
+	value.type = type;
+	value.temp = cgen_temp(gen);
+
+	switch (type->kind)
+	{
+		case CODE_TYPE_CHARACTER: cgen_line(gen, "uint8_t t%u = %u;", value.temp, (uint32_t)node->data.integer.value & 0xff); break;
+		case CODE_TYPE_BOOL: cgen_line(gen, "uint8_t t%u = %u;", value.temp, node->data.boolean.value ? 1 : 0); break;
+		case CODE_TYPE_INTEGER: cgen_line(gen, "int64_t t%u = (int64_t)0x%llxull;", value.temp, (unsigned long long)node->data.integer.value); break;
+		case CODE_TYPE_REAL: cgen_line(gen, "double t%u = %a;", value.temp, node->data.real.value); break;
+		case CODE_TYPE_POINTER: cgen_line(gen, "uint8_t *t%u = (uint8_t *)0x%llxull;", value.temp, (unsigned long long)node->data.pointer.value); break;
+		default: return cgen_fail(gen, "Unsupported literal");
+	}
+
+	return value;
+}
+
+// Adds (index * scale) to the address temporary
+static void cgen_index(CGen *gen, CGen_Value address, Code_Node *index, uint64_t scale)
+{
+	auto value = cgen_scalar(gen, index);
+	if (gen->failed)
+		return;
+	cgen_line(gen, "t%u += (int64_t)t%u * %llu;", address.temp, value.temp, (unsigned long long)scale);
+}
+
+static CGen_Value cgen_address(CGen *gen, Code_Node_Address *node)
+{
+	CGen_Value address;
+
+	if (node->subscript)
+	{
+		auto base = cgen_expression(gen, node->subscript->expression);
+		if (gen->failed)
+			return base;
+		if (!base.address)
+			return cgen_fail(gen, "Subscript of a value without an address");
+
+		// @Note: Array views and strings keep their data pointer after the count
+		auto kind = node->subscript->expression->type->kind;
+		if (kind == CODE_TYPE_ARRAY_VIEW || kind == CODE_TYPE_STRUCT)
+			address = cgen_address_temp(gen, node->type, "kano_load_ptr(t%u + 8) + %llu", base.temp, (unsigned long long)node->offset);
+		else
+			address = cgen_address_temp(gen, node->type, "t%u + %llu", base.temp, (unsigned long long)node->offset);
+
+		cgen_index(gen, address, node->subscript->subscript, node->subscript->type->runtime_size);
+	}
+	else
+	{
+		const char *memory = "frame";
+		uint64_t    offset = node->offset;
+
+		if (node->address)
+		{
+			switch (node->address->kind)
+			{
+				case Symbol_Address::STACK: memory = "frame"; break;
+				case Symbol_Address::GLOBAL: memory = "kano_global"; break;
+
+				case Symbol_Address::CODE: {
+					Code_Value_Procedure procedure = { node->address->code, nullptr };
+					return cgen_procedure_constant(gen, node->type, procedure);
+				}
+
+				case Symbol_Address::CCALL: {
+					Code_Value_Procedure procedure = { nullptr, node->address->ccall };
+					return cgen_procedure_constant(gen, node->type, procedure);
+				}
+
+				NoDefaultCase();
+			}
+			offset += node->address->offset;
+		}
+
+		address = cgen_address_temp(gen, node->type, "%s + %llu", memory, (unsigned long long)offset);
+	}
+
+	for (int64_t index = 0; index < node->index_count && !gen->failed; ++index)
+		cgen_index(gen, address, node->indices[index].expression, node->indices[index].stride);
+
+	return address;
+}
+
+static CGen_Value cgen_offset(CGen *gen, Code_Node_Offset *node)
+{
+	auto value = cgen_expression(gen, node->expression);
+	if (gen->failed)
+		return value;
+	if (!value.address)
+		return cgen_fail(gen, "Member of a value without an address");
+	return cgen_address_temp(gen, node->type, "t%u + %llu", value.temp, (unsigned long long)node->offset);
+}
+
+static CGen_Value cgen_scalar_temp(CGen *gen, Code_Type *type, const char *format, ...)
+{
+	char buffer[512];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	CGen_Value value;
+	value.temp = cgen_temp(gen);
+	value.type = type;
+	cgen_line(gen, "%s t%u = %s;", cgen_ctype(type), value.temp, buffer);
+	return value;
+}
+
+static CGen_Value cgen_type_cast(CGen *gen, Code_Node_Type_Cast *node)
+{
+	auto to   = node->type->kind;
+	auto from = node->child->type->kind;
+
+	if (to == CODE_TYPE_ARRAY_VIEW)
+	{
+		if (from != CODE_TYPE_STATIC_ARRAY)
+			return cgen_fail(gen, "Unsupported cast to an array view");
+
+		auto value = cgen_expression(gen, node->child);
+		if (gen->failed)
+			return value;
+
+		auto view = cgen_temp(gen);
+		cgen_line(gen, "Kano_View t%u = { %u, t%u };", view, ((Code_Type_Static_Array *)node->child->type)->element_count, value.temp);
+		return cgen_address_temp(gen, node->type, "(uint8_t *)&t%u", view);
+	}
+
+	auto value = cgen_scalar(gen, node->child);
+	if (gen->failed)
+		return value;
+
+	switch (to)
+	{
+		case CODE_TYPE_REAL: return cgen_scalar_temp(gen, node->type, "(double)t%u", value.temp);
+		case CODE_TYPE_CHARACTER: return cgen_scalar_temp(gen, node->type, "(uint8_t)t%u", value.temp);
+		case CODE_TYPE_INTEGER: return cgen_scalar_temp(gen, node->type, "(int64_t)t%u", value.temp);
+		case CODE_TYPE_BOOL: return cgen_scalar_temp(gen, node->type, "(uint8_t)(t%u != 0)", value.temp);
+		case CODE_TYPE_POINTER: return cgen_scalar_temp(gen, node->type, "t%u", value.temp);
+	}
+
+	return cgen_fail(gen, "Unsupported type cast");
+}
+
+static CGen_Value cgen_unary_operator(CGen *gen, Code_Node_Unary_Operator *node)
+{
+	if (node->operation == UNARY_OPERATION_PLUS)
+		return cgen_expression(gen, node->child);
+
+	if (node->operation == UNARY_OPERATION_POINTER_TO)
+	{
+		auto value = cgen_expression(gen, node->child);
+		if (gen->failed)
+			return value;
+		return cgen_scalar_temp(gen, node->type, "t%u", value.temp);
+	}
+
+	auto value = cgen_scalar(gen, node->child);
+	if (gen->failed)
+		return value;
+
+	switch (node->operation)
+	{
+		case UNARY_OPERATION_MINUS_CHAR: return cgen_scalar_temp(gen, node->type, "(uint8_t)-t%u", value.temp);
+		case UNARY_OPERATION_MINUS_INT: return cgen_scalar_temp(gen, node->type, "(int64_t)(0 - (uint64_t)t%u)", value.temp);
+		case UNARY_OPERATION_MINUS_REAL: return cgen_scalar_temp(gen, node->type, "-t%u", value.temp);
+		case UNARY_OPERATION_BITWISE_NOT_CHAR: return cgen_scalar_temp(gen, node->type, "(uint8_t)~t%u", value.temp);
+		case UNARY_OPERATION_BITWISE_NOT_INT: return cgen_scalar_temp(gen, node->type, "~t%u", value.temp);
+		case UNARY_OPERATION_LOGICAL_NOT_BOOL: return cgen_scalar_temp(gen, node->type, "(uint8_t)!t%u", value.temp);
+
+		case UNARY_OPERATION_DEREFERENCE: {
+			CGen_Value address = value;
+			address.address    = true;
+			address.type       = node->type;
+			return address;
+		}
+	}
+
+	return cgen_fail(gen, "Unsupported unary operator");
+}
+
+// Format of the C expression of an operation on two temporaries, signed integer arithmetic is done
+// on unsigned values so that overflow wraps like in the interpreter
+static const char *cgen_operation_format(Binary_Operation operation)
+{
+	switch (operation)
+	{
+		case BINARY_OPERATION_ADD_CHAR: return "(uint8_t)(t%u + t%u)";
+		case BINARY_OPERATION_ADD_INT: return "(int64_t)((uint64_t)t%u + (uint64_t)t%u)";
+		case BINARY_OPERATION_ADD_REAL: return "t%u + t%u";
+		case BINARY_OPERATION_ADD_POINTER: return "t%u + t%u";
+		case BINARY_OPERATION_SUB_CHAR: return "(uint8_t)(t%u - t%u)";
+		case BINARY_OPERATION_SUB_INT: return "(int64_t)((uint64_t)t%u - (uint64_t)t%u)";
+		case BINARY_OPERATION_SUB_REAL: return "t%u - t%u";
+		case BINARY_OPERATION_SUB_POINTER: return "t%u - t%u";
+		case BINARY_OPERATION_MUL_CHAR: return "(uint8_t)(t%u * t%u)";
+		case BINARY_OPERATION_MUL_INT: return "(int64_t)((uint64_t)t%u * (uint64_t)t%u)";
+		case BINARY_OPERATION_MUL_REAL: return "t%u * t%u";
+		case BINARY_OPERATION_DIV_CHAR: return "(uint8_t)(t%u / t%u)";
+		case BINARY_OPERATION_DIV_INT: return "t%u / t%u";
+		case BINARY_OPERATION_DIV_REAL: return "t%u / t%u";
+		case BINARY_OPERATION_MOD_CHAR: return "(uint8_t)(t%u %% t%u)";
+		case BINARY_OPERATION_MOD_INT: return "t%u %% t%u";
+		case BINARY_OPERATION_SHR_CHAR: return "(uint8_t)(t%u >> t%u)";
+		case BINARY_OPERATION_SHR_INT: return "t%u >> t%u";
+		case BINARY_OPERATION_SHL_CHAR: return "(uint8_t)(t%u << t%u)";
+		case BINARY_OPERATION_SHL_INT: return "(int64_t)((uint64_t)t%u << t%u)";
+		case BINARY_OPERATION_AND_CHAR:
+		case BINARY_OPERATION_AND_INT: return "t%u & t%u";
+		case BINARY_OPERATION_XOR_CHAR:
+		case BINARY_OPERATION_XOR_INT: return "t%u ^ t%u";
+		case BINARY_OPERATION_OR_CHAR:
+		case BINARY_OPERATION_OR_INT: return "t%u | t%u";
+
+		case BINARY_OPERATION_GT_CHAR:
+		case BINARY_OPERATION_GT_INT:
+		case BINARY_OPERATION_GT_REAL:
+		case BINARY_OPERATION_GT_POINTER: return "(uint8_t)(t%u > t%u)";
+		case BINARY_OPERATION_LT_CHAR:
+		case BINARY_OPERATION_LT_INT:
+		case BINARY_OPERATION_LT_REAL:
+		case BINARY_OPERATION_LT_POINTER: return "(uint8_t)(t%u < t%u)";
+		case BINARY_OPERATION_GE_CHAR:
+		case BINARY_OPERATION_GE_INT:
+		case BINARY_OPERATION_GE_REAL:
+		case BINARY_OPERATION_GE_POINTER: return "(uint8_t)(t%u >= t%u)";
+		case BINARY_OPERATION_LE_CHAR:
+		case BINARY_OPERATION_LE_INT:
+		case BINARY_OPERATION_LE_REAL:
+		case BINARY_OPERATION_LE_POINTER: return "(uint8_t)(t%u <= t%u)";
+		case BINARY_OPERATION_EQ_CHAR:
+		case BINARY_OPERATION_EQ_INT:
+		case BINARY_OPERATION_EQ_REAL:
+		case BINARY_OPERATION_EQ_BOOL:
+		case BINARY_OPERATION_EQ_POINTER: return "(uint8_t)(t%u == t%u)";
+		case BINARY_OPERATION_NE_CHAR:
+		case BINARY_OPERATION_NE_INT:
+		case BINARY_OPERATION_NE_REAL:
+		case BINARY_OPERATION_NE_BOOL:
+		case BINARY_OPERATION_NE_POINTER: return "(uint8_t)(t%u != t%u)";
+	}
+	return nullptr;
+}
+
+static void cgen_branch(CGen *gen, Code_Node *root, bool when, uint32_t label);
+
+static CGen_Value cgen_binary_operator(CGen *gen, Code_Node_Binary_Operator *node)
+{
+	if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND || node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
+	{
+		auto result = cgen_scalar_temp(gen, node->type, "0");
+		auto skip   = cgen_label(gen);
+		cgen_line(gen, "{");
+		gen->indent += 1;
+		cgen_branch(gen, node, false, skip);
+		cgen_line(gen, "t%u = 1;", result.temp);
+		gen->indent -= 1;
+		cgen_line(gen, "}");
+		cgen_bind(gen, skip);
+		return result;
+	}
+
+	auto operation = node->operation;
+	bool compound  = operation >= BINARY_OPERATION_COMPOUND_ADD_CHAR && operation <= BINARY_OPERATION_COMPOUND_OR_INT;
+	if (compound)
+		operation = (Binary_Operation)(operation - BINARY_OPERATION_COMPOUND_ADD_CHAR + BINARY_OPERATION_ADD_CHAR);
+
+	auto format = cgen_operation_format(operation);
+	if (!format)
+		return cgen_fail(gen, "Unsupported binary operator");
+
+	// @Note: Same evaluation order as the interpreter, right operand first
+	auto right = cgen_scalar(gen, node->right);
+	if (gen->failed)
+		return right;
+
+	if (compound)
+	{
+		auto left = cgen_expression(gen, node->left);
+		if (gen->failed)
+			return left;
+		if (!left.address)
+			return cgen_fail(gen, "Compound assignment to a value without an address");
+
+		auto value  = cgen_load(gen, left);
+		auto result = cgen_scalar_temp(gen, node->left->type, format, value.temp, right.temp);
+
+		char destination[32];
+		snprintf(destination, sizeof(destination), "t%u", left.temp);
+		cgen_store(gen, result, node->left->type, destination, 0);
+		return left;
+	}
+
+	auto left = cgen_scalar(gen, node->left);
+	if (gen->failed)
+		return left;
+	return cgen_scalar_temp(gen, node->type, format, left.temp, right.temp);
+}
+
+// Emits a jump to (label) taken when the condition evaluates to (when), && and || are short circuited
+static void cgen_branch(CGen *gen, Code_Node *root, bool when, uint32_t label)
+{
+	switch (root->kind)
+	{
+		case CODE_NODE_EXPRESSION: {
+			cgen_branch(gen, ((Code_Node_Expression *)root)->child, when, label);
+			return;
+		}
+
+		case CODE_NODE_UNARY_OPERATOR: {
+			auto node = (Code_Node_Unary_Operator *)root;
+			if (node->op_kind == UNARY_OPERATOR_LOGICAL_NOT)
+			{
+				cgen_branch(gen, node->child, !when, label);
+				return;
+			}
+		}
+		break;
+
+		case CODE_NODE_BINARY_OPERATOR: {
+			auto node = (Code_Node_Binary_Operator *)root;
+			if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND || node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
+			{
+				bool shortcut = node->op_kind == BINARY_OPERATOR_LOGICAL_OR;
+				if (when == shortcut)
+				{
+					cgen_branch(gen, node->left, when, label);
+					cgen_branch(gen, node->right, when, label);
+				}
+				else
+				{
+					auto skip = cgen_label(gen);
+					cgen_branch(gen, node->left, shortcut, skip);
+					cgen_branch(gen, node->right, when, label);
+					cgen_bind(gen, skip);
+				}
+				return;
+			}
+		}
+		break;
+
+		case CODE_NODE_TYPE_CAST: {
+			auto node = (Code_Node_Type_Cast *)root;
+			if (node->type->kind == CODE_TYPE_BOOL)
+			{
+				cgen_branch(gen, node->child, when, label);
+				return;
+			}
+		}
+		break;
+	}
+
+	// @Note: Each operand gets its own scope, so that no jump crosses the declaration of a temporary
+	cgen_line(gen, "{");
+	gen->indent += 1;
+	auto value = cgen_scalar(gen, root);
+	if (!gen->failed)
+		cgen_line(gen, "if (%st%u) goto L%u;", when ? "" : "!", value.temp, label);
+	gen->indent -= 1;
+	cgen_line(gen, "}");
+}
+
+//
+//
+//
+
+static void cgen_arguments(CGen *gen, Code_Node_Procedure_Call *root)
+{
+	uint64_t offset = root->stack_top;
+	for (int64_t index = 0; index < root->variadic_count && !gen->failed; ++index)
+	{
+		auto variadic = root->variadics[index];
+		auto value    = cgen_value(gen, variadic);
+		if (gen->failed)
+			return;
+
+		// @Note: The value is stored before its type, same as interp_eval_arguments
+		cgen_store(gen, value, variadic->type, "frame", offset + sizeof(Code_Type *));
+		cgen_line(gen, "kano_store_ptr(frame + %llu, &kano_type_%u);", (unsigned long long)offset, cgen_type(gen, variadic->type));
+
+		offset += sizeof(Code_Type *) + variadic->type->runtime_size;
+	}
+
+	for (int64_t index = 0; index < root->parameter_count && !gen->failed; ++index)
+	{
+		auto parameter = root->parameters[index];
+		auto value     = cgen_value(gen, parameter);
+		if (gen->failed)
+			return;
+		cgen_store(gen, value, parameter->type, "frame", root->frame_offset + root->parameter_offsets[index]);
+	}
+}
+
+static Code_Value_Procedure cgen_callee(const Symbol_Address *callee)
+{
+	Code_Value_Procedure procedure;
+	procedure.block = callee->kind == Symbol_Address::CODE ? callee->code : nullptr;
+	procedure.ccall = callee->kind == Symbol_Address::CCALL ? callee->ccall : nullptr;
+	return procedure;
+}
+
+static CGen_Value cgen_procedure_call(CGen *gen, Code_Node_Procedure_Call *root)
+{
+	cgen_arguments(gen, root);
+	if (gen->failed)
+		return CGen_Value{};
+
+	if (root->callee)
+	{
+		char name[64];
+		if (!cgen_callee_name(gen, cgen_callee(root->callee), name, sizeof(name)))
+			return CGen_Value{};
+		cgen_line(gen, "%s(frame + %llu);", name, (unsigned long long)root->frame_offset);
+	}
+	else
+	{
+		auto procedure = cgen_expression(gen, root->procedure);
+		if (gen->failed)
+			return procedure;
+		if (!procedure.address)
+			return cgen_fail(gen, "Call of a procedure value without an address");
+		cgen_line(gen, "kano_load_proc(t%u).code(frame + %llu);", procedure.temp, (unsigned long long)root->frame_offset);
+	}
+
+	if (!root->type)
+		return CGen_Value{};
+
+	return cgen_address_temp(gen, root->type, "frame + %llu", (unsigned long long)root->frame_offset);
+}
+
+static void cgen_assignment(CGen *gen, Code_Node_Assignment *node)
+{
+	auto value = cgen_value(gen, node->value);
+	if (gen->failed)
+		return;
+
+	auto destination = cgen_expression(gen, node->destination);
+	if (gen->failed)
+		return;
+	if (!destination.address)
+	{
+		cgen_fail(gen, "Assignment to a value without an address");
+		return;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "t%u", destination.temp);
+	cgen_store(gen, value, node->value->type, name, 0);
+}
+
+static CGen_Value cgen_expression(CGen *gen, Code_Node *root)
+{
+	if (gen->failed)
+		return CGen_Value{};
+
+	switch (root->kind)
+	{
+		case CODE_NODE_LITERAL: return cgen_literal(gen, (Code_Node_Literal *)root);
+		case CODE_NODE_ADDRESS: return cgen_address(gen, (Code_Node_Address *)root);
+		case CODE_NODE_OFFSET: return cgen_offset(gen, (Code_Node_Offset *)root);
+		case CODE_NODE_TYPE_CAST: return cgen_type_cast(gen, (Code_Node_Type_Cast *)root);
+		case CODE_NODE_UNARY_OPERATOR: return cgen_unary_operator(gen, (Code_Node_Unary_Operator *)root);
+		case CODE_NODE_BINARY_OPERATOR: return cgen_binary_operator(gen, (Code_Node_Binary_Operator *)root);
+		case CODE_NODE_EXPRESSION: return cgen_expression(gen, ((Code_Node_Expression *)root)->child);
+		case CODE_NODE_PROCEDURE_CALL: return cgen_procedure_call(gen, (Code_Node_Procedure_Call *)root);
+
+		case CODE_NODE_ASSIGNMENT: {
+			cgen_assignment(gen, (Code_Node_Assignment *)root);
+			return CGen_Value{};
+		}
+	}
+
+	return cgen_fail(gen, "Unsupported expression");
+}
+
+//
+//
+//
+
+static void cgen_return(CGen *gen, Code_Node_Return *node)
+{
+	if (node->tail_call)
+	{
+		auto call = node->tail_call;
+		cgen_arguments(gen, call);
+		if (gen->failed)
+			return;
+
+		// @Note: Same as interp_reuse_frame, the staged parameters move down into the current frame.
+		// No pointer into the frame survives this, tail_call is only set when none was ever taken
+		if (call->parameter_count)
+		{
+			auto last  = call->parameter_count - 1;
+			auto begin = call->parameter_offsets[0];
+			auto end   = call->parameter_offsets[last] + call->parameters[last]->type->runtime_size;
+			cgen_line(gen, "memmove(frame + %llu, frame + %llu, %llu);", (unsigned long long)begin,
+					  (unsigned long long)(call->frame_offset + begin), (unsigned long long)(end - begin));
+		}
+
+		if (call->callee->code == gen->procedure)
+		{
+			cgen_goto(gen, gen->body_label);
+			return;
+		}
+
+		char name[64];
+		if (!cgen_callee_name(gen, cgen_callee(call->callee), name, sizeof(name)))
+			return;
+		cgen_line(gen, "%s(frame);", name);
+	}
+	else if (node->expression)
+	{
+		auto value = cgen_value(gen, node->expression);
+		if (gen->failed)
+			return;
+		cgen_store(gen, value, node->expression->type, "frame", 0);
+	}
+
+	cgen_line(gen, "return;");
+}
+
+static void cgen_body(CGen *gen, Code_Node_Statement *body, uint32_t break_label, uint32_t continue_label)
+{
+	gen->loops.Add(CGen_Loop{ break_label, continue_label });
+	cgen_statement(gen, body);
+	gen->loops.RemoveLast();
+}
+
+static void cgen_statement(CGen *gen, Code_Node_Statement *root)
+{
+	if (gen->failed)
+		return;
+
+	switch (root->node->kind)
+	{
+		case CODE_NODE_EXPRESSION: {
+			auto child = ((Code_Node_Expression *)root->node)->child;
+			switch (child->kind)
+			{
+				case CODE_NODE_BREAK: cgen_goto(gen, gen->loops.Last().break_label); return;
+				case CODE_NODE_CONTINUE: cgen_goto(gen, gen->loops.Last().continue_label); return;
+			}
+
+			cgen_line(gen, "{");
+			gen->indent += 1;
+			if (child->kind == CODE_NODE_RETURN)
+				cgen_return(gen, (Code_Node_Return *)child);
+			else
+				cgen_expression(gen, child);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+		}
+		break;
+
+		case CODE_NODE_ASSIGNMENT: {
+			cgen_line(gen, "{");
+			gen->indent += 1;
+			cgen_assignment(gen, (Code_Node_Assignment *)root->node);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+		}
+		break;
+
+		case CODE_NODE_BLOCK: {
+			auto block = (Code_Node_Block *)root->node;
+			cgen_line(gen, "{");
+			gen->indent += 1;
+			for (auto statement = block->statement_head; statement; statement = statement->next)
+				cgen_statement(gen, statement);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+		}
+		break;
+
+		case CODE_NODE_IF: {
+			auto node      = (Code_Node_If *)root->node;
+			auto otherwise = cgen_label(gen);
+			auto done      = cgen_label(gen);
+			cgen_branch(gen, node->condition, false, otherwise);
+			cgen_statement(gen, node->true_statement);
+			cgen_goto(gen, done);
+			cgen_bind(gen, otherwise);
+			if (node->false_statement)
+				cgen_statement(gen, node->false_statement);
+			cgen_bind(gen, done);
+		}
+		break;
+
+		case CODE_NODE_FOR: {
+			auto node = (Code_Node_For *)root->node;
+			auto next = cgen_label(gen);
+			auto exit = cgen_label(gen);
+			cgen_line(gen, "{");
+			gen->indent += 1;
+			cgen_statement(gen, node->initialization);
+			cgen_line(gen, "for (;;) {");
+			gen->indent += 1;
+			cgen_branch(gen, node->condition->node, false, exit);
+			cgen_body(gen, node->body, exit, next);
+			cgen_bind(gen, next);
+			cgen_statement(gen, node->increment);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+			cgen_bind(gen, exit);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+		}
+		break;
+
+		case CODE_NODE_WHILE: {
+			auto node = (Code_Node_While *)root->node;
+			auto top  = cgen_label(gen);
+			auto exit = cgen_label(gen);
+			cgen_line(gen, "for (;;) {");
+			gen->indent += 1;
+			cgen_bind(gen, top);
+			cgen_branch(gen, node->condition->node, false, exit);
+			cgen_body(gen, node->body, exit, top);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+			cgen_bind(gen, exit);
+		}
+		break;
+
+		case CODE_NODE_DO: {
+			auto node      = (Code_Node_Do *)root->node;
+			auto condition = cgen_label(gen);
+			auto exit      = cgen_label(gen);
+			cgen_line(gen, "for (;;) {");
+			gen->indent += 1;
+			cgen_body(gen, node->body, exit, condition);
+			cgen_bind(gen, condition);
+			cgen_branch(gen, node->condition->node, false, exit);
+			gen->indent -= 1;
+			cgen_line(gen, "}");
+			cgen_bind(gen, exit);
+		}
+		break;
+
+		default: cgen_fail(gen, "Unsupported statement"); break;
+	}
+}
+
+static void cgen_emit_procedure(CGen *gen, uint32_t id)
+{
+	auto block = gen->procedures[id];
+
+	gen->procedure  = block;
+	gen->body_label = cgen_label(gen);
+
+	if (block->procedure_source_row >= 0)
+		cgen_format(&gen->code, "\n// Line %lld\n", (long long)block->procedure_source_row);
+	else
+		Write(&gen->code, "\n");
+	cgen_format(&gen->code, "static void kano_proc_%u(uint8_t *frame)\n{\n", id);
+
+	gen->indent = 1;
+	cgen_bind(gen, gen->body_label);
+	for (auto statement = block->statement_head; statement && !gen->failed; statement = statement->next)
+		cgen_statement(gen, statement);
+	gen->indent = 0;
+
+	Write(&gen->code, "}\n");
+	gen->procedure = nullptr;
+}
+
+static void cgen_emit_types(CGen *gen, String_Builder *out)
+{
+	if (!gen->types.count)
+		return;
+
+	for (int64_t id = 0; id < gen->types.count; ++id)
+		cgen_format(out, "static const Kano_Type kano_type_%lld;\n", (long long)id);
+
+	for (int64_t id = 0; id < gen->types.count; ++id)
+	{
+		auto type = gen->types[id];
+		if (type->kind != CODE_TYPE_STRUCT || !((Code_Type_Struct *)type)->member_count)
+			continue;
+
+		auto _struct = (Code_Type_Struct *)type;
+		cgen_format(out, "static const Kano_Member kano_members_%lld[] = {\n", (long long)id);
+		for (int64_t index = 0; index < _struct->member_count; ++index)
+		{
+			auto member = &_struct->members[index];
+			cgen_format(out, "\t{ \"%.*s\", &kano_type_%u, %llu },\n", (int)member->name.length, member->name.data,
+						*gen->type_ids.Find((uint64_t)member->type), (unsigned long long)member->offset);
+		}
+		Write(out, "};\n");
+	}
+
+	for (int64_t id = 0; id < gen->types.count; ++id)
+	{
+		auto type = gen->types[id];
+
+		Code_Type *element = nullptr;
+		int64_t    count   = 0;
+		bool       members = false;
+
+		switch (type->kind)
+		{
+			case CODE_TYPE_POINTER: element = ((Code_Type_Pointer *)type)->base_type; break;
+			case CODE_TYPE_ARRAY_VIEW: element = ((Code_Type_Array_View *)type)->element_type; break;
+
+			case CODE_TYPE_STATIC_ARRAY: {
+				element = ((Code_Type_Static_Array *)type)->element_type;
+				count   = ((Code_Type_Static_Array *)type)->element_count;
+			}
+			break;
+
+			case CODE_TYPE_STRUCT: {
+				count   = ((Code_Type_Struct *)type)->member_count;
+				members = count != 0;
+			}
+			break;
+		}
+
+		cgen_format(out, "static const Kano_Type kano_type_%lld = { %d, %u, ", (long long)id, (int)type->kind, type->runtime_size);
+		if (element)
+			cgen_format(out, "&kano_type_%u, ", *gen->type_ids.Find((uint64_t)element));
+		else
+			Write(out, "0, ");
+		cgen_format(out, "%lld, ", (long long)count);
+		if (members)
+			cgen_format(out, "kano_members_%lld };\n", (long long)id);
+		else
+			Write(out, "0 };\n");
+	}
+
+	Write(out, "\n");
+}
+
+static void cgen_append(String_Builder *out, String_Builder *builder)
+{
+	for (auto bucket = &builder->head; bucket; bucket = bucket->next)
+		WriteBuffer(out, bucket->data, bucket->written);
+}
+
+bool cgen_emit_program(Code_Type_Resolver *resolver, Array_View<Code_Node_Assignment *> globals,
+					   Code_Node_Procedure_Call *main_proc, const CGen_Options &options, String_Builder *out,
+					   String_Builder *error)
+{
+	CGen gen;
+	gen.resolver = resolver;
+	gen.error    = error;
+
+	for (auto &pair : code_type_resolver_global_symbol_table(resolver)->map)
+	{
+		auto symbol = pair.value;
+		if (symbol->address.kind == Symbol_Address::CCALL)
+			gen.builtins.Put((uint64_t)symbol->address.ccall, symbol->name);
+	}
+
+	Write(&gen.code, "\nstatic void kano_globals(uint8_t *frame)\n{\n");
+	gen.indent = 1;
+	for (auto global : globals)
+	{
+		cgen_line(&gen, "{");
+		gen.indent += 1;
+		cgen_assignment(&gen, global);
+		gen.indent -= 1;
+		cgen_line(&gen, "}");
+	}
+	gen.indent = 0;
+	Write(&gen.code, "}\n");
+
+	char main_name[64] = {};
+	if (!gen.failed)
+		cgen_callee_name(&gen, cgen_callee(main_proc->callee), main_name, sizeof(main_name));
+
+	// @Note: Procedures are added to the list as they are referenced, so the list grows while it is emitted
+	for (int64_t id = 0; id < gen.procedures.count && !gen.failed; ++id)
+		cgen_emit_procedure(&gen, (uint32_t)id);
+
+	if (!gen.failed)
+	{
+		Write(out, "// Generated by kanoc --emit-c\n\n");
+		cgen_format(out, "#define KANO_STACK_SIZE %llu\n", (unsigned long long)options.stack_size);
+		cgen_format(out, "#define KANO_GLOBAL_SIZE %llu\n", (unsigned long long)(options.global_size ? options.global_size : 1));
+		Write(out, CGEN_RUNTIME);
+		Write(out, "\n");
+
+		cgen_emit_types(&gen, out);
+		cgen_append(out, &gen.literals);
+		Write(out, "\n");
+		cgen_append(out, &gen.prototypes);
+		cgen_append(out, &gen.code);
+
+		cgen_format(out, "\nint main(void)\n{\n\tkano_globals(kano_stack);\n\t%s(kano_stack);\n\treturn 0;\n}\n", main_name);
+	}
+
+	FreeBuilder(&gen.literals);
+	FreeBuilder(&gen.prototypes);
+	FreeBuilder(&gen.code);
+	Free(&gen.procedure_ids);
+	Free(&gen.procedures);
+	Free(&gen.type_ids);
+	Free(&gen.types);
+	Free(&gen.builtins);
+	Free(&gen.loops);
+
+	return !gen.failed;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "CodeNode.h"
+#include "Resolver.h"
+
+//
+// Translates a resolved program into a standalone C translation unit. The generated code keeps the
+// memory model of the interpreter: every procedure takes the address of its frame, locals live at
+// their Symbol_Address::STACK offsets, globals at their offsets into one block and calls place
+// their arguments at the frame offsets computed by the resolver. The builtins registered by
+// include_basic are provided by a small runtime that is emitted along with the program, so the
+// output only needs the system C compiler:
+//
+//     kanoc --emit-c program.kn > program.c && cc -O2 program.c -o program -lm
+//
+
+struct CGen_Options
+{
+	uint64_t stack_size  = 1024 * 1024 * 4;
+	uint64_t global_size = 0;
+};
+
+// Returns false and writes the reason to (error) when the program uses something the C backend does not support
+bool cgen_emit_program(Code_Type_Resolver *resolver, Array_View<Code_Node_Assignment *> globals,
+					   Code_Node_Procedure_Call *main_proc, const CGen_Options &options, String_Builder *out,
+					   String_Builder *error);
@@ -324,6 +324,17 @@ struct Code_Node_Address : public Code_Node
 	const Symbol_Address *address = nullptr;
 
 	uint64_t              offset  = 0;
+
+	// Subscripts into static arrays and member offsets are collapsed by the resolver, so that
+	// the final address is (base + offset + sum(indices[n] * strides[n]))
+	int64_t               index_count = 0;
+	struct Code_Address_Index *indices = nullptr;
+};
+
+struct Code_Address_Index
+{
+	struct Code_Node_Expression *expression = nullptr;
+	uint64_t                     stride     = 0;
 };
 
 struct Code_Node_Type_Cast : public Code_Node
@@ -349,6 +360,22 @@ enum Unary_Operator_Kind
 	_UNARY_OPERATOR_COUNT
 };
 
+// Type specialized form of a unary operator, selected by the resolver from the operand type
+enum Unary_Operation
+{
+	UNARY_OPERATION_PLUS,
+	UNARY_OPERATION_MINUS_CHAR,
+	UNARY_OPERATION_MINUS_INT,
+	UNARY_OPERATION_MINUS_REAL,
+	UNARY_OPERATION_BITWISE_NOT_CHAR,
+	UNARY_OPERATION_BITWISE_NOT_INT,
+	UNARY_OPERATION_LOGICAL_NOT_BOOL,
+	UNARY_OPERATION_POINTER_TO,
+	UNARY_OPERATION_DEREFERENCE,
+
+	_UNARY_OPERATION_COUNT
+};
+
 struct Unary_Operator
 {
 	Code_Type *parameter;
@@ -363,6 +390,7 @@ struct Code_Node_Unary_Operator : public Code_Node
 	}
 
 	Unary_Operator_Kind op_kind;
+	Unary_Operation     operation = UNARY_OPERATION_PLUS;
 
 	Code_Node *         child = nullptr;
 };
@@ -401,6 +429,104 @@ enum Binary_Operator_Kind
 	_BINARY_OPERATOR_COUNT
 };
 
+// Type specialized form of a binary operator, selected by the resolver from the left operand type
+enum Binary_Operation
+{
+	BINARY_OPERATION_ADD_CHAR,
+	BINARY_OPERATION_ADD_INT,
+	BINARY_OPERATION_ADD_REAL,
+	BINARY_OPERATION_ADD_POINTER,
+	BINARY_OPERATION_SUB_CHAR,
+	BINARY_OPERATION_SUB_INT,
+	BINARY_OPERATION_SUB_REAL,
+	BINARY_OPERATION_SUB_POINTER,
+	BINARY_OPERATION_MUL_CHAR,
+	BINARY_OPERATION_MUL_INT,
+	BINARY_OPERATION_MUL_REAL,
+	BINARY_OPERATION_DIV_CHAR,
+	BINARY_OPERATION_DIV_INT,
+	BINARY_OPERATION_DIV_REAL,
+	BINARY_OPERATION_MOD_CHAR,
+	BINARY_OPERATION_MOD_INT,
+	BINARY_OPERATION_SHR_CHAR,
+	BINARY_OPERATION_SHR_INT,
+	BINARY_OPERATION_SHL_CHAR,
+	BINARY_OPERATION_SHL_INT,
+	BINARY_OPERATION_AND_CHAR,
+	BINARY_OPERATION_AND_INT,
+	BINARY_OPERATION_XOR_CHAR,
+	BINARY_OPERATION_XOR_INT,
+	BINARY_OPERATION_OR_CHAR,
+	BINARY_OPERATION_OR_INT,
+
+	BINARY_OPERATION_GT_CHAR,
+	BINARY_OPERATION_GT_INT,
+	BINARY_OPERATION_GT_REAL,
+	BINARY_OPERATION_GT_POINTER,
+	BINARY_OPERATION_LT_CHAR,
+	BINARY_OPERATION_LT_INT,
+	BINARY_OPERATION_LT_REAL,
+	BINARY_OPERATION_LT_POINTER,
+	BINARY_OPERATION_GE_CHAR,
+	BINARY_OPERATION_GE_INT,
+	BINARY_OPERATION_GE_REAL,
+	BINARY_OPERATION_GE_POINTER,
+	BINARY_OPERATION_LE_CHAR,
+	BINARY_OPERATION_LE_INT,
+	BINARY_OPERATION_LE_REAL,
+	BINARY_OPERATION_LE_POINTER,
+	BINARY_OPERATION_EQ_CHAR,
+	BINARY_OPERATION_EQ_INT,
+	BINARY_OPERATION_EQ_REAL,
+	BINARY_OPERATION_EQ_BOOL,
+	BINARY_OPERATION_EQ_POINTER,
+	BINARY_OPERATION_NE_CHAR,
+	BINARY_OPERATION_NE_INT,
+	BINARY_OPERATION_NE_REAL,
+	BINARY_OPERATION_NE_BOOL,
+	BINARY_OPERATION_NE_POINTER,
+
+	BINARY_OPERATION_COMPOUND_ADD_CHAR,
+	BINARY_OPERATION_COMPOUND_ADD_INT,
+	BINARY_OPERATION_COMPOUND_ADD_REAL,
+	BINARY_OPERATION_COMPOUND_ADD_POINTER,
+	BINARY_OPERATION_COMPOUND_SUB_CHAR,
+	BINARY_OPERATION_COMPOUND_SUB_INT,
+	BINARY_OPERATION_COMPOUND_SUB_REAL,
+	BINARY_OPERATION_COMPOUND_SUB_POINTER,
+	BINARY_OPERATION_COMPOUND_MUL_CHAR,
+	BINARY_OPERATION_COMPOUND_MUL_INT,
+	BINARY_OPERATION_COMPOUND_MUL_REAL,
+	BINARY_OPERATION_COMPOUND_DIV_CHAR,
+	BINARY_OPERATION_COMPOUND_DIV_INT,
+	BINARY_OPERATION_COMPOUND_DIV_REAL,
+	BINARY_OPERATION_COMPOUND_MOD_CHAR,
+	BINARY_OPERATION_COMPOUND_MOD_INT,
+	BINARY_OPERATION_COMPOUND_SHR_CHAR,
+	BINARY_OPERATION_COMPOUND_SHR_INT,
+	BINARY_OPERATION_COMPOUND_SHL_CHAR,
+	BINARY_OPERATION_COMPOUND_SHL_INT,
+	BINARY_OPERATION_COMPOUND_AND_CHAR,
+	BINARY_OPERATION_COMPOUND_AND_INT,
+	BINARY_OPERATION_COMPOUND_XOR_CHAR,
+	BINARY_OPERATION_COMPOUND_XOR_INT,
+	BINARY_OPERATION_COMPOUND_OR_CHAR,
+	BINARY_OPERATION_COMPOUND_OR_INT,
+
+	BINARY_OPERATION_LOGICAL_AND_CHAR,
+	BINARY_OPERATION_LOGICAL_AND_INT,
+	BINARY_OPERATION_LOGICAL_AND_REAL,
+	BINARY_OPERATION_LOGICAL_AND_BOOL,
+	BINARY_OPERATION_LOGICAL_AND_POINTER,
+	BINARY_OPERATION_LOGICAL_OR_CHAR,
+	BINARY_OPERATION_LOGICAL_OR_INT,
+	BINARY_OPERATION_LOGICAL_OR_REAL,
+	BINARY_OPERATION_LOGICAL_OR_BOOL,
+	BINARY_OPERATION_LOGICAL_OR_POINTER,
+
+	_BINARY_OPERATION_COUNT
+};
+
 struct Binary_Operator
 {
 	Code_Type *parameters[2];
@@ -416,6 +542,7 @@ struct Code_Node_Binary_Operator : public Code_Node
 	}
 
 	Binary_Operator_Kind op_kind;
+	Binary_Operation     operation = _BINARY_OPERATION_COUNT;
 
 	Code_Node *          left  = nullptr;
 	Code_Node *          right = nullptr;
@@ -450,6 +577,9 @@ struct Code_Node_Return : public Code_Node
 	}
 
 	Code_Node *expression = nullptr;
+
+	// Set when the expression is a call in tail position, the callee then reuses the frame of the returning procedure
+	struct Code_Node_Procedure_Call *tail_call = nullptr;
 };
 
 struct Code_Node_Break : public Code_Node
@@ -483,6 +613,62 @@ struct Code_Node_Statement : public Code_Node
 	Symbol_Table *symbol_table = nullptr;
 };
 
+// Every call frame starts at a multiple of this, so that the frame layout of a call can be computed
+// by the resolver relative to the stack top of the caller
+constexpr uint64_t CODE_FRAME_ALIGNMENT = sizeof(int64_t);
+
+constexpr uint32_t CODE_CALL_CACHE_ENTRIES = 4;
+
+// Inline cache of an indirect call site, keyed on the called procedure. A site calling one procedure
+// stays monomorphic, up to CODE_CALL_CACHE_ENTRIES procedures are kept for polymorphic sites and after
+// that the entries are replaced in round robin order
+struct Code_Call_Cache
+{
+	struct Entry
+	{
+		Code_Value_Procedure procedure;
+		void *               dispatch; // Resolved once per procedure by the evaluator that owns the cache
+	};
+
+	Entry    entries[CODE_CALL_CACHE_ENTRIES];
+	uint32_t count  = 0;
+	uint32_t next   = 0;
+	uint64_t hits   = 0;
+	uint64_t misses = 0;
+};
+
+inline Code_Call_Cache::Entry *code_call_cache_find(Code_Call_Cache *cache, Code_Value_Procedure procedure)
+{
+	for (uint32_t index = 0; index < cache->count; ++index)
+	{
+		auto entry = &cache->entries[index];
+		if (entry->procedure.block == procedure.block && entry->procedure.ccall == procedure.ccall)
+		{
+			cache->hits += 1;
+			return entry;
+		}
+	}
+	cache->misses += 1;
+	return nullptr;
+}
+
+inline Code_Call_Cache::Entry *code_call_cache_add(Code_Call_Cache *cache, Code_Value_Procedure procedure, void *dispatch)
+{
+	Code_Call_Cache::Entry *entry;
+	if (cache->count < CODE_CALL_CACHE_ENTRIES)
+	{
+		entry = &cache->entries[cache->count++];
+	}
+	else
+	{
+		entry       = &cache->entries[cache->next];
+		cache->next = (cache->next + 1) % CODE_CALL_CACHE_ENTRIES;
+	}
+	entry->procedure = procedure;
+	entry->dispatch  = dispatch;
+	return entry;
+}
+
 struct Code_Node_Procedure_Call : public Code_Node
 {
 	Code_Node_Procedure_Call()
@@ -499,6 +685,16 @@ struct Code_Node_Procedure_Call : public Code_Node
 	Code_Type_Procedure *procedure_type = nullptr;
 
 	uint64_t               stack_top       = 0;
+
+	// Set when the callee is a constant procedure, so the procedure expression is never evaluated
+	const Symbol_Address *callee = nullptr;
+
+	// Frame layout computed by the resolver: variadics are placed at (stack_top) and the callee frame at
+	// (frame_offset) from the caller's stack top. Inside the frame the return value is at 0 and the
+	// parameters at (parameter_offsets)
+	uint64_t               variadics_size    = 0;
+	uint64_t               frame_offset      = 0;
+	uint64_t *             parameter_offsets = nullptr;
 };
 
 struct Code_Node_Subscript : public Code_Node
@@ -523,6 +719,17 @@ struct Code_Node_Offset : public Code_Node
 	uint64_t offset = 0;
 };
 
+// Native code of a procedure body or a loop, compiled once it has run often enough (see Jit.h).
+// Returns an Interp_Completion, the frame is the stack top the node is evaluated with
+typedef int (*Code_Jit_Proc)(struct Interpreter *interp, uint8_t *frame);
+
+struct Code_Jit_State
+{
+	Code_Jit_Proc code    = nullptr;
+	uint32_t      hotness = 0;
+	bool          failed  = false; // Uses something the JIT does not support, stays interpreted
+};
+
 struct Code_Node_If : public Code_Node
 {
 	Code_Node_If()
@@ -549,6 +756,8 @@ struct Code_Node_For : public Code_Node
 	Code_Node_Statement * body           = nullptr;
 
 	Symbol_Table          symbols;
+
+	Code_Jit_State        jit;
 };
 
 struct Code_Node_While : public Code_Node
@@ -561,6 +770,8 @@ struct Code_Node_While : public Code_Node
 	Code_Node_Statement *condition = nullptr;
 
 	Code_Node_Statement *body      = nullptr;
+
+	Code_Jit_State       jit;
 };
 
 struct Code_Node_Do : public Code_Node
@@ -573,6 +784,8 @@ struct Code_Node_Do : public Code_Node
 	Code_Node_Statement *body      = nullptr;
 
 	Code_Node_Statement *condition = nullptr;
+
+	Code_Jit_State       jit;
 };
 
 struct Code_Node_Block : public Code_Node
@@ -588,4 +801,9 @@ struct Code_Node_Block : public Code_Node
 	Symbol_Table         symbols;
 
 	int64_t procedure_source_row = -1;
+
+	// Bytes of the stack used from the frame of the procedure, including the arguments staged for its calls
+	uint64_t frame_size = 0;
+
+	Code_Jit_State jit;
 };
@@ -2,6 +2,10 @@
 #include "Parser.h"
 #include "Resolver.h"
 #include "StdLib.h"
+#include "Bytecode.h"
+#include "Optimizer.h"
+#include "Jit.h"
+#include "CGen.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -45,15 +49,45 @@ int main(int argc, char **argv)
 	parser_register_error_proc(parser_on_error);
 	code_type_resolver_register_error_proc(code_type_resolver_on_error);
 
-	if (argc != 2) {
+	bool        bytecode = false;
+	bool        optimize = false;
+	bool        stats    = false;
+	bool        jit      = true;
+	bool        emit_c   = false;
+	bool        heap_profile = false;
+	uint32_t    jit_threshold = JIT_DEFAULT_THRESHOLD;
+	const char *path     = nullptr;
+
+	for (int index = 1; index < argc; ++index) {
+		if (strcmp(argv[index], "--vm") == 0)
+			bytecode = true;
+		else if (strcmp(argv[index], "--optimize") == 0)
+			optimize = true;
+		else if (strcmp(argv[index], "--stats") == 0)
+			stats = true;
+		else if (strcmp(argv[index], "--no-jit") == 0)
+			jit = false;
+		else if (strcmp(argv[index], "--emit-c") == 0)
+			emit_c = true;
+		else if (strcmp(argv[index], "--heap-profile") == 0)
+			heap_profile = true;
+		else if (strncmp(argv[index], "--jit-threshold=", 16) == 0)
+			jit_threshold = (uint32_t)strtoul(argv[index] + 16, nullptr, 10);
+		else if (!path)
+			path = argv[index];
+		else
+			path = "";
+	}
+
+	if (!path || !path[0]) {
 		fprintf(stderr, "Error: Expected file\n");
-		fprintf(stderr, "\tUsage: %s <file>\n\n", argv[0]);
+		fprintf(stderr, "\tUsage: %s [--vm] [--optimize] [--stats] [--no-jit] [--jit-threshold=N] [--emit-c] [--heap-profile] <file>\n\n", argv[0]);
 		return 1;
 	}
 
-	String code = read_entire_file(argv[1]);
+	String code = read_entire_file(path);
 	if (!code.data) {
-		fprintf(stderr, "File \"%s\" could not be read.\n\n", argv[1]);
+		fprintf(stderr, "File \"%s\" could not be read.\n\n", path);
 		return 1;
 	}
 
@@ -82,7 +116,14 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
+	if (optimize) {
+		auto stats = code_optimize(resolver, exprs);
+		fprintf(stderr, "Optimizer: %lld nodes eliminated, %lld constants folded, %lld branches removed\n",
+			(long long)code_optimize_eliminated(stats), (long long)stats.folded, (long long)stats.branches_removed);
+	}
+
 	Heap_Allocator heap_allocator;
+	Heap_Profile   heap_profiler;
 
 	const uint32_t stack_size = 1024 * 1024 * 4;
 
@@ -90,10 +131,10 @@ int main(int argc, char **argv)
 	interp.user_context = nullptr;
 	interp.global_symbol_table = code_type_resolver_global_symbol_table(resolver);
 	interp.heap = &heap_allocator;
+	interp.heap_profile = heap_profile ? &heap_profiler : nullptr;
 	interp_init(&interp, resolver, stack_size, code_type_resolver_bss_allocated(resolver));
 
-	interp_eval_globals(&interp, exprs);
-	auto main_proc = interp_find_main(&interp);
+	auto main_proc = interp_find_main(resolver);
 
 	if (!main_proc) {
 		String str = BuildString(&builder);
@@ -101,7 +142,69 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
-	interp_evaluate_procedure(&interp, main_proc);
+	if (emit_c) {
+		CGen_Options options;
+		options.stack_size  = stack_size;
+		options.global_size = code_type_resolver_bss_allocated(resolver);
+
+		String_Builder output;
+		if (!cgen_emit_program(resolver, exprs, main_proc, options, &output, &builder)) {
+			String str = BuildString(&builder);
+			fprintf(stderr, "%s\n", str.data);
+			return 1;
+		}
+
+		String str = BuildString(&output);
+		fwrite(str.data, 1, str.length, stdout);
+		return 0;
+	}
+
+	// @Note: Allocations are attributed to current_row, which is only kept updated when statements are
+	// intercepted, so the heap profile runs without the JIT
+	if (bytecode) {
+		auto policy  = heap_profile ? INTERCEPT_POLICY_STATEMENT : INTERCEPT_POLICY_NONE;
+		auto program = bytecode_compile(&interp, exprs, main_proc, policy);
+		bytecode_eval_globals(&interp, program);
+		bytecode_evaluate_procedure(&interp, program);
+	} else if (heap_profile) {
+		interp_eval_globals<INTERCEPT_POLICY_STATEMENT>(&interp, exprs);
+		interp_evaluate_procedure<INTERCEPT_POLICY_STATEMENT>(&interp, main_proc);
+	} else {
+		if (jit)
+			interp.jit = jit_create(&interp, jit_threshold);
+		interp_eval_globals<INTERCEPT_POLICY_NONE>(&interp, exprs);
+		interp_evaluate_procedure<INTERCEPT_POLICY_NONE>(&interp, main_proc);
+	}
+
+	if (interp.heap_profile) {
+		fflush(stdout);
+		heap_profile_print(interp.heap_profile, stderr);
+	}
+
+	if (stats) {
+		if (bytecode) {
+			fprintf(stderr, "Call cache: %llu hits, %llu misses\n",
+				(unsigned long long)interp.call_cache_hits, (unsigned long long)interp.call_cache_misses);
+		}
+		if (interp.jit) {
+			fprintf(stderr, "JIT: %lld procedures, %lld loops compiled, %lld rejected\n",
+				(long long)interp.jit->procedures_compiled, (long long)interp.jit->loops_compiled, (long long)interp.jit->rejected);
+		}
+	}
+
+	if (interp.jit)
+		jit_destroy(interp.jit);
+
+	int status = 0;
+	if (interp.runtime_error) {
+		fflush(stdout);
+		fprintf(stderr, "Runtime error: %s\n", interp.runtime_error);
+		status = 1;
+	}
+
+	interp_free(&interp);
+	heap_release(&heap_allocator);
+	heap_profile_release(&heap_profiler);
 
-	return 0;
+	return status;
 }
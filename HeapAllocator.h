@@ -1,111 +1,410 @@
 #pragma once
 #include "Kr/KrBasic.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//
+// Small allocations are served from per size class free lists, the slots of a class are carved out of
+// spans taken from the large heap. Large allocations are blocks with boundary tags that are coalesced
+// with their free neighbours when released, free blocks are kept in bins by the log2 of their size.
+// Every allocation is preceded by its requested size, which decides the path it is freed through and is
+// what total_allocated and total_freed account for.
+//
+// The heap is one contiguous range of address space that is reserved up front and committed as it grows,
+// so telling whether a pointer belongs to the heap takes two compares.
+//
+// Arenas created by the program are separate reservations that are only released as a whole, they are
+// kept here so that their pointers can still be classified and so that they go away with the heap.
+//
+// Free blocks remember whether their memory is known to be zero: freshly committed space is, and large
+// blocks that are freed have their pages given back to the OS so they are again. Allocations from such
+// memory skip clearing it, which allocate would otherwise do for every byte.
+//
+
+constexpr uint64_t HEAP_SMALL_GRANULARITY = 16;
+constexpr uint64_t HEAP_SMALL_LINEAR_MAX  = 256;  // Classes grow by HEAP_SMALL_GRANULARITY up to here
+constexpr uint64_t HEAP_SMALL_MAX         = 4096; // and by powers of 2 after it
+constexpr uint32_t HEAP_SMALL_CLASS_COUNT = HEAP_SMALL_LINEAR_MAX / HEAP_SMALL_GRANULARITY + 4;
+constexpr uint64_t HEAP_SPAN_SIZE         = 64 * 1024;
+constexpr uint64_t HEAP_CHUNK_SIZE        = 1024 * 1024;
+constexpr uint64_t HEAP_RESERVE_SIZE      = 16ull * 1024 * 1024 * 1024;
+constexpr uint64_t HEAP_PAGE_SIZE         = 64 * 1024; // At least the page size of every platform
+
+// Free blocks from this size on give their pages back to the OS. Touching them again faults the pages in,
+// which costs more than clearing them, so this is only done for blocks that are large enough to matter
+constexpr uint64_t HEAP_PURGE_SIZE        = 16 * 1024 * 1024;
+
+constexpr uint32_t HEAP_BIN_COUNT         = 64;
+constexpr uint64_t HEAP_BLOCK_FREE        = 0x1;
+constexpr uint64_t HEAP_BLOCK_ZERO        = 0x2; // Everything after the Block header of the free block is zero
+constexpr uint64_t HEAP_BLOCK_FLAGS       = HEAP_BLOCK_FREE | HEAP_BLOCK_ZERO;
+
 struct Heap_Allocator
 {
-	struct Memory
+	// Header of a large block, (size) includes the header and has HEAP_BLOCK_FLAGS set while the block is free.
+	// The committed range ends with a block of size 0 that is never free, so the last block has a next neighbour
+	struct Block
 	{
-		void *ptr;
+		uint64_t prev_size;
 		uint64_t size;
+
+		// Only while the block is free
+		Block *next;
+		Block *prev;
 	};
 
-	struct Bucket
+	struct Size_Class
 	{
-		uint64_t size;
-
-		union {
-			Bucket * next[1];
-			uint8_t  ptr[8];
-		};
+		uint8_t *free_list = nullptr;
+		uint8_t *span_top  = nullptr;
+		uint8_t *span_end  = nullptr;
+		bool     span_zero = false;
 	};
 
-	Bucket *free_list = nullptr;
+	Size_Class classes[HEAP_SMALL_CLASS_COUNT];
+	Block *    bins[HEAP_BIN_COUNT] = {};
 
-	uint64_t allocation = 0;
+	uint8_t *memory    = nullptr;
+	uint64_t committed = 0;
+
+	Array<Memory_Arena *> arenas;
 
 	uint64_t total_allocated = 0;
 	uint64_t total_freed = 0;
-	
-	Array<Memory> memories;
 };
 
+constexpr uint64_t HEAP_BLOCK_HEADER_SIZE = 2 * sizeof(uint64_t);
+constexpr uint64_t HEAP_BLOCK_MIN_SIZE    = sizeof(Heap_Allocator::Block) + 2 * HEAP_SMALL_GRANULARITY;
+
+static inline uint32_t heap_size_class(uint64_t size)
+{
+	if (size <= HEAP_SMALL_LINEAR_MAX)
+		return (uint32_t)((size + HEAP_SMALL_GRANULARITY - 1) / HEAP_SMALL_GRANULARITY - 1);
+
+	uint32_t index    = HEAP_SMALL_LINEAR_MAX / HEAP_SMALL_GRANULARITY;
+	uint64_t capacity = HEAP_SMALL_LINEAR_MAX * 2;
+	for (; size > capacity; capacity <<= 1)
+		index += 1;
+	return index;
+}
+
+static inline uint64_t heap_class_size(uint32_t index)
+{
+	const uint32_t linear = HEAP_SMALL_LINEAR_MAX / HEAP_SMALL_GRANULARITY;
+	if (index < linear)
+		return (index + 1) * HEAP_SMALL_GRANULARITY;
+	return (HEAP_SMALL_LINEAR_MAX * 2) << (index - linear);
+}
+
+static inline uint32_t heap_bin_index(uint64_t size)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, size);
+	return (uint32_t)index;
+#else
+	return 63 - (uint32_t)__builtin_clzll(size);
+#endif
+}
+
+static inline Heap_Allocator::Block *heap_next_block(Heap_Allocator::Block *block)
+{
+	return (Heap_Allocator::Block *)((uint8_t *)block + (block->size & ~HEAP_BLOCK_FLAGS));
+}
+
+static inline void heap_bin_insert(Heap_Allocator *allocator, Heap_Allocator::Block *block, bool zero)
+{
+	auto bin = &allocator->bins[heap_bin_index(block->size)];
+
+	block->size |= zero ? HEAP_BLOCK_FLAGS : HEAP_BLOCK_FREE;
+	block->prev = nullptr;
+	block->next = *bin;
+	if (*bin)
+		(*bin)->prev = block;
+	*bin = block;
+}
+
+// Returns whether the memory after the Block header was zero
+static inline bool heap_bin_remove(Heap_Allocator *allocator, Heap_Allocator::Block *block)
+{
+	bool zero = (block->size & HEAP_BLOCK_ZERO) != 0;
+	block->size &= ~HEAP_BLOCK_FLAGS;
+
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		allocator->bins[heap_bin_index(block->size)] = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+
+	return zero;
+}
+
 static inline bool heap_contains_memory(Heap_Allocator *allocator, void *ptr)
 {
-	for (auto memory : allocator->memories)
+	return ptr >= allocator->memory && ptr < allocator->memory + allocator->committed;
+}
+
+// Gives the whole pages of a free block back to the OS and clears the rest, so the block is known to be zero
+static inline bool heap_purge_block(Heap_Allocator::Block *block)
+{
+	auto begin = (uint8_t *)block + sizeof(Heap_Allocator::Block);
+	auto end   = (uint8_t *)block + block->size;
+	auto first = (uint8_t *)AlignPower2Up((uint64_t)begin, HEAP_PAGE_SIZE);
+	auto last  = (uint8_t *)AlignPower2Down((uint64_t)end, HEAP_PAGE_SIZE);
+
+	if (first >= last || !VirtualMemoryZero(first, last - first))
+		return false;
+
+	memset(begin, 0, first - begin);
+	memset(last, 0, end - last);
+	return true;
+}
+
+// Merges the block with its free neighbours, (zero) tells whether the memory after its header is zero
+static inline void heap_free_block(Heap_Allocator *allocator, Heap_Allocator::Block *block, bool zero)
+{
+	// @Note: The header of a merged block becomes part of the memory of the other one, so it is cleared
+	// when both of them were zero
+	auto next = heap_next_block(block);
+	if (next->size & HEAP_BLOCK_FREE)
+	{
+		bool next_zero = heap_bin_remove(allocator, next);
+		block->size += next->size;
+		if (zero && next_zero)
+			memset(next, 0, sizeof(*next));
+		zero = zero && next_zero;
+	}
+
+	if (block->prev_size)
 	{
-		if (ptr >= memory.ptr && ptr < (uint8_t *)memory.ptr + memory.size)
+		auto prev = (Heap_Allocator::Block *)((uint8_t *)block - block->prev_size);
+		if (prev->size & HEAP_BLOCK_FREE)
 		{
-			return true;
+			bool prev_zero = heap_bin_remove(allocator, prev);
+			prev->size += block->size;
+			if (zero && prev_zero)
+				memset(block, 0, sizeof(*block));
+			zero  = zero && prev_zero;
+			block = prev;
 		}
 	}
 
-	return false;
+	if (!zero && block->size >= HEAP_PURGE_SIZE)
+		zero = heap_purge_block(block);
+
+	heap_next_block(block)->prev_size = block->size;
+	heap_bin_insert(allocator, block, zero);
+}
+
+// Commits at least (size) more bytes at the end of the heap, the block of size 0 that ended the heap
+// becomes the header of the new space, which is merged with the last block when that one is free
+static inline bool heap_grow(Heap_Allocator *allocator, uint64_t size)
+{
+	if (!allocator->memory)
+	{
+		allocator->memory = (uint8_t *)VirtualMemoryAllocate(nullptr, HEAP_RESERVE_SIZE);
+		if (!allocator->memory)
+			return false;
+	}
+
+	auto growth = Maximum(HEAP_CHUNK_SIZE, allocator->committed);
+	growth      = Maximum(growth, size + 2 * HEAP_BLOCK_HEADER_SIZE);
+	growth      = AlignPower2Up(growth, HEAP_CHUNK_SIZE);
+	growth      = Minimum(growth, HEAP_RESERVE_SIZE - allocator->committed);
+
+	if (growth < size + 2 * HEAP_BLOCK_HEADER_SIZE)
+		return false;
+	if (!VirtualMemoryCommit(allocator->memory + allocator->committed, growth))
+		return false;
+
+	Heap_Allocator::Block *block;
+	if (allocator->committed)
+	{
+		block = (Heap_Allocator::Block *)(allocator->memory + allocator->committed - HEAP_BLOCK_HEADER_SIZE);
+	}
+	else
+	{
+		block            = (Heap_Allocator::Block *)allocator->memory;
+		block->prev_size = 0;
+	}
+
+	allocator->committed += growth;
+	block->size = (uint64_t)(allocator->memory + allocator->committed - HEAP_BLOCK_HEADER_SIZE - (uint8_t *)block);
+
+	auto end  = heap_next_block(block);
+	end->size = 0;
+
+	heap_free_block(allocator, block, true);
+	return true;
+}
+
+// Returns a block of at least (size) bytes including its header, the rest of the block is split off
+// when it is large enough to be a block of its own. (zero) tells whether the memory after the header is zero
+static inline Heap_Allocator::Block *heap_alloc_block(Heap_Allocator *allocator, uint64_t size, bool *zero)
+{
+	size = AlignPower2Up(Maximum(size, HEAP_BLOCK_MIN_SIZE), HEAP_SMALL_GRANULARITY);
+
+	Heap_Allocator::Block *found = nullptr;
+
+	// @Note: Only the first bin can hold blocks smaller than (size), every block of a later bin fits
+	auto first = heap_bin_index(size);
+	for (auto block = allocator->bins[first]; block; block = block->next)
+	{
+		if ((block->size & ~HEAP_BLOCK_FLAGS) >= size)
+		{
+			found = block;
+			break;
+		}
+	}
+
+	for (auto index = first + 1; !found && index < HEAP_BIN_COUNT; ++index)
+		found = allocator->bins[index];
+
+	if (!found)
+	{
+		if (!heap_grow(allocator, size))
+			return nullptr;
+		return heap_alloc_block(allocator, size, zero);
+	}
+
+	*zero = heap_bin_remove(allocator, found);
+
+	// @Note: The header of the rest is written into memory that was zero, its own memory still is
+	if (found->size - size >= HEAP_BLOCK_MIN_SIZE)
+	{
+		auto rest       = (Heap_Allocator::Block *)((uint8_t *)found + size);
+		rest->prev_size = size;
+		rest->size      = found->size - size;
+		heap_next_block(rest)->prev_size = rest->size;
+		found->size     = size;
+		heap_bin_insert(allocator, rest, *zero);
+	}
+
+	if (*zero)
+	{
+		found->next = nullptr;
+		found->prev = nullptr;
+	}
+
+	return found;
 }
 
 static inline void heap_free(Heap_Allocator *allocator, void *ptr)
 {
 	if (heap_contains_memory(allocator, ptr))
 	{
-		auto buk = (Heap_Allocator::Bucket *)((uint8_t *)ptr - sizeof(Heap_Allocator::Bucket::size));
-		allocator->total_freed += buk->size;
-		buk->next[0] = allocator->free_list;
-		allocator->free_list = buk;
+		auto header = (uint64_t *)ptr - 1;
+		auto size   = *header;
+		allocator->total_freed += size;
+
+		if (size <= HEAP_SMALL_MAX)
+		{
+			auto size_class = &allocator->classes[heap_size_class(size)];
+			*(uint8_t **)header = size_class->free_list;
+			size_class->free_list = (uint8_t *)header;
+		}
+		else
+		{
+			heap_free_block(allocator, (Heap_Allocator::Block *)((uint8_t *)header - HEAP_BLOCK_HEADER_SIZE), false);
+		}
 	}
 }
 
 static inline void *heap_alloc(Heap_Allocator *allocator, uint64_t size)
 {
-	size = Maximum(size, sizeof(Heap_Allocator::Bucket::ptr));
+	size = Maximum(size, sizeof(uint64_t));
 	allocator->total_allocated += size;
 
-	Heap_Allocator::Bucket *parent = nullptr;
-	for (auto buk = allocator->free_list; buk; buk = buk->next[0])
+	uint64_t *header;
+	bool      zero = false;
+
+	if (size <= HEAP_SMALL_MAX)
 	{
-		if (size <= buk->size)
+		auto index      = heap_size_class(size);
+		auto size_class = &allocator->classes[index];
+		auto slot_size  = sizeof(uint64_t) + heap_class_size(index);
+
+		if (size_class->free_list)
 		{
-			if (buk->size > size + sizeof(*buk))
-			{
-				auto next = (Heap_Allocator::Bucket *)(buk->ptr + size);
-				next->size = buk->size - size;
-				next->next[0] = buk->next[0];
-
-				if (parent)
-					parent->next[0] = next;
-				else
-					allocator->free_list = next;
-
-				buk->size = size;
-				memset(buk->ptr, 0, size);
-				return (void *)buk->ptr;
-			}
-			else
+			header = (uint64_t *)size_class->free_list;
+			size_class->free_list = *(uint8_t **)header;
+		}
+		else
+		{
+			if (size_class->span_top + slot_size > size_class->span_end)
 			{
-				if (parent)
-					parent->next[0] = buk->next[0];
-				else
-					allocator->free_list = buk->next[0];
-				memset(buk->ptr, 0, size);
-				return (void *)buk->ptr;
+				auto span = heap_alloc_block(allocator, HEAP_SPAN_SIZE, &size_class->span_zero);
+				if (!span)
+					return nullptr;
+				size_class->span_top = (uint8_t *)span + HEAP_BLOCK_HEADER_SIZE;
+				size_class->span_end = (uint8_t *)span + span->size;
 			}
+
+			header = (uint64_t *)size_class->span_top;
+			zero   = size_class->span_zero;
+			size_class->span_top += slot_size;
 		}
+	}
+	else
+	{
+		auto block = heap_alloc_block(allocator, HEAP_BLOCK_HEADER_SIZE + sizeof(uint64_t) + size, &zero);
+		if (!block)
+			return nullptr;
+		header = (uint64_t *)((uint8_t *)block + HEAP_BLOCK_HEADER_SIZE);
+	}
+
+	*header = size;
+	if (!zero)
+		memset(header + 1, 0, size);
+	return header + 1;
+}
+
+static inline Memory_Arena *heap_arena_create(Heap_Allocator *allocator, uint64_t size)
+{
+	auto reserve = AlignPower2Up(size + sizeof(uint64_t) * 4, MemoryArenaCommitSize);
+	auto arena   = MemoryArenaAllocate(reserve);
+	if (arena)
+		allocator->arenas.Add(arena);
+	return arena;
+}
 
-		parent = buk;
+static inline ptrdiff_t heap_arena_find(Heap_Allocator *allocator, void *arena)
+{
+	for (ptrdiff_t index = 0; index < allocator->arenas.count; ++index)
+	{
+		if (allocator->arenas[index] == arena)
+			return index;
 	}
+	return -1;
+}
 
-	allocator->allocation = Maximum(1024 * 1024, allocator->allocation * 2);
-	allocator->allocation = Maximum(allocator->allocation, size);
-	allocator->allocation = AlignPower2Up(allocator->allocation, 64);
+static inline bool heap_arena_contains_memory(Heap_Allocator *allocator, void *ptr)
+{
+	for (auto arena : allocator->arenas)
+	{
+		if (ptr >= (uint8_t *)arena && ptr < (uint8_t *)arena + MemoryArenaUsedSize(arena))
+			return true;
+	}
+	return false;
+}
 
-	Heap_Allocator::Memory mem;
-	mem.size = allocator->allocation;
-	mem.ptr = MemoryAllocate(mem.size);
+static inline void heap_arena_destroy(Heap_Allocator *allocator, ptrdiff_t index)
+{
+	MemoryArenaFree(allocator->arenas[index]);
+	allocator->arenas.RemoveUnordered(index);
+}
 
-	allocator->memories.Add(mem);
-	
-	auto buk = (Heap_Allocator::Bucket *)mem.ptr;
-	buk->size = mem.size - sizeof(buk->size);
-	buk->next[0] = allocator->free_list;
-	allocator->free_list = buk;
+static inline void heap_release(Heap_Allocator *allocator)
+{
+	for (auto arena : allocator->arenas)
+		MemoryArenaFree(arena);
+	Free(&allocator->arenas);
 
-	return heap_alloc(allocator, size);
+	if (allocator->memory)
+		VirtualMemoryFree(allocator->memory, HEAP_RESERVE_SIZE);
+	allocator->memory    = nullptr;
+	allocator->committed = 0;
 }
@@ -0,0 +1,164 @@
+#include "HeapProfile.h"
+
+#include <stdlib.h>
+
+static uint32_t heap_profile_lifetime_bucket(uint64_t lifetime)
+{
+	uint32_t bucket = 0;
+	for (uint64_t limit = 4; lifetime >= limit && bucket < HEAP_PROFILE_LIFETIME_BUCKETS - 1; limit *= 4)
+		bucket += 1;
+	return bucket;
+}
+
+static Heap_Profile_Site *heap_profile_site(Heap_Profile *profile, uint64_t row, String procedure, uint32_t *index)
+{
+	auto found = profile->site_rows.Find(row);
+	if (found)
+	{
+		*index = *found;
+		return &profile->sites[*found];
+	}
+
+	*index = (uint32_t)profile->sites.count;
+	profile->site_rows.Put(row, *index);
+
+	auto site       = profile->sites.Add();
+	*site           = Heap_Profile_Site{};
+	site->row       = row;
+	site->procedure = procedure;
+	return site;
+}
+
+void heap_profile_allocate(Heap_Profile *profile, uint64_t row, String procedure, void *ptr, uint64_t size)
+{
+	profile->clock += 1;
+
+	if (!ptr)
+		return;
+
+	uint32_t index;
+	auto     site = heap_profile_site(profile, row, procedure, &index);
+
+	site->allocations += 1;
+	site->bytes_allocated += size;
+	site->live_bytes += size;
+	site->peak_live_bytes = Maximum(site->peak_live_bytes, site->live_bytes);
+
+	profile->live_bytes += size;
+	profile->peak_live_bytes = Maximum(profile->peak_live_bytes, profile->live_bytes);
+
+	Heap_Profile::Block block;
+	block.site  = index;
+	block.size  = size;
+	block.birth = profile->clock;
+	profile->blocks.Put((uint64_t)ptr, block);
+}
+
+void heap_profile_free(Heap_Profile *profile, void *ptr)
+{
+	auto block = profile->blocks.Find((uint64_t)ptr);
+	if (!block)
+		return;
+
+	auto site = &profile->sites[block->site];
+	site->frees += 1;
+	site->bytes_freed += block->size;
+	site->live_bytes -= block->size;
+	site->lifetimes[heap_profile_lifetime_bucket(profile->clock - block->birth)] += 1;
+
+	profile->live_bytes -= block->size;
+	profile->blocks.Remove((uint64_t)ptr);
+}
+
+void heap_profile_release(Heap_Profile *profile)
+{
+	Free(&profile->sites);
+	Free(&profile->site_rows);
+	Free(&profile->blocks);
+}
+
+static Array<Heap_Profile_Site *> heap_profile_sorted_sites(Heap_Profile *profile)
+{
+	Array<Heap_Profile_Site *> sites;
+	for (auto &site : profile->sites)
+		sites.Add(&site);
+
+	qsort(sites.data, sites.count, sizeof(*sites.data), [](const void *_a, const void *_b) -> int {
+		auto a = *(Heap_Profile_Site **)_a;
+		auto b = *(Heap_Profile_Site **)_b;
+		if (a->bytes_allocated != b->bytes_allocated)
+			return a->bytes_allocated > b->bytes_allocated ? -1 : 1;
+		return a->row < b->row ? -1 : (a->row > b->row);
+	});
+
+	return sites;
+}
+
+void heap_profile_write_json(Heap_Profile *profile, Json_Writer *json)
+{
+	auto sites = heap_profile_sorted_sites(profile);
+
+	json->begin_object();
+	json->write_key_value("peak_live_bytes", profile->peak_live_bytes);
+
+	json->write_key("sites");
+	json->begin_array();
+	for (auto site : sites)
+	{
+		json->begin_object();
+		json->write_key_value("row", site->row);
+		json->write_key_value_formatted("procedure", "%", site->procedure);
+		json->write_key_value("allocations", site->allocations);
+		json->write_key_value("bytes_allocated", site->bytes_allocated);
+		json->write_key_value("frees", site->frees);
+		json->write_key_value("bytes_freed", site->bytes_freed);
+		json->write_key_value("peak_live_bytes", site->peak_live_bytes);
+		json->write_key_value("leaked_blocks", site->allocations - site->frees);
+		json->write_key_value("leaked_bytes", site->live_bytes);
+
+		json->write_key("lifetimes");
+		json->begin_array();
+		for (auto count : site->lifetimes)
+		{
+			json->next_element();
+			Write(json->builder, count);
+		}
+		json->end_array();
+
+		json->end_object();
+	}
+	json->end_array();
+
+	json->end_object();
+
+	Free(&sites);
+}
+
+void heap_profile_print(Heap_Profile *profile, FILE *out)
+{
+	auto sites = heap_profile_sorted_sites(profile);
+
+	fprintf(out, "Heap profile: peak live %llu bytes\n", (unsigned long long)profile->peak_live_bytes);
+	fprintf(out, "%8s %-20s %10s %14s %10s %14s %14s %10s %14s\n", "row", "procedure", "allocs", "bytes", "frees",
+			"bytes freed", "peak live", "leaked", "leaked bytes");
+
+	for (auto site : sites)
+	{
+		fprintf(out, "%8llu %-20.*s %10llu %14llu %10llu %14llu %14llu %10llu %14llu\n", (unsigned long long)site->row,
+				(int)site->procedure.length, (const char *)site->procedure.data, (unsigned long long)site->allocations,
+				(unsigned long long)site->bytes_allocated, (unsigned long long)site->frees,
+				(unsigned long long)site->bytes_freed, (unsigned long long)site->peak_live_bytes,
+				(unsigned long long)(site->allocations - site->frees), (unsigned long long)site->live_bytes);
+	}
+
+	fprintf(out, "Lifetimes in allocations, buckets of powers of 4:\n");
+	for (auto site : sites)
+	{
+		fprintf(out, "%8llu", (unsigned long long)site->row);
+		for (auto count : site->lifetimes)
+			fprintf(out, " %8llu", (unsigned long long)count);
+		fprintf(out, "\n");
+	}
+
+	Free(&sites);
+}
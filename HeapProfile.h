@@ -0,0 +1,56 @@
+#pragma once
+#include "Kr/KrBasic.h"
+#include "JsonWriter.h"
+
+#include <stdio.h>
+
+//
+// Attributes the allocations of a program to the source row of the allocate call that made them. The
+// interpreter only keeps current_row updated with INTERCEPT_POLICY_STATEMENT, so programs are profiled
+// with that policy. Lifetimes are measured in the number of allocations made while a block was live,
+// which keeps the profile of a program the same from run to run.
+//
+
+// Bucket (i) counts the blocks that lived for less than 4^(i+1) allocations, the last one everything else
+constexpr uint32_t HEAP_PROFILE_LIFETIME_BUCKETS = 8;
+
+struct Heap_Profile_Site
+{
+	uint64_t row       = 0;
+	String   procedure = "global";
+
+	uint64_t allocations     = 0;
+	uint64_t bytes_allocated = 0;
+	uint64_t frees           = 0;
+	uint64_t bytes_freed     = 0;
+	uint64_t live_bytes      = 0;
+	uint64_t peak_live_bytes = 0;
+
+	uint64_t lifetimes[HEAP_PROFILE_LIFETIME_BUCKETS] = {};
+};
+
+struct Heap_Profile
+{
+	struct Block
+	{
+		uint32_t site;
+		uint64_t size;
+		uint64_t birth;
+	};
+
+	Array<Heap_Profile_Site>  sites;
+	Table<uint64_t, uint32_t> site_rows;
+	Table<uint64_t, Block>    blocks;
+
+	uint64_t clock           = 0;
+	uint64_t live_bytes      = 0;
+	uint64_t peak_live_bytes = 0;
+};
+
+void heap_profile_allocate(Heap_Profile *profile, uint64_t row, String procedure, void *ptr, uint64_t size);
+void heap_profile_free(Heap_Profile *profile, void *ptr);
+void heap_profile_release(Heap_Profile *profile);
+
+// Sites are written by the number of bytes they allocated, largest first
+void heap_profile_write_json(Heap_Profile *profile, Json_Writer *json);
+void heap_profile_print(Heap_Profile *profile, FILE *out);
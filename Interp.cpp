@@ -2,108 +2,140 @@
 #include "CodeNode.h"
 
 #include "Resolver.h"
+#include "Jit.h"
 
 #include <stdlib.h>
-
-struct Evaluation_Value
+#include <setjmp.h>
+
+#if PLATFORM_LINUX == 1 || PLATFORM_MAC == 1
+#include <signal.h>
+#include <pthread.h>
+#define INTERP_GUARD_SIGNALS 1
+#else
+#define INTERP_GUARD_SIGNALS 0
+#endif
+
+#if COMPILER_MSVC == 1
+#include <intrin.h>
+#define InterpNativeStackPointer() ((uint8_t *)_AddressOfReturnAddress())
+#else
+#define InterpNativeStackPointer() ((uint8_t *)__builtin_frame_address(0))
+#endif
+
+// Lowest native stack address the tree walker may make a call at, set by interp_protect
+static thread_local uint8_t *interp_native_limit = nullptr;
+
+// Result of evaluating an expression. Scalars, procedures and array views are returned by value,
+// structs and static arrays by the address of their data. The type is not carried along, every
+// consumer knows it from the node it evaluated.
+union Interp_Value
 {
 	struct Kano_Array
 	{
 		Kano_Int length;
 		uint8_t *data;
 	};
-	
-	union {
-		Kano_Char  char_value;
-		Kano_Int   int_value;
-		Kano_Real  real_value;
-		Kano_Bool  bool_value;
-		uint8_t *  pointer_value;
-		Kano_Array array_value;
-		Code_Value_Procedure procedure_value;
-	} imm;
-	
-	uint8_t *  from_address = nullptr;
-	Code_Type *type         = nullptr;
+
+	Kano_Char            char_value;
+	Kano_Int             int_value;
+	Kano_Real            real_value;
+	Kano_Bool            bool_value;
+	uint8_t *            pointer_value;
+	Kano_Array           array_value;
+	Code_Value_Procedure procedure_value;
 };
 
-template <typename T> T evaluation_value_get(Evaluation_Value &val)
+static_assert(sizeof(Interp_Value) == 16, "Interp_Value must fit in two registers");
+
+static inline bool interp_by_address(Code_Type *type)
 {
-	if (val.from_address)
-		return *(T *)val.from_address;
-	return *(T *)&val.imm;
+	return type->kind == CODE_TYPE_STRUCT || type->kind == CODE_TYPE_STATIC_ARRAY;
 }
-#define EvaluationTypeValue(val, type) evaluation_value_get<type>(val)
 
-template <typename T> T *evaluation_value_pointer(Evaluation_Value &val)
+// Reads a value of (type) stored at (address)
+static inline Interp_Value interp_load(uint8_t *address, Code_Type *type)
 {
-	if (val.from_address)
-		return (T *)val.from_address;
-	return (T *)&val.imm;
+	Interp_Value value;
+	if (interp_by_address(type))
+		value.pointer_value = address;
+	else if (type->runtime_size == sizeof(Kano_Int))
+		memcpy(&value, address, sizeof(Kano_Int));
+	else
+		memcpy(&value, address, type->runtime_size);
+	return value;
 }
-#define EvaluationTypePointer(val, type) evaluation_value_pointer<type>(val)
 
-static inline uint64_t interp_push_into_stack(Interpreter *interp, Evaluation_Value var, uint64_t offset)
+// Where the bytes of the value are, to copy it into memory
+static inline const void *interp_value_data(const Interp_Value &value, Code_Type *type)
 {
-	memmove(interp->stack + interp->stack_top + offset, EvaluationTypePointer(var, void *), var.type->runtime_size);
-	offset += var.type->runtime_size;
-	return offset;
+	if (interp_by_address(type))
+		return value.pointer_value;
+	return &value;
 }
 
-static inline uint64_t interp_push_into_stack_reduced(Interpreter *interp, Evaluation_Value var, uint64_t offset)
+// Writes a value of (type) to (address), scalars of the common size are copied without a call
+static inline void interp_store(uint8_t *address, const Interp_Value &value, Code_Type *type)
 {
-	offset -= var.type->runtime_size;
-	memmove(interp->stack + interp->stack_top + offset, EvaluationTypePointer(var, void *), var.type->runtime_size);
-	return offset;
+	if (type->runtime_size == sizeof(Kano_Int) && !interp_by_address(type))
+		memcpy(address, &value, sizeof(Kano_Int));
+	else
+		memcpy(address, interp_value_data(value, type), type->runtime_size);
 }
 
 //
 //
 //
 
-static Evaluation_Value interp_eval_root_expression(Interpreter *interp, Code_Node_Expression *expression);
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_root_expression(Interpreter *interp, Code_Node_Expression *expression);
 
-static Evaluation_Value interp_eval_address(Interpreter *interp, Code_Node_Address *node)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_expression(Interpreter *interp, Code_Node *root);
+
+template <Intercept_Policy Policy>
+static uint8_t *interp_eval_reference(Interpreter *interp, Code_Node *root);
+
+static inline Kano_Int interp_index_value(Interp_Value index, Code_Type *type)
+{
+	if (type->kind == CODE_TYPE_CHARACTER)
+		return (Kano_Int)index.char_value;
+	Assert(type->kind == CODE_TYPE_INTEGER);
+	return index.int_value;
+}
+
+// Address of a variable or of an element, procedure symbols are handled by interp_eval_expression
+template <Intercept_Policy Policy>
+static uint8_t *interp_eval_address(Interpreter *interp, Code_Node_Address *node)
 {
+	uint8_t *address = nullptr;
+
 	if (node->subscript)
 	{
 		Assert(node->address == nullptr);
 
-		auto expression = interp_eval_root_expression(interp, node->subscript->expression);
-		auto subscript = interp_eval_root_expression(interp, node->subscript->subscript);
-
-		Assert(subscript.type->kind == CODE_TYPE_INTEGER || subscript.type->kind == CODE_TYPE_CHARACTER);
-
-		uint8_t *address = nullptr;
+		auto expression_type = node->subscript->expression->type;
+		auto expression      = interp_eval_root_expression<Policy>(interp, node->subscript->expression);
+		auto subscript       = interp_eval_root_expression<Policy>(interp, node->subscript->subscript);
 
-		auto expr_type = expression.type->kind;
+		auto expr_type = expression_type->kind;
 		if (expr_type == CODE_TYPE_STATIC_ARRAY)
 		{
-			address = EvaluationTypePointer(expression, uint8_t);
+			address = expression.pointer_value;
 		}
 		else if (expr_type == CODE_TYPE_ARRAY_VIEW)
 		{
-			auto arr = EvaluationTypeValue(expression, Array_View<uint8_t>);
-			address = arr.data;
+			address = expression.array_value.data;
 		}
 		else
 		{
 			Assert(expr_type == CODE_TYPE_STRUCT);
-			auto arr = EvaluationTypeValue(expression, String);
-			address = arr.data;
+			address = ((String *)expression.pointer_value)->data;
 		}
 
 		Assert(address);
 
-		auto index = EvaluationTypeValue(subscript, Kano_Int);
-
 		address += node->offset;
-		address += node->type->runtime_size * index;
-
-		Evaluation_Value type_value;
-		type_value.type = node->type;
-		type_value.from_address = address;
-		return type_value;
+		address += node->subscript->type->runtime_size * interp_index_value(subscript, node->subscript->subscript->type);
 	}
 	else
 	{
@@ -114,81 +146,105 @@ static Evaluation_Value interp_eval_address(Interpreter *interp, Code_Node_Addre
 		{
 			offset += node->address->offset;
 			auto address_kind = node->address->kind;
-			
+
 			if (address_kind == Symbol_Address::STACK)
 			{
 				offset += interp->stack_top;
 			}
-			else if (address_kind == Symbol_Address::GLOBAL)
+			else
 			{
+				Assert(address_kind == Symbol_Address::GLOBAL);
 				memory = interp->global;
 			}
-			else if (address_kind == Symbol_Address::CODE)
-			{
-				Evaluation_Value type_value;
-				type_value.type = node->type;
-				type_value.imm.procedure_value.block = node->address->code;
-				type_value.imm.procedure_value.ccall = nullptr;
-				return type_value;
-			}
-			else if (address_kind == Symbol_Address::CCALL)
-			{
-				Evaluation_Value type_value;
-				type_value.type = node->type;
-				type_value.imm.procedure_value.ccall = node->address->ccall;
-				type_value.imm.procedure_value.block = nullptr;
-				return type_value;
-			}
 		}
 		else
 		{
 			offset += interp->stack_top;
 		}
 
-		Evaluation_Value type_value;
-		type_value.type = node->type;
-		type_value.from_address = memory + offset;
-		return type_value;
+		address = memory + offset;
+	}
+
+	for (int64_t index = 0; index < node->index_count; ++index)
+	{
+		auto expression = node->indices[index].expression;
+		auto subscript  = interp_eval_root_expression<Policy>(interp, expression);
+		address += node->indices[index].stride * interp_index_value(subscript, expression->type);
 	}
-}
 
-static Evaluation_Value interp_eval_root_expression(Interpreter *interp, Code_Node_Expression *root);
+	return address;
+}
 
-static Evaluation_Value interp_eval_offset(Interpreter *interp, Code_Node_Offset *root)
+static inline Interp_Value interp_procedure_value(const Symbol_Address *address)
 {
-	auto dest = interp_eval_root_expression(interp, root->expression);
-	dest.from_address += root->offset;
-	dest.type = root->type;
-	return dest;
+	Interp_Value value;
+	value.procedure_value.block = (address->kind == Symbol_Address::CODE) ? address->code : nullptr;
+	value.procedure_value.ccall = (address->kind == Symbol_Address::CCALL) ? address->ccall : nullptr;
+	return value;
 }
 
-static Evaluation_Value interp_eval_type_cast(Interpreter *interp, Code_Node_Type_Cast *cast)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_type_cast(Interpreter *interp, Code_Node_Type_Cast *cast)
 {
-	auto value = interp_eval_root_expression(interp, cast->child);
+	auto from  = cast->child->type;
+	auto value = interp_eval_root_expression<Policy>(interp, cast->child);
+
+	Interp_Value type_value;
 
-	Evaluation_Value type_value;
-	type_value.type = cast->type;
-	
 	switch (cast->type->kind)
 	{
 		case CODE_TYPE_REAL: {
-			Assert(value.type->kind == CODE_TYPE_INTEGER || value.type->kind == CODE_TYPE_CHARACTER);
-			type_value.imm.real_value = (Kano_Real)EvaluationTypeValue(value, Kano_Int);
+			if (from->kind == CODE_TYPE_INTEGER)
+			{
+				type_value.real_value = (Kano_Real)value.int_value;
+			}
+			else if (from->kind == CODE_TYPE_CHARACTER)
+			{
+				type_value.real_value = (Kano_Real)value.char_value;
+			}
+			else if (from->kind == CODE_TYPE_BOOL)
+			{
+				type_value.real_value = (Kano_Real)value.bool_value;
+			}
+			else
+			{
+				Unreachable();
+			}
+		}
+		break;
+
+		case CODE_TYPE_CHARACTER: {
+			if (from->kind == CODE_TYPE_BOOL)
+			{
+				type_value.char_value = (Kano_Char)value.bool_value;
+			}
+			else if (from->kind == CODE_TYPE_INTEGER)
+			{
+				type_value.char_value = (Kano_Char)value.int_value;
+			}
+			else if (from->kind == CODE_TYPE_REAL)
+			{
+				type_value.char_value = (Kano_Char)value.real_value;
+			}
+			else
+			{
+				Unreachable();
+			}
 		}
 		break;
 		
 		case CODE_TYPE_INTEGER: {
-			if (value.type->kind == CODE_TYPE_BOOL)
+			if (from->kind == CODE_TYPE_BOOL)
 			{
-				type_value.imm.int_value = EvaluationTypeValue(value, Kano_Bool);
+				type_value.int_value = value.bool_value;
 			}
-			else if (value.type->kind == CODE_TYPE_REAL)
+			else if (from->kind == CODE_TYPE_REAL)
 			{
-				type_value.imm.int_value = (Kano_Int)EvaluationTypeValue(value, Kano_Real);
+				type_value.int_value = (Kano_Int)value.real_value;
 			}
-			else if (value.type->kind == CODE_TYPE_CHARACTER) 
+			else if (from->kind == CODE_TYPE_CHARACTER) 
 			{
-				type_value.imm.int_value = (Kano_Int)EvaluationTypeValue(value, Kano_Char);
+				type_value.int_value = (Kano_Int)value.char_value;
 			}
 			else
 			{
@@ -198,17 +254,17 @@ static Evaluation_Value interp_eval_type_cast(Interpreter *interp, Code_Node_Typ
 		break;
 		
 		case CODE_TYPE_BOOL: {
-			if (value.type->kind == CODE_TYPE_INTEGER)
+			if (from->kind == CODE_TYPE_INTEGER)
 			{
-				type_value.imm.bool_value = EvaluationTypeValue(value, Kano_Int) != 0;
+				type_value.bool_value = value.int_value != 0;
 			}
-			else if (value.type->kind == CODE_TYPE_REAL)
+			else if (from->kind == CODE_TYPE_REAL)
 			{
-				type_value.imm.bool_value = EvaluationTypeValue(value, Kano_Real) != 0.0;
+				type_value.bool_value = value.real_value != 0.0;
 			}
-			else if (value.type->kind == CODE_TYPE_CHARACTER) 
+			else if (from->kind == CODE_TYPE_CHARACTER) 
 			{
-				type_value.imm.bool_value = EvaluationTypeValue(value, Kano_Char) != 0;
+				type_value.bool_value = value.char_value != 0;
 			}
 			else
 			{
@@ -218,16 +274,15 @@ static Evaluation_Value interp_eval_type_cast(Interpreter *interp, Code_Node_Typ
 		break;
 		
 		case CODE_TYPE_POINTER: {
-			Assert(value.type->kind == CODE_TYPE_POINTER);
-			type_value.imm.pointer_value = EvaluationTypeValue(value, uint8_t *);
+			Assert(from->kind == CODE_TYPE_POINTER);
+			type_value.pointer_value = value.pointer_value;
 		}
 		break;
 		
 		case CODE_TYPE_ARRAY_VIEW: {
-			Assert(value.type->kind == CODE_TYPE_STATIC_ARRAY);
-			type_value.imm.array_value.data   = EvaluationTypePointer(value, uint8_t);
-			auto type                         = (Code_Type_Static_Array *)value.type;
-			type_value.imm.array_value.length = type->element_count;
+			Assert(from->kind == CODE_TYPE_STATIC_ARRAY);
+			type_value.array_value.data   = value.pointer_value;
+			type_value.array_value.length = ((Code_Type_Static_Array *)from)->element_count;
 		}
 		break;
 		
@@ -237,1285 +292,994 @@ static Evaluation_Value interp_eval_type_cast(Interpreter *interp, Code_Node_Typ
 	return type_value;
 }
 
-static Evaluation_Value interp_eval_expression(Interpreter *interp, Code_Node *root);
+template <Intercept_Policy Policy>
+static void interp_eval_arguments(Interpreter *interp, Code_Node_Procedure_Call *root);
 
-static Evaluation_Value interp_eval_return(Interpreter *interp, Code_Node_Return *node)
+template <Intercept_Policy Policy>
+static void interp_eval_return(Interpreter *interp, Code_Node_Return *node)
 {
-	if (node->expression)
+	// The traced runs keep every frame, the procedure intercepts report the callstack
+	if constexpr (!(Policy & INTERCEPT_POLICY_PROCEDURE))
 	{
-		auto result = interp_eval_expression(interp, node->expression);
-		interp_push_into_stack(interp, result, 0);
-		interp->return_count += 1;
-		return result;
+		if (node->tail_call)
+		{
+			// The arguments are staged where the call would have placed them, the enclosing
+			// interp_eval_procedure_call moves them into the frame once this procedure has returned
+			interp_eval_arguments<Policy>(interp, node->tail_call);
+			interp->tail_call = node->tail_call;
+			return;
+		}
 	}
-	interp->return_count += 1;
-	return Evaluation_Value{};
-}
 
-static void interp_eval_break(Interpreter *interp, Code_Node_Break *node)
-{
-	interp->break_count += 1;
-}
-
-static void interp_eval_continue(Interpreter *interp, Code_Node_Continue *node)
-{
-	interp->continue_count += 1;
+	if (node->expression)
+	{
+		auto type   = node->expression->type;
+		auto result = interp_eval_expression<Policy>(interp, node->expression);
+		memmove(interp->stack + interp->stack_top, interp_value_data(result, type), type->runtime_size);
+	}
 }
 
-static Evaluation_Value interp_eval_literal(Interpreter *interp, Code_Node_Literal *node)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_unary_operator(Interpreter *interp, Code_Node_Unary_Operator *root)
 {
-	Evaluation_Value type_value;
-	type_value.from_address = (uint8_t *)&node->data;
-	type_value.type    = node->type;
-	return type_value;
-}
-
-static Evaluation_Value interp_eval_expression(Interpreter *interp, Code_Node *root);
+	Interp_Value r;
 
-static Evaluation_Value interp_eval_unary_operator(Interpreter *interp, Code_Node_Unary_Operator *root)
-{
-	switch (root->op_kind)
+	switch (root->operation)
 	{
-		case UNARY_OPERATOR_LOGICAL_NOT: {
-			auto type_value = interp_eval_expression(interp, root->child);
-			auto ref        = EvaluationTypePointer(type_value, bool);
-			*ref            = !*ref;
-			return type_value;
-		}
-		break;
-		
-		case UNARY_OPERATOR_BITWISE_NOT: {
-			auto type_value = interp_eval_expression(interp, root->child);
-			auto ref        = EvaluationTypePointer(type_value, int64_t);
-			*ref            = ~*ref;
-			return type_value;
+		case UNARY_OPERATION_PLUS: {
+			return interp_eval_expression<Policy>(interp, root->child);
 		}
 		break;
-		
-		case UNARY_OPERATOR_PLUS: {
-			auto type_value = interp_eval_expression(interp, root->child);
-			return type_value;
+
+		case UNARY_OPERATION_MINUS_CHAR: {
+			r.char_value = -interp_eval_expression<Policy>(interp, root->child).char_value;
+			return r;
 		}
 		break;
-		
-		case UNARY_OPERATOR_MINUS: {
-			auto value = interp_eval_expression(interp, root->child);
-			
-			if (value.type->kind == CODE_TYPE_INTEGER)
-			{
-				
-				Evaluation_Value r;
-				r.imm.int_value = -EvaluationTypeValue(value, Kano_Int);
-				r.type          = root->type;
-				return r;
-			}
-			else if (value.type->kind == CODE_TYPE_REAL)
-			{
-				Evaluation_Value r;
-				r.imm.real_value = -EvaluationTypeValue(value, Kano_Real);
-				r.type           = root->type;
-				return r;
-			}
-			
-			Unreachable();
+
+		case UNARY_OPERATION_MINUS_INT: {
+			r.int_value = -interp_eval_expression<Policy>(interp, root->child).int_value;
+			return r;
 		}
 		break;
-		
-		case UNARY_OPERATOR_DEREFERENCE:  {
-			Evaluation_Value pointer = interp_eval_expression(interp, root->child);
-
-			Evaluation_Value type_value;
-			type_value.type    = root->type;
-			type_value.from_address = EvaluationTypeValue(pointer, uint8_t *);
-			
-			return type_value;
+
+		case UNARY_OPERATION_MINUS_REAL: {
+			r.real_value = -interp_eval_expression<Policy>(interp, root->child).real_value;
+			return r;
 		}
 		break;
 
-		case UNARY_OPERATOR_POINTER_TO: {
-			Assert(root->child->kind == CODE_NODE_ADDRESS);
-			
-			auto address = (Code_Node_Address *)root->child;
-
-			auto pointer = interp_eval_address(interp, address);
-			Assert(pointer.from_address);
-			
-			Evaluation_Value type_value;
-			type_value.type = root->type;
-			type_value.imm.pointer_value = pointer.from_address;
-			
-			return type_value;
+		case UNARY_OPERATION_BITWISE_NOT_CHAR: {
+			r.char_value = ~interp_eval_expression<Policy>(interp, root->child).char_value;
+			return r;
 		}
 		break;
 
-		NoDefaultCase();
-	}
-	
-	Unreachable();
-	return Evaluation_Value{};
-}
-
-typedef Evaluation_Value (*BinaryOperatorProc)(Evaluation_Value a, Evaluation_Value b, Code_Type *type);
-
-typedef Kano_Int (*BinaryOperatorIntProc)(Kano_Int a, Kano_Int b);
-
-static Evaluation_Value binary_add(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (type->kind)
-	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.char_value = EvaluationTypeValue(a, Kano_Char) + EvaluationTypeValue(b, Kano_Char);
+		case UNARY_OPERATION_BITWISE_NOT_INT: {
+			r.int_value = ~interp_eval_expression<Policy>(interp, root->child).int_value;
 			return r;
 		}
 		break;
 
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.int_value = EvaluationTypeValue(a, Kano_Int) + EvaluationTypeValue(b, Kano_Int);
+		case UNARY_OPERATION_LOGICAL_NOT_BOOL: {
+			r.bool_value = !interp_eval_expression<Policy>(interp, root->child).bool_value;
 			return r;
 		}
 		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			r.imm.real_value = EvaluationTypeValue(a, Kano_Real) + EvaluationTypeValue(b, Kano_Real);
-			return r;
+
+		case UNARY_OPERATION_DEREFERENCE: {
+			auto pointer = interp_eval_expression<Policy>(interp, root->child).pointer_value;
+			return interp_load(pointer, root->type);
 		}
 		break;
-		case CODE_TYPE_POINTER: {
-			Assert(a.type->kind == CODE_TYPE_POINTER && b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.pointer_value = EvaluationTypeValue(a, uint8_t *) + EvaluationTypeValue(b, Kano_Int);
+
+		case UNARY_OPERATION_POINTER_TO: {
+			Assert(root->child->kind == CODE_NODE_ADDRESS);
+			r.pointer_value = interp_eval_address<Policy>(interp, (Code_Node_Address *)root->child);
 			return r;
 		}
 		break;
+
+		NoDefaultCase();
 	}
 	
 	Unreachable();
 	return r;
 }
 
-static Evaluation_Value binary_sub(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+typedef Interp_Value (*BinaryOperatorProc)(Interp_Value a, Interp_Value b);
+typedef void (*CompoundOperatorProc)(uint8_t *a, Interp_Value b);
+
+// @Note: The resolver has already picked the operation from the operand types,
+// so each handler only ever sees the exact types it was generated for
+
+#define BinaryOperation(name, a_member, b_member, result, member, op)              \
+	static Interp_Value binary_##name(Interp_Value a, Interp_Value b)             \
+	{                                                                             \
+		Interp_Value r;                                                           \
+		r.member = (result)(a.a_member op b.b_member);                            \
+		return r;                                                                 \
+	}
+
+#define CompoundOperation(name, a_type, b_member, op)                             \
+	static void binary_##name(uint8_t *a, Interp_Value b)                         \
+	{                                                                             \
+		*(a_type *)a op b.b_member;                                               \
+	}
+
+BinaryOperation(add_char, char_value, char_value, Kano_Char, char_value, +)
+BinaryOperation(add_int, int_value, int_value, Kano_Int, int_value, +)
+BinaryOperation(add_real, real_value, real_value, Kano_Real, real_value, +)
+BinaryOperation(add_pointer, pointer_value, int_value, uint8_t *, pointer_value, +)
+BinaryOperation(sub_char, char_value, char_value, Kano_Char, char_value, -)
+BinaryOperation(sub_int, int_value, int_value, Kano_Int, int_value, -)
+BinaryOperation(sub_real, real_value, real_value, Kano_Real, real_value, -)
+BinaryOperation(sub_pointer, pointer_value, int_value, uint8_t *, pointer_value, -)
+BinaryOperation(mul_char, char_value, char_value, Kano_Char, char_value, *)
+BinaryOperation(mul_int, int_value, int_value, Kano_Int, int_value, *)
+BinaryOperation(mul_real, real_value, real_value, Kano_Real, real_value, *)
+BinaryOperation(div_char, char_value, char_value, Kano_Char, char_value, /)
+BinaryOperation(div_int, int_value, int_value, Kano_Int, int_value, /)
+BinaryOperation(div_real, real_value, real_value, Kano_Real, real_value, /)
+BinaryOperation(mod_char, char_value, char_value, Kano_Char, char_value, %)
+BinaryOperation(mod_int, int_value, int_value, Kano_Int, int_value, %)
+BinaryOperation(shr_char, char_value, char_value, Kano_Char, char_value, >>)
+BinaryOperation(shr_int, int_value, int_value, Kano_Int, int_value, >>)
+BinaryOperation(shl_char, char_value, char_value, Kano_Char, char_value, <<)
+BinaryOperation(shl_int, int_value, int_value, Kano_Int, int_value, <<)
+BinaryOperation(and_char, char_value, char_value, Kano_Char, char_value, &)
+BinaryOperation(and_int, int_value, int_value, Kano_Int, int_value, &)
+BinaryOperation(xor_char, char_value, char_value, Kano_Char, char_value, ^)
+BinaryOperation(xor_int, int_value, int_value, Kano_Int, int_value, ^)
+BinaryOperation(or_char, char_value, char_value, Kano_Char, char_value, |)
+BinaryOperation(or_int, int_value, int_value, Kano_Int, int_value, |)
+
+BinaryOperation(gt_char, char_value, char_value, Kano_Bool, bool_value, >)
+BinaryOperation(gt_int, int_value, int_value, Kano_Bool, bool_value, >)
+BinaryOperation(gt_real, real_value, real_value, Kano_Bool, bool_value, >)
+BinaryOperation(gt_pointer, pointer_value, pointer_value, Kano_Bool, bool_value, >)
+BinaryOperation(lt_char, char_value, char_value, Kano_Bool, bool_value, <)
+BinaryOperation(lt_int, int_value, int_value, Kano_Bool, bool_value, <)
+BinaryOperation(lt_real, real_value, real_value, Kano_Bool, bool_value, <)
+BinaryOperation(lt_pointer, pointer_value, pointer_value, Kano_Bool, bool_value, <)
+BinaryOperation(ge_char, char_value, char_value, Kano_Bool, bool_value, >=)
+BinaryOperation(ge_int, int_value, int_value, Kano_Bool, bool_value, >=)
+BinaryOperation(ge_real, real_value, real_value, Kano_Bool, bool_value, >=)
+BinaryOperation(ge_pointer, pointer_value, pointer_value, Kano_Bool, bool_value, >=)
+BinaryOperation(le_char, char_value, char_value, Kano_Bool, bool_value, <=)
+BinaryOperation(le_int, int_value, int_value, Kano_Bool, bool_value, <=)
+BinaryOperation(le_real, real_value, real_value, Kano_Bool, bool_value, <=)
+BinaryOperation(le_pointer, pointer_value, pointer_value, Kano_Bool, bool_value, <=)
+BinaryOperation(eq_char, char_value, char_value, Kano_Bool, bool_value, ==)
+BinaryOperation(eq_int, int_value, int_value, Kano_Bool, bool_value, ==)
+BinaryOperation(eq_real, real_value, real_value, Kano_Bool, bool_value, ==)
+BinaryOperation(eq_bool, bool_value, bool_value, Kano_Bool, bool_value, ==)
+BinaryOperation(eq_pointer, pointer_value, pointer_value, Kano_Bool, bool_value, ==)
+BinaryOperation(ne_char, char_value, char_value, Kano_Bool, bool_value, !=)
+BinaryOperation(ne_int, int_value, int_value, Kano_Bool, bool_value, !=)
+BinaryOperation(ne_real, real_value, real_value, Kano_Bool, bool_value, !=)
+BinaryOperation(ne_bool, bool_value, bool_value, Kano_Bool, bool_value, !=)
+BinaryOperation(ne_pointer, pointer_value, pointer_value, Kano_Bool, bool_value, !=)
+
+CompoundOperation(cadd_char, Kano_Char, char_value, +=)
+CompoundOperation(cadd_int, Kano_Int, int_value, +=)
+CompoundOperation(cadd_real, Kano_Real, real_value, +=)
+CompoundOperation(cadd_pointer, uint8_t *, int_value, +=)
+CompoundOperation(csub_char, Kano_Char, char_value, -=)
+CompoundOperation(csub_int, Kano_Int, int_value, -=)
+CompoundOperation(csub_real, Kano_Real, real_value, -=)
+CompoundOperation(csub_pointer, uint8_t *, int_value, -=)
+CompoundOperation(cmul_char, Kano_Char, char_value, *=)
+CompoundOperation(cmul_int, Kano_Int, int_value, *=)
+CompoundOperation(cmul_real, Kano_Real, real_value, *=)
+CompoundOperation(cdiv_char, Kano_Char, char_value, /=)
+CompoundOperation(cdiv_int, Kano_Int, int_value, /=)
+CompoundOperation(cdiv_real, Kano_Real, real_value, /=)
+CompoundOperation(cmod_char, Kano_Char, char_value, %=)
+CompoundOperation(cmod_int, Kano_Int, int_value, %=)
+CompoundOperation(crs_char, Kano_Char, char_value, >>=)
+CompoundOperation(crs_int, Kano_Int, int_value, >>=)
+CompoundOperation(cls_char, Kano_Char, char_value, <<=)
+CompoundOperation(cls_int, Kano_Int, int_value, <<=)
+CompoundOperation(cand_char, Kano_Char, char_value, &=)
+CompoundOperation(cand_int, Kano_Int, int_value, &=)
+CompoundOperation(cxor_char, Kano_Char, char_value, ^=)
+CompoundOperation(cxor_int, Kano_Int, int_value, ^=)
+CompoundOperation(cor_char, Kano_Char, char_value, |=)
+CompoundOperation(cor_int, Kano_Int, int_value, |=)
+
+#undef CompoundOperation
+#undef BinaryOperation
+
+// Indexed by Binary_Operation, up to the compound operations
+static BinaryOperatorProc BinaryOperators[] = {
+	binary_add_char,    binary_add_int,     binary_add_real,    binary_add_pointer, binary_sub_char,   binary_sub_int,
+	binary_sub_real,    binary_sub_pointer, binary_mul_char,    binary_mul_int,     binary_mul_real,   binary_div_char,
+	binary_div_int,     binary_div_real,    binary_mod_char,    binary_mod_int,     binary_shr_char,   binary_shr_int,
+	binary_shl_char,    binary_shl_int,     binary_and_char,    binary_and_int,     binary_xor_char,   binary_xor_int,
+	binary_or_char,     binary_or_int,
+
+	binary_gt_char,     binary_gt_int,      binary_gt_real,     binary_gt_pointer,  binary_lt_char,    binary_lt_int,
+	binary_lt_real,     binary_lt_pointer,  binary_ge_char,     binary_ge_int,      binary_ge_real,    binary_ge_pointer,
+	binary_le_char,     binary_le_int,      binary_le_real,     binary_le_pointer,  binary_eq_char,    binary_eq_int,
+	binary_eq_real,     binary_eq_bool,     binary_eq_pointer,  binary_ne_char,     binary_ne_int,     binary_ne_real,
+	binary_ne_bool,     binary_ne_pointer };
+
+static_assert(ArrayCount(BinaryOperators) == BINARY_OPERATION_COMPOUND_ADD_CHAR, "BinaryOperators must match Binary_Operation");
+
+// Indexed by Binary_Operation, starting at BINARY_OPERATION_COMPOUND_ADD_CHAR
+static CompoundOperatorProc CompoundOperators[] = {
+	binary_cadd_char,   binary_cadd_int,    binary_cadd_real,   binary_cadd_pointer, binary_csub_char, binary_csub_int,
+	binary_csub_real,   binary_csub_pointer, binary_cmul_char,  binary_cmul_int,    binary_cmul_real,  binary_cdiv_char,
+	binary_cdiv_int,    binary_cdiv_real,   binary_cmod_char,   binary_cmod_int,    binary_crs_char,   binary_crs_int,
+	binary_cls_char,    binary_cls_int,     binary_cand_char,   binary_cand_int,    binary_cxor_char,  binary_cxor_int,
+	binary_cor_char,    binary_cor_int };
+
+// Logical operators are short circuited by interp_eval_binary_operator
+static_assert(ArrayCount(CompoundOperators) == BINARY_OPERATION_LOGICAL_AND_CHAR - BINARY_OPERATION_COMPOUND_ADD_CHAR,
+			  "CompoundOperators must match Binary_Operation");
+
+static inline bool interp_truth(Interp_Value value, Code_Type *type)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
 	switch (type->kind)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.char_value = EvaluationTypeValue(a, Kano_Char) - EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-							break;
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.int_value = EvaluationTypeValue(a, Kano_Int) - EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			r.imm.real_value = EvaluationTypeValue(a, Kano_Real) - EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
-		case CODE_TYPE_POINTER: {
-			Assert(a.type->kind == CODE_TYPE_POINTER && b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.pointer_value = EvaluationTypeValue(a, uint8_t *) - EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
+		case CODE_TYPE_BOOL: return value.bool_value;
+		case CODE_TYPE_CHARACTER: return value.char_value != 0;
+		case CODE_TYPE_INTEGER: return value.int_value != 0;
+		case CODE_TYPE_REAL: return value.real_value != 0.0;
+		case CODE_TYPE_POINTER: return value.pointer_value != nullptr;
+		NoDefaultCase();
 	}
-	
 	Unreachable();
-	return r;
+	return false;
 }
 
-static Evaluation_Value binary_mul(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+// Evaluates a condition straight into a branch without materializing the intermediate bools,
+// the right operand of && and || is only evaluated when the left operand does not decide the result
+template <Intercept_Policy Policy>
+static bool interp_eval_condition(Interpreter *interp, Code_Node *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (type->kind)
+	switch (root->kind)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.char_value = EvaluationTypeValue(a, Kano_Char) * EvaluationTypeValue(b, Kano_Char);
-			return r;
+		case CODE_NODE_EXPRESSION: {
+			return interp_eval_condition<Policy>(interp, ((Code_Node_Expression *)root)->child);
+		}
+
+		case CODE_NODE_UNARY_OPERATOR: {
+			auto node = (Code_Node_Unary_Operator *)root;
+			if (node->op_kind == UNARY_OPERATOR_LOGICAL_NOT)
+				return !interp_eval_condition<Policy>(interp, node->child);
 		}
 		break;
 
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.int_value = EvaluationTypeValue(a, Kano_Int) * EvaluationTypeValue(b, Kano_Int);
-			return r;
+		case CODE_NODE_BINARY_OPERATOR: {
+			auto node = (Code_Node_Binary_Operator *)root;
+			if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND)
+				return interp_eval_condition<Policy>(interp, node->left) && interp_eval_condition<Policy>(interp, node->right);
+			if (node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
+				return interp_eval_condition<Policy>(interp, node->left) || interp_eval_condition<Policy>(interp, node->right);
 		}
 		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			r.imm.real_value = EvaluationTypeValue(a, Kano_Real) * EvaluationTypeValue(b, Kano_Real);
-			return r;
+
+		case CODE_NODE_TYPE_CAST: {
+			auto node = (Code_Node_Type_Cast *)root;
+			if (node->type->kind == CODE_TYPE_BOOL)
+				return interp_eval_condition<Policy>(interp, node->child);
 		}
 		break;
 	}
-	
-	Unreachable();
-	return r;
+
+	return interp_truth(interp_eval_expression<Policy>(interp, root), root->type);
 }
 
-static Evaluation_Value binary_div(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_binary_operator(Interpreter *interp, Code_Node_Binary_Operator *node)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (type->kind)
+	if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND || node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.char_value = EvaluationTypeValue(a, Kano_Char) / EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-		break;
+		Interp_Value r;
+		r.bool_value = interp_eval_condition<Policy>(interp, node);
+		return r;
+	}
 
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.int_value = EvaluationTypeValue(a, Kano_Int) / EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			r.imm.real_value = EvaluationTypeValue(a, Kano_Real) / EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
+	// @Note: The right operand is evaluated first and is held by value, so procedures called while
+	// evaluating the left operand can not change it
+	auto b = interp_eval_expression<Policy>(interp, node->right);
+
+	if (node->operation >= BINARY_OPERATION_COMPOUND_ADD_CHAR)
+	{
+		auto a = interp_eval_reference<Policy>(interp, node->left);
+		CompoundOperators[node->operation - BINARY_OPERATION_COMPOUND_ADD_CHAR](a, b);
+		return interp_load(a, node->type);
 	}
-	
-	Unreachable();
-	return r;
+
+	auto a = interp_eval_expression<Policy>(interp, node->left);
+	return BinaryOperators[node->operation](a, b);
 }
 
-static Evaluation_Value binary_mod(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_assignment(Interpreter *interp, Code_Node_Assignment *node)
 {
-	Evaluation_Value r;
-	r.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-
-	if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.char_value = EvaluationTypeValue(a, Kano_Char) % EvaluationTypeValue(b, Kano_Char);
-	else
-		r.imm.int_value = EvaluationTypeValue(a, Kano_Int) % EvaluationTypeValue(b, Kano_Int);
-	return r;
+	auto type  = node->value->type;
+	auto value = interp_eval_root_expression<Policy>(interp, node->value);
+	auto dst   = interp_eval_reference<Policy>(interp, node->destination);
+	interp_store(dst, value, type);
+	return value;
 }
 
-static Evaluation_Value binary_rs(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_block(Interpreter *interp, Code_Node_Block *root, bool isproc);
+
+// Places the variadics and the parameters of the call in the callee frame, which starts at (frame_offset)
+// from the current stack top
+template <Intercept_Policy Policy>
+static void interp_eval_arguments(Interpreter *interp, Code_Node_Procedure_Call *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
+	// @Note: The frame layout is computed by the resolver, arguments are evaluated with the caller's
+	// stack top and copied straight into their slot
+	Assert(interp->stack_top % CODE_FRAME_ALIGNMENT == 0);
 
-	if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.char_value = EvaluationTypeValue(a, Kano_Char) >> EvaluationTypeValue(b, Kano_Char);
-	else
-		r.imm.int_value = EvaluationTypeValue(a, Kano_Int) >> EvaluationTypeValue(b, Kano_Int);
-	return r;
+	{
+		// @Note: The value is copied before the Code_Type * is written, because a procedure called while
+		// evaluating the variadic places its result at the start of the variadic's pair
+		auto variadics = interp->stack + interp->stack_top + root->stack_top;
+		for (int64_t i = 0; i < root->variadic_count; ++i)
+		{
+			auto param = root->variadics[i];
+			auto var   = interp_eval_root_expression<Policy>(interp, param);
+			memmove(variadics + sizeof(Code_Type *), interp_value_data(var, param->type), param->type->runtime_size);
+			memcpy(variadics, &param->type, sizeof(Code_Type *));
+			variadics += sizeof(Code_Type *) + param->type->runtime_size;
+		}
+	}
+
+	auto frame = interp->stack + interp->stack_top + root->frame_offset;
+	for (int64_t index = 0; index < root->parameter_count; ++index)
+	{
+		auto param = root->parameters[index];
+		auto var   = interp_eval_root_expression<Policy>(interp, param);
+		memmove(frame + root->parameter_offsets[index], interp_value_data(var, param->type), param->type->runtime_size);
+	}
 }
 
-static Evaluation_Value binary_ls(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+// Moves the parameters of a tail call, staged by interp_eval_return, down into the current frame
+static void interp_reuse_frame(Interpreter *interp, Code_Node_Procedure_Call *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-
-	if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.char_value = EvaluationTypeValue(a, Kano_Char) << EvaluationTypeValue(b, Kano_Char);
-	else
-		r.imm.int_value = EvaluationTypeValue(a, Kano_Int) << EvaluationTypeValue(b, Kano_Int);
-	return r;
+	if (!root->parameter_count)
+		return;
+
+	auto last  = root->parameter_count - 1;
+	auto begin = root->parameter_offsets[0];
+	auto end   = root->parameter_offsets[last] + root->parameters[last]->type->runtime_size;
+	auto frame = interp->stack + interp->stack_top;
+	memmove(frame + begin, frame + root->frame_offset + begin, end - begin);
 }
 
-static Evaluation_Value binary_and(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+// Runs the body of a procedure whose frame is at the current stack top
+template <Intercept_Policy Policy>
+static inline void interp_run_block(Interpreter *interp, Code_Node_Block *block)
 {
-	Evaluation_Value r;
-	r.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
+	// @Note: Frames larger than the guard region would step over it, so the frame is checked as a whole
+	if (interp->stack_top + block->frame_size > interp->stack_size)
+		interp_runtime_error(interp, "Stack overflow");
 
-	if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.char_value = EvaluationTypeValue(a, Kano_Char) & EvaluationTypeValue(b, Kano_Char);
-	else
-		r.imm.int_value = EvaluationTypeValue(a, Kano_Int) & EvaluationTypeValue(b, Kano_Int);
-	return r;
+	if constexpr (Policy == INTERCEPT_POLICY_NONE)
+	{
+		if (interp->jit)
+		{
+			if (auto code = jit_hot_procedure(interp->jit, block))
+			{
+				code(interp, interp->stack + interp->stack_top);
+				return;
+			}
+		}
+	}
+
+	interp_eval_block<Policy>(interp, block, true);
 }
 
-static Evaluation_Value binary_xor(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static void interp_invoke(Interpreter *interp, Code_Value_Procedure procedure)
 {
-	Evaluation_Value r;
-	r.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
+	if (procedure.block)
+	{
+		interp_run_block<Policy>(interp, procedure.block);
+
+		// @Note: Tail calls unwind the returning procedure first and then run in its frame from here,
+		// so recursion in tail position does not nest native calls
+		while (interp->tail_call)
+		{
+			auto call = interp->tail_call;
+			interp->tail_call = nullptr;
 
-	if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.char_value = EvaluationTypeValue(a, Kano_Char) ^ EvaluationTypeValue(b, Kano_Char);
+			interp_reuse_frame(interp, call);
+			interp->current_procedure = call->procedure_type;
+			interp_run_block<Policy>(interp, call->callee->code);
+		}
+	}
 	else
-		r.imm.int_value = EvaluationTypeValue(a, Kano_Int) ^ EvaluationTypeValue(b, Kano_Int);
-	return r;
+	{
+		procedure.ccall(interp);
+	}
 }
 
-static Evaluation_Value binary_or(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_procedure_call(Interpreter *interp, Code_Node_Procedure_Call *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
+	// @Note: The tree walker recurses natively for every call, so deep recursion is stopped before the
+	// native stack runs out, the interpreter stack is checked when the callee frame is entered
+	if (InterpNativeStackPointer() < interp_native_limit)
+		interp_runtime_error(interp, "Stack overflow");
+
+	auto prev_top = interp->stack_top;
+	auto new_top  = prev_top + root->frame_offset;
+
+	interp_eval_arguments<Policy>(interp, root);
 
-	if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.char_value = EvaluationTypeValue(a, Kano_Char) | EvaluationTypeValue(b, Kano_Char);
+	Code_Value_Procedure procedure;
+	if (root->callee)
+	{
+		procedure.block = (root->callee->kind == Symbol_Address::CODE) ? root->callee->code : nullptr;
+		procedure.ccall = (root->callee->kind == Symbol_Address::CCALL) ? root->callee->ccall : nullptr;
+	}
 	else
-		r.imm.int_value = EvaluationTypeValue(a, Kano_Int) | EvaluationTypeValue(b, Kano_Int);
-	return r;
+	{
+		// @Note: The procedure value already holds the block, which carries its own native code, so
+		// there is nothing left for an inline cache to resolve here
+		procedure = interp_eval_root_expression<Policy>(interp, root->procedure).procedure_value;
+	}
+	
+	auto prev_proc = interp->current_procedure;
+	interp->stack_top = new_top;
+	interp->current_procedure = root->procedure_type;
+
+	interp_invoke<Policy>(interp, procedure);
+
+	// @Note: Structs and static arrays are returned by the address of the result in the callee frame
+	Interp_Value result = {};
+	if (root->type)
+		result = interp_load(interp->stack + interp->stack_top, root->type);
+
+	interp->current_procedure = prev_proc;
+	interp->stack_top = prev_top;
+	
+	return result;
 }
 
-static Evaluation_Value binary_gt(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_expression(Interpreter *interp, Code_Node *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (a.type->kind)
+	switch (root->kind)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Char) > EvaluationTypeValue(b, Kano_Char);
-			return r;
+		case CODE_NODE_LITERAL: return interp_load((uint8_t *)&((Code_Node_Literal *)root)->data, root->type);
+		case CODE_NODE_UNARY_OPERATOR: return interp_eval_unary_operator<Policy>(interp, (Code_Node_Unary_Operator *)root);
+		case CODE_NODE_BINARY_OPERATOR: return interp_eval_binary_operator<Policy>(interp, (Code_Node_Binary_Operator *)root);
+		case CODE_NODE_EXPRESSION: return interp_eval_expression<Policy>(interp, ((Code_Node_Expression *)root)->child);
+
+		case CODE_NODE_ADDRESS: {
+			auto node = (Code_Node_Address *)root;
+			if (node->address && (node->address->kind == Symbol_Address::CODE || node->address->kind == Symbol_Address::CCALL))
+				return interp_procedure_value(node->address);
+			return interp_load(interp_eval_address<Policy>(interp, node), root->type);
 		}
-		break;
 
-		case CODE_TYPE_INTEGER: {
-			Assert(b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Int) > EvaluationTypeValue(b, Kano_Int);
-			return r;
+		case CODE_NODE_OFFSET: {
+			auto node = (Code_Node_Offset *)root;
+			return interp_load(interp_eval_reference<Policy>(interp, node->expression) + node->offset, root->type);
 		}
-		break;
+
+		case CODE_NODE_ASSIGNMENT: return interp_eval_assignment<Policy>(interp, (Code_Node_Assignment *)root);
+		case CODE_NODE_TYPE_CAST: return interp_eval_type_cast<Policy>(interp, (Code_Node_Type_Cast *)root);
+		case CODE_NODE_IF: return interp_eval_expression<Policy>(interp, (Code_Node *)root);
+		case CODE_NODE_PROCEDURE_CALL: return interp_eval_procedure_call<Policy>(interp, (Code_Node_Procedure_Call *)root);
 		
-		case CODE_TYPE_REAL: {
-			Assert(b.type->kind == CODE_TYPE_REAL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Real) > EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
+		// @Note: Return, break and continue only appear as statements, see interp_eval_statement
+		NoDefaultCase();
 	}
 	
 	Unreachable();
-	return r;
+	return Interp_Value{};
 }
 
-static Evaluation_Value binary_lt(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Value interp_eval_root_expression(Interpreter *interp, Code_Node_Expression *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (a.type->kind)
-	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Char) < EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-		break;
-
-		case CODE_TYPE_INTEGER: {
-			Assert(b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Int) < EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(b.type->kind == CODE_TYPE_REAL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Real) < EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
-	}
-	
-	Unreachable();
-	return r;
+	return interp_eval_expression<Policy>(interp, root->child);
 }
 
-static Evaluation_Value binary_ge(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+// Address of the storage an expression refers to, for assignments and member access
+template <Intercept_Policy Policy>
+static uint8_t *interp_eval_reference(Interpreter *interp, Code_Node *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (a.type->kind)
+	switch (root->kind)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Char) >= EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-		break;
+		case CODE_NODE_EXPRESSION: return interp_eval_reference<Policy>(interp, ((Code_Node_Expression *)root)->child);
+		case CODE_NODE_ADDRESS: return interp_eval_address<Policy>(interp, (Code_Node_Address *)root);
 
-		case CODE_TYPE_INTEGER: {
-			Assert(b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Int) >= EvaluationTypeValue(b, Kano_Int);
-			return r;
+		case CODE_NODE_OFFSET: {
+			auto node = (Code_Node_Offset *)root;
+			return interp_eval_reference<Policy>(interp, node->expression) + node->offset;
 		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(b.type->kind == CODE_TYPE_REAL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Real) >= EvaluationTypeValue(b, Kano_Real);
-			return r;
+
+		case CODE_NODE_UNARY_OPERATOR: {
+			auto node = (Code_Node_Unary_Operator *)root;
+			if (node->operation == UNARY_OPERATION_DEREFERENCE)
+				return interp_eval_expression<Policy>(interp, node->child).pointer_value;
 		}
 		break;
 	}
-	
-	Unreachable();
-	return r;
+
+	// Any other struct or static array, like the result of a call or a string literal, is already an address
+	Assert(interp_by_address(root->type));
+	return interp_eval_expression<Policy>(interp, root).pointer_value;
 }
 
-static Evaluation_Value binary_le(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (a.type->kind)
-	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Char) <= EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-		break;
+int64_t interp_evaluate_constant_expression(Code_Node_Expression *root) {
+	// @Note: Constant expressions never touch the stack or the globals, so nothing is reserved
+	Interpreter interp;
+	interp_init(&interp, nullptr, 0, 0);
 
-		case CODE_TYPE_INTEGER: {
-			Assert(b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Int) <= EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(b.type->kind == CODE_TYPE_REAL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Real) <= EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
-	}
-	
-	Unreachable();
-	return r;
+	Assert(root->type->kind == CODE_TYPE_INTEGER || root->type->kind == CODE_TYPE_CHARACTER);
+
+	auto value = interp_eval_root_expression<INTERCEPT_POLICY_NONE>(&interp, root);
+
+	if (root->type->kind == CODE_TYPE_INTEGER)
+		return (int64_t)value.int_value;
+	else if (root->type->kind == CODE_TYPE_CHARACTER)
+		return (int64_t)value.char_value;
+	else
+		Unreachable();
+	return 0;
 }
 
-static Evaluation_Value binary_cmp(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (a.type->kind)
-	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Char) == EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-		break;
+// Only used for trees made of literals and operators, which never touch the stack or the globals
+Code_Value interp_evaluate_constant_value(Code_Node *root) {
+	Interpreter interp;
 
-		case CODE_TYPE_INTEGER: {
-			Assert(b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Int) == EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(b.type->kind == CODE_TYPE_REAL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Real) == EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_BOOL: {
-			Assert(b.type->kind == CODE_TYPE_BOOL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Bool) == EvaluationTypeValue(b, Kano_Bool);
-			return r;
-		}
-		break;
+	auto value = interp_eval_expression<INTERCEPT_POLICY_NONE>(&interp, root);
 
-		case CODE_TYPE_POINTER: {
-			r.imm.bool_value = (EvaluationTypeValue(a, uint8_t *) == EvaluationTypeValue(b, uint8_t *));
-			return r;
-		}
-		break;
-	}
-	
-	Unreachable();
-	return r;
+	Code_Value result;
+	memcpy(&result, interp_value_data(value, root->type), root->type->runtime_size);
+	return result;
 }
 
-static Evaluation_Value binary_ncmp(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static inline void interp_intercept_statement(Interpreter *interp, Code_Node_Statement *root)
 {
-	Evaluation_Value r;
-	r.type = type;
-	
-	switch (a.type->kind)
-	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Char) != EvaluationTypeValue(b, Kano_Char);
-			return r;
-		}
-		break;
-
-		case CODE_TYPE_INTEGER: {
-			Assert(b.type->kind == CODE_TYPE_INTEGER);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Int) != EvaluationTypeValue(b, Kano_Int);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(b.type->kind == CODE_TYPE_REAL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Real) != EvaluationTypeValue(b, Kano_Real);
-			return r;
-		}
-		break;
-		
-		case CODE_TYPE_BOOL: {
-			Assert(b.type->kind == CODE_TYPE_BOOL);
-			r.imm.bool_value = EvaluationTypeValue(a, Kano_Bool) != EvaluationTypeValue(b, Kano_Bool);
-			return r;
-		}
-		break;
+	Assert(root->symbol_table);
 
-		case CODE_TYPE_POINTER: {
-			r.imm.bool_value = (EvaluationTypeValue(a, uint8_t *) != EvaluationTypeValue(b, uint8_t *));
-			return r;
-		}
-		break;
+	if constexpr ((Policy & INTERCEPT_POLICY_STATEMENT) != 0)
+	{
+		interp->current_row = root->source_row;
+		interp->current_row_procedure = interp->current_procedure;
+		interp->intercept(interp, INTERCEPT_STATEMENT, root);
 	}
-	
-	Unreachable();
-	return r;
 }
 
-static Evaluation_Value binary_cadd(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static inline bool interp_eval_condition_statement(Interpreter *interp, Code_Node_Statement *root)
 {
-	a.type = type;
-	
-	switch (type->kind)
-	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			auto ref = EvaluationTypePointer(a, Kano_Char);
-			*ref += EvaluationTypeValue(b, Kano_Char);
-			return a;
-		}
-		break;
-
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			auto ref = EvaluationTypePointer(a, Kano_Int);
-			*ref += EvaluationTypeValue(b, Kano_Int);
-			return a;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			auto ref = EvaluationTypePointer(a, Kano_Real);
-			*ref += EvaluationTypeValue(b, Kano_Real);
-			return a;
-		}
-		break;
-		
-		case CODE_TYPE_POINTER: {
-			Assert(a.type->kind == CODE_TYPE_POINTER && b.type->kind == CODE_TYPE_INTEGER);
-			auto ref = EvaluationTypePointer(a, uint8_t *);
-			*ref += EvaluationTypeValue(b, Kano_Int);
-			return a;
-		}
-		break;
-	}
-	
-	Unreachable();
-	return Evaluation_Value{};
+	interp_intercept_statement<Policy>(interp, root);
+	return interp_eval_condition<Policy>(interp, root->node);
 }
 
-static Evaluation_Value binary_csub(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_statement(Interpreter *interp, Code_Node_Statement *root);
+
+// Native code of the loop once it is hot, which then runs the remaining iterations starting at the condition
+template <Intercept_Policy Policy>
+static inline Code_Jit_Proc interp_hot_loop(Interpreter *interp, Code_Node *loop, Code_Jit_State *state)
 {
-	a.type = type;
-	
-	switch (type->kind)
+	if constexpr (Policy == INTERCEPT_POLICY_NONE)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			auto ref = EvaluationTypePointer(a, Kano_Char);
-			*ref -= EvaluationTypeValue(b, Kano_Char);
-			return a;
-		}
-		break;
-
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			auto ref = EvaluationTypePointer(a, Kano_Int);
-			*ref -= EvaluationTypeValue(b, Kano_Int);
-			return a;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			auto ref = EvaluationTypePointer(a, Kano_Real);
-			*ref -= EvaluationTypeValue(b, Kano_Real);
-			return a;
-		}
-		break;
-		case CODE_TYPE_POINTER: {
-			Assert(a.type->kind == CODE_TYPE_POINTER && b.type->kind == CODE_TYPE_INTEGER);
-			auto ref = EvaluationTypePointer(a, uint8_t *);
-			*ref -= EvaluationTypeValue(b, Kano_Int);
-			return a;
-		}
-		break;
+		if (interp->jit)
+			return jit_hot_loop(interp->jit, loop, state);
 	}
-	
-	Unreachable();
-	return Evaluation_Value{};
+	return nullptr;
 }
 
-static Evaluation_Value binary_cmul(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_do(Interpreter *interp, Code_Node_Do *root)
 {
-	a.type = type;
+	auto do_cond = root->condition;
+	auto do_body = root->body;
 	
-	switch (type->kind)
+	while (true)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			auto ref = EvaluationTypePointer(a, Kano_Char);
-			*ref *= EvaluationTypeValue(b, Kano_Char);
-			return a;
-		}
-		break;
+		auto completion = interp_eval_statement<Policy>(interp, do_body);
+		if (completion == INTERP_COMPLETION_RETURN)
+			return completion;
+		if (completion == INTERP_COMPLETION_BREAK)
+			break;
 
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			auto ref = EvaluationTypePointer(a, Kano_Int);
-			*ref *= EvaluationTypeValue(b, Kano_Int);
-			return a;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			auto ref = EvaluationTypePointer(a, Kano_Real);
-			*ref *= EvaluationTypeValue(b, Kano_Real);
-			return a;
-		}
-		break;
+		if (auto code = interp_hot_loop<Policy>(interp, root, &root->jit))
+			return (Interp_Completion)code(interp, interp->stack + interp->stack_top);
+
+		if (!interp_eval_condition_statement<Policy>(interp, do_cond))
+			break;
 	}
-	
-	Unreachable();
-	return Evaluation_Value{};
+
+	return INTERP_COMPLETION_NORMAL;
 }
 
-static Evaluation_Value binary_cdiv(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_while(Interpreter *interp, Code_Node_While *root)
 {
-	a.type = type;
+	auto while_cond = root->condition;
+	auto while_body = root->body;
 	
-	switch (type->kind)
+	while (true)
 	{
-		case CODE_TYPE_CHARACTER: {
-			Assert(b.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER);
-			auto ref = EvaluationTypePointer(a, Kano_Char);
-			*ref /= EvaluationTypeValue(b, Kano_Char);
-			return a;
-		}
-		break;
+		if (auto code = interp_hot_loop<Policy>(interp, root, &root->jit))
+			return (Interp_Completion)code(interp, interp->stack + interp->stack_top);
 
-		case CODE_TYPE_INTEGER: {
-			Assert(a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER);
-			auto ref = EvaluationTypePointer(a, Kano_Int);
-			*ref /= EvaluationTypeValue(b, Kano_Int);
-			return a;
-		}
-		break;
-		
-		case CODE_TYPE_REAL: {
-			Assert(a.type->kind == CODE_TYPE_REAL && b.type->kind == CODE_TYPE_REAL);
-			auto ref = EvaluationTypePointer(a, Kano_Real);
-			*ref /= EvaluationTypeValue(b, Kano_Real);
-			return a;
-		}
-		break;
-	}
-	
-	Unreachable();
-	return Evaluation_Value{};
-}
+		if (!interp_eval_condition_statement<Policy>(interp, while_cond))
+			break;
 
-static Evaluation_Value binary_cmod(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	a.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-	if (a.type->kind == CODE_TYPE_CHARACTER) {
-		auto ref = EvaluationTypePointer(a, Kano_Char);
-		*ref %= EvaluationTypeValue(b, Kano_Char);
-	} else {
-		auto ref = EvaluationTypePointer(a, Kano_Int);
-		*ref %= EvaluationTypeValue(b, Kano_Int);
+		auto completion = interp_eval_statement<Policy>(interp, while_body);
+		if (completion == INTERP_COMPLETION_RETURN)
+			return completion;
+		if (completion == INTERP_COMPLETION_BREAK)
+			break;
 	}
 
-	return a;
+	return INTERP_COMPLETION_NORMAL;
 }
 
-static Evaluation_Value binary_crs(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_if(Interpreter *interp, Code_Node_If *root)
 {
-	a.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-	if (a.type->kind == CODE_TYPE_CHARACTER) {
-		auto ref = EvaluationTypePointer(a, Kano_Char);
-		*ref >>= EvaluationTypeValue(b, Kano_Char);
-	}
-	else {
-		auto ref = EvaluationTypePointer(a, Kano_Int);
-		*ref >>= EvaluationTypeValue(b, Kano_Int);
-	}
-	return a;
-}
+	if (interp_eval_condition<Policy>(interp, root->condition))
+		return interp_eval_statement<Policy>(interp, (Code_Node_Statement *)root->true_statement);
 
-static Evaluation_Value binary_cls(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	a.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-	if (a.type->kind == CODE_TYPE_CHARACTER) {
-		auto ref = EvaluationTypePointer(a, Kano_Char);
-		*ref <<= EvaluationTypeValue(b, Kano_Char);
-	}
-	else {
-		auto ref = EvaluationTypePointer(a, Kano_Int);
-		*ref <<= EvaluationTypeValue(b, Kano_Int);
-	}	return a;
-}
+	if (root->false_statement)
+		return interp_eval_statement<Policy>(interp, (Code_Node_Statement *)root->false_statement);
 
-static Evaluation_Value binary_cand(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	a.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-	if (a.type->kind == CODE_TYPE_CHARACTER) {
-		auto ref = EvaluationTypePointer(a, Kano_Char);
-		*ref &= EvaluationTypeValue(b, Kano_Char);
-	}
-	else {
-		auto ref = EvaluationTypePointer(a, Kano_Int);
-		*ref &= EvaluationTypeValue(b, Kano_Int);
-	}	return a;
+	return INTERP_COMPLETION_NORMAL;
 }
 
-static Evaluation_Value binary_cxor(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_for(Interpreter *interp, Code_Node_For *root)
 {
-	a.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-	if (a.type->kind == CODE_TYPE_CHARACTER) {
-		auto ref = EvaluationTypePointer(a, Kano_Char);
-		*ref ^= EvaluationTypeValue(b, Kano_Char);
-	}
-	else {
-		auto ref = EvaluationTypePointer(a, Kano_Int);
-		*ref ^= EvaluationTypeValue(b, Kano_Int);
-	}	return a;
-}
+	auto for_init = root->initialization;
+	auto for_cond = root->condition;
+	auto for_incr = root->increment;
+	auto for_body = root->body;
+	
+	interp_eval_statement<Policy>(interp, for_init);
+	
+	while (true)
+	{
+		if (auto code = interp_hot_loop<Policy>(interp, root, &root->jit))
+			return (Interp_Completion)code(interp, interp->stack + interp->stack_top);
 
-static Evaluation_Value binary_cor(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	a.type = type;
-	Assert((a.type->kind == CODE_TYPE_INTEGER && b.type->kind == CODE_TYPE_INTEGER) ||
-		(a.type->kind == CODE_TYPE_CHARACTER && b.type->kind == CODE_TYPE_CHARACTER));
-	if (a.type->kind == CODE_TYPE_CHARACTER) {
-		auto ref = EvaluationTypePointer(a, Kano_Char);
-		*ref |= EvaluationTypeValue(b, Kano_Char);
-	}
-	else {
-		auto ref = EvaluationTypePointer(a, Kano_Int);
-		*ref |= EvaluationTypeValue(b, Kano_Int);
+		if (!interp_eval_condition_statement<Policy>(interp, for_cond))
+			break;
+
+		// @Note: Continue falls through to the increment
+		auto completion = interp_eval_statement<Policy>(interp, for_body);
+		if (completion == INTERP_COMPLETION_RETURN)
+			return completion;
+		if (completion == INTERP_COMPLETION_BREAK)
+			break;
+		interp_eval_statement<Policy>(interp, for_incr);
 	}
-	return a;
-}
 
-static Evaluation_Value binary_land(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
-{
-	Assert(type->kind == CODE_TYPE_BOOL && a.type->kind == b.type->kind);
-	Evaluation_Value r;
-	r.type = type;
-	r.from_address = nullptr;
-	if (a.type->kind == CODE_TYPE_BOOL)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Bool) && EvaluationTypeValue(b, Kano_Bool));
-	else if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Char) && EvaluationTypeValue(b, Kano_Char));
-	else if (a.type->kind == CODE_TYPE_INTEGER)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Int) && EvaluationTypeValue(b, Kano_Int));
-	else if (a.type->kind == CODE_TYPE_POINTER)
-		r.imm.bool_value = (EvaluationTypeValue(a, void *) && EvaluationTypeValue(b, void *));
-	else if (a.type->kind == CODE_TYPE_REAL)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Real) && EvaluationTypeValue(b, Kano_Real));
-	else
-		Unreachable();
-	return r;
+	return INTERP_COMPLETION_NORMAL;
 }
 
-static Evaluation_Value binary_lor(Evaluation_Value a, Evaluation_Value b, Code_Type *type)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_statement(Interpreter *interp, Code_Node_Statement *root)
 {
-	Assert(type->kind == CODE_TYPE_BOOL && a.type->kind == b.type->kind);
-	Evaluation_Value r;
-	r.type = type;
-	r.from_address = nullptr;
-	if (a.type->kind == CODE_TYPE_BOOL)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Bool) || EvaluationTypeValue(b, Kano_Bool));
-	else if (a.type->kind == CODE_TYPE_CHARACTER)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Char) || EvaluationTypeValue(b, Kano_Char));
-	else if (a.type->kind == CODE_TYPE_INTEGER)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Int) || EvaluationTypeValue(b, Kano_Int));
-	else if (a.type->kind == CODE_TYPE_POINTER)
-		r.imm.bool_value = (EvaluationTypeValue(a, void *) || EvaluationTypeValue(b, void *));
-	else if (a.type->kind == CODE_TYPE_REAL)
-		r.imm.bool_value = (EvaluationTypeValue(a, Kano_Real) || EvaluationTypeValue(b, Kano_Real));
-	else
-		Unreachable();
-	return r;
-}
+	interp_intercept_statement<Policy>(interp, root);
 
-static BinaryOperatorProc BinaryOperators[] = {
-	binary_add,  binary_sub,  binary_mul,  binary_div, binary_mod, binary_rs,   binary_ls,   binary_add,  binary_xor,
-	binary_or,   binary_gt,   binary_lt,   binary_ge,  binary_le,  binary_cmp,  binary_ncmp, binary_cadd, binary_csub,
-	binary_cmul, binary_cdiv, binary_cmod, binary_crs, binary_cls, binary_cadd, binary_cxor, binary_cor,
-	binary_land, binary_lor };
+	switch (root->node->kind)
+	{
+		case CODE_NODE_EXPRESSION: {
+			auto expression = (Code_Node_Expression *)root->node;
+			switch (expression->child->kind)
+			{
+				case CODE_NODE_RETURN:
+					interp_eval_return<Policy>(interp, (Code_Node_Return *)expression->child);
+					return INTERP_COMPLETION_RETURN;
 
-static Evaluation_Value interp_eval_expression(Interpreter *interp, Code_Node *root);
-static Evaluation_Value interp_eval_root_expression(Interpreter *interp, Code_Node_Expression *root);
+				case CODE_NODE_BREAK:
+					return INTERP_COMPLETION_BREAK;
 
-static Evaluation_Value interp_eval_binary_operator(Interpreter *interp, Code_Node_Binary_Operator *node)
-{
-	auto b = interp_eval_expression(interp, node->right);
+				case CODE_NODE_CONTINUE:
+					return INTERP_COMPLETION_CONTINUE;
 
-	// Copy to imm value, so that it doesn't change changed if procedures are being called when solving for a
-	if (b.from_address)
-	{
-		memcpy(&b.imm, b.from_address, b.type->runtime_size);
-		b.from_address = nullptr;
+				default:
+					interp_eval_expression<Policy>(interp, expression->child);
+					return INTERP_COMPLETION_NORMAL;
+			}
+		}
+		
+		case CODE_NODE_ASSIGNMENT:
+			interp_eval_assignment<Policy>(interp, (Code_Node_Assignment *)root->node);
+			return INTERP_COMPLETION_NORMAL;
+		
+		case CODE_NODE_BLOCK:
+			return interp_eval_block<Policy>(interp, (Code_Node_Block *)root->node, false);
+		
+		case CODE_NODE_IF:
+			return interp_eval_if<Policy>(interp, (Code_Node_If *)root->node);
+		
+		case CODE_NODE_FOR:
+			return interp_eval_for<Policy>(interp, (Code_Node_For *)root->node);
+		
+		case CODE_NODE_WHILE:
+			return interp_eval_while<Policy>(interp, (Code_Node_While *)root->node);
+		
+		case CODE_NODE_DO:
+			return interp_eval_do<Policy>(interp, (Code_Node_Do *)root->node);
+		
+		NoDefaultCase();
 	}
 
-	auto a = interp_eval_expression(interp, node->left);
-
-	Assert(node->op_kind < ArrayCount(BinaryOperators));
+	Unreachable();
 	
-	return BinaryOperators[node->op_kind](a, b, node->type);
+	return INTERP_COMPLETION_NORMAL;
 }
 
-static Evaluation_Value interp_eval_assignment(Interpreter *interp, Code_Node_Assignment *node)
+template <Intercept_Policy Policy>
+static Interp_Completion interp_eval_block(Interpreter *interp, Code_Node_Block *root, bool isproc)
 {
-	auto value = interp_eval_root_expression(interp, (Code_Node_Expression *)node->value);
-	
-	auto dst = interp_eval_root_expression(interp, node->destination);
-	
-	if (dst.from_address)
-	{
-		uint64_t *source = (uint64_t *)EvaluationTypePointer(value, void *);
-		memcpy(dst.from_address, source, value.type->runtime_size);
-	}
-	else if (dst.type->kind == CODE_TYPE_POINTER)
+	if constexpr ((Policy & INTERCEPT_POLICY_PROCEDURE) != 0)
 	{
-		memcpy(dst.imm.pointer_value, EvaluationTypePointer(value, void *), value.type->runtime_size);
+		if (isproc)
+			interp->intercept(interp, INTERCEPT_PROCEDURE_CALL, root);
 	}
-	else
+
+	auto completion = INTERP_COMPLETION_NORMAL;
+	for (auto statement = root->statement_head; statement; statement = statement->next)
 	{
-		Unreachable();
+		completion = interp_eval_statement<Policy>(interp, statement);
+		if (completion != INTERP_COMPLETION_NORMAL)
+			break;
 	}
-	
-	return value;
-}
-
-static void interp_eval_block(Interpreter *interp, Code_Node_Block *root, bool isproc);
 
-static inline void interp_push_aligned_parameter(Interpreter *interp, Code_Node_Procedure_Call *root, uint64_t prev_top, uint64_t new_top, uint64_t offset)
-{
-	for (int64_t index = 0; index < root->parameter_count; ++index)
+	if constexpr ((Policy & INTERCEPT_POLICY_PROCEDURE) != 0)
 	{
-		auto param = root->parameters[index];
-		offset = AlignPower2Up(offset, (uint64_t)param->type->alignment);
-		interp->stack_top = prev_top;
-		auto var = interp_eval_root_expression(interp, param);
-		interp->stack_top = new_top;
-		offset = interp_push_into_stack(interp, var, offset);
+		if (isproc)
+			interp->intercept(interp, INTERCEPT_PROCEDURE_RETURN, root);
 	}
-}
 
-static Evaluation_Value interp_make_type_value(Interpreter *interp, Code_Type *type) {
-	Evaluation_Value value;
-	value.imm.pointer_value = (uint8_t *)type;
-	value.type = code_type_resolver_find_type(interp->resolver, "*void");
-	return value;
+	return isproc ? INTERP_COMPLETION_NORMAL : completion;
 }
 
-static Evaluation_Value interp_eval_procedure_call(Interpreter *interp, Code_Node_Procedure_Call *root)
-{
-	auto prev_top = interp->stack_top;
-
-	auto new_top = root->stack_top + prev_top;
-
-	// @Note: We do not align variadics to simplify the variadics routine
-
-	uint64_t variadics_args_size = 0;
-	for (int64_t i = 0; i < root->variadic_count; ++i)
-	{
-		variadics_args_size += root->variadics[i]->type->runtime_size;
-		variadics_args_size += sizeof(Code_Type *);
-	}
+//
+//
+//
 
-	{
-		// @Note: Variadics are evaluated in reverse order because we add Code_Type * as well
-		// If this were done in forward order, the result placed by a function call in the top
-		// of the stack will be erased when we push Code_Type * into the stack
-		uint64_t offset = variadics_args_size;
-		for (int64_t i = root->variadic_count - 1; i >= 0; --i)
-		{
-			interp->stack_top = prev_top;
-			auto param = root->variadics[i];
-			auto var = interp_eval_root_expression(interp, param);
-			interp->stack_top = new_top;
-			offset = interp_push_into_stack_reduced(interp, var, offset);
-			offset = interp_push_into_stack_reduced(interp, interp_make_type_value(interp, param->type), offset);
-		}
-	}
-	
-	new_top += variadics_args_size;
+//
+//
+//
 
-	uint64_t return_type_size = 0;
-	if (root->type)
-	{
-		new_top = AlignPower2Up(new_top, (uint64_t)root->type->alignment);
-		return_type_size = root->type->runtime_size;
-	}
-	else if (root->parameter_count)
-	{
-		new_top = AlignPower2Up(new_top, (uint64_t)root->parameters[0]->type->alignment);
-	}
+// Inaccessible region after the stack and after the globals. It is larger than a page, so that a frame
+// bigger than a page can not step over it
+constexpr size_t INTERP_GUARD_SIZE = 64 * 1024;
 
-	interp_push_aligned_parameter(interp, root, prev_top, new_top, return_type_size);
+// Headroom of the native stack kept for the code that runs between two checks of interp_native_limit
+constexpr size_t INTERP_NATIVE_STACK_RESERVE = 256 * 1024;
 
-	interp->stack_top = prev_top;
-	auto proc_expr = interp_eval_root_expression(interp, root->procedure);
-	auto procedure = EvaluationTypeValue(proc_expr, Code_Value_Procedure);
-	
-	auto prev_proc = interp->current_procedure;
-	interp->stack_top = new_top;
-	interp->current_procedure = root->procedure_type;
+// Reserves (size) bytes, which must be a multiple of INTERP_GUARD_SIZE, followed by the guard region.
+// Committed pages read as zero until they are written, so nothing has to be cleared
+static uint8_t *interp_reserve(size_t size)
+{
+	if (!size)
+		return nullptr;
 
-	if (procedure.block)
-		interp_eval_block(interp, procedure.block, true);
-	else
-		procedure.ccall(interp);
+	auto memory = (uint8_t *)VirtualMemoryAllocate(nullptr, size + INTERP_GUARD_SIZE);
+	if (!memory)
+		return nullptr;
 
-	Evaluation_Value result;
-	if (root->type)
-	{
-		result.from_address = (uint8_t *)(interp->stack + interp->stack_top);
-		result.type    = root->type;
-	}
-	else
+	if (!VirtualMemoryCommit(memory, size))
 	{
-		result.from_address = nullptr;
-		result.type    = nullptr;
+		VirtualMemoryFree(memory, size + INTERP_GUARD_SIZE);
+		return nullptr;
 	}
 
-	interp->current_procedure = prev_proc;
-	interp->stack_top = prev_top;
-	
-	return result;
+	return memory;
 }
 
-static Evaluation_Value interp_eval_expression(Interpreter *interp, Code_Node *root)
+void interp_init(Interpreter *interp, Code_Type_Resolver *resolver, size_t stack_size, size_t bss_size)
 {
-	switch (root->kind)
-	{
-		case CODE_NODE_LITERAL: return interp_eval_literal(interp, (Code_Node_Literal *)root);
-		case CODE_NODE_UNARY_OPERATOR: return interp_eval_unary_operator(interp, (Code_Node_Unary_Operator *)root);
-		case CODE_NODE_BINARY_OPERATOR: return interp_eval_binary_operator(interp, (Code_Node_Binary_Operator *)root);
-		case CODE_NODE_ADDRESS: return interp_eval_address(interp, (Code_Node_Address *)root);
-		case CODE_NODE_OFFSET: return interp_eval_offset(interp, (Code_Node_Offset *)root);
-		case CODE_NODE_ASSIGNMENT: return interp_eval_assignment(interp, (Code_Node_Assignment *)root);
-		case CODE_NODE_TYPE_CAST: return interp_eval_type_cast(interp, (Code_Node_Type_Cast *)root);
-		case CODE_NODE_IF: return interp_eval_expression(interp, (Code_Node *)root);
-		case CODE_NODE_PROCEDURE_CALL: return interp_eval_procedure_call(interp, (Code_Node_Procedure_Call *)root);
-		case CODE_NODE_RETURN: return interp_eval_return(interp, (Code_Node_Return *)root);
-		case CODE_NODE_BREAK: interp_eval_break(interp, (Code_Node_Break *)root); return Evaluation_Value{};
-		case CODE_NODE_CONTINUE: interp_eval_continue(interp, (Code_Node_Continue *)root); return Evaluation_Value{};
-		
-		NoDefaultCase();
-	}
-	
-	Unreachable();
-	return Evaluation_Value{};
+	interp->stack_size  = AlignPower2Up(stack_size, INTERP_GUARD_SIZE);
+	interp->global_size = AlignPower2Up(bss_size, INTERP_GUARD_SIZE);
+	interp->stack       = interp_reserve(interp->stack_size);
+	interp->global      = interp_reserve(interp->global_size);
+	interp->resolver    = resolver;
+
+	if ((interp->stack_size && !interp->stack) || (interp->global_size && !interp->global))
+		interp->runtime_error = "Out of memory for the stack and the globals";
 }
 
-static Evaluation_Value interp_eval_root_expression(Interpreter *interp, Code_Node_Expression *root)
+void interp_free(Interpreter *interp)
 {
-	return interp_eval_expression(interp, root->child);
-}
+	if (interp->stack)
+		VirtualMemoryFree(interp->stack, interp->stack_size + INTERP_GUARD_SIZE);
+	if (interp->global)
+		VirtualMemoryFree(interp->global, interp->global_size + INTERP_GUARD_SIZE);
 
-int64_t interp_evaluate_constant_expression(Code_Node_Expression *root) {
-	Interpreter interp;
-	interp_init(&interp, nullptr, 0, 0);
+	interp->stack  = nullptr;
+	interp->global = nullptr;
+}
 
-	Assert(root->type->kind == CODE_TYPE_INTEGER || root->type->kind == CODE_TYPE_CHARACTER);
+struct Interp_Guard_Frame
+{
+	jmp_buf             recover;
+	Interpreter *       interp;
+	Interp_Guard_Frame *prev;
+};
 
-	auto value = interp_eval_root_expression(&interp, root);
+static thread_local Interp_Guard_Frame *interp_guard_top = nullptr;
 
-	if (value.type->kind == CODE_TYPE_INTEGER)
-		return (int64_t)EvaluationTypeValue(value, Kano_Int);
-	else if (value.type->kind == CODE_TYPE_CHARACTER)
-		return (int64_t)EvaluationTypeValue(value, Kano_Char);
-	else
-		Unreachable();
-	return 0;
+void interp_runtime_error(Interpreter *interp, const char *error)
+{
+	Assert(interp_guard_top && interp_guard_top->interp == interp);
+	interp->runtime_error = error;
+	longjmp(interp_guard_top->recover, 1);
 }
 
-static bool interp_eval_statement(Interpreter *interp, Code_Node_Statement *root, Evaluation_Value *value);
+#if INTERP_GUARD_SIGNALS == 1
 
-static void interp_eval_do(Interpreter *interp, Code_Node_Do *root)
+// Lowest address of the native stack of the calling thread
+static uint8_t *interp_native_stack_base()
 {
-	auto do_cond = root->condition;
-	auto do_body = root->body;
-	
-	Evaluation_Value cond;
-	
-	auto return_index = interp->return_count;
-	auto break_index = interp->break_count;
-	auto continue_index = interp->continue_count;
-	do
-	{
-		interp_eval_statement(interp, do_body, nullptr);
-		if (return_index != interp->return_count)
-			break;
-		if (continue_index != interp->continue_count)
-		{
-			interp->continue_count = continue_index;
-			continue;
-		}
-		if (break_index != interp->break_count)
-		{
-			interp->break_count = break_index;
-			break;
-		}
-		bool value = interp_eval_statement(interp, do_cond, &cond);
-		Assert(value);
-	} while (EvaluationTypeValue(cond, bool));
+#if PLATFORM_LINUX == 1
+	pthread_attr_t attr;
+	if (pthread_getattr_np(pthread_self(), &attr) != 0)
+		return nullptr;
+
+	void * base = nullptr;
+	size_t size = 0;
+	pthread_attr_getstack(&attr, &base, &size);
+	pthread_attr_destroy(&attr);
+	return (uint8_t *)base;
+#else
+	auto thread = pthread_self();
+	return (uint8_t *)pthread_get_stackaddr_np(thread) - pthread_get_stacksize_np(thread);
+#endif
 }
 
-static void interp_eval_while(Interpreter *interp, Code_Node_While *root)
+// The fault handler runs on its own stack, so that it still runs when the native stack overflowed
+struct Interp_Signal_Stack
 {
-	auto while_cond = root->condition;
-	auto while_body = root->body;
-	
-	Evaluation_Value cond;
-	bool value = interp_eval_statement(interp, while_cond, &cond);
-	Assert(value);
-	
-	auto return_index = interp->return_count;
-	auto break_index = interp->break_count;
-	auto continue_index = interp->continue_count;
-	while (EvaluationTypeValue(cond, bool))
+	void *memory = nullptr;
+
+	~Interp_Signal_Stack()
 	{
-		interp_eval_statement(interp, while_body, nullptr);
-		if (return_index != interp->return_count)
-			break;
-		if (continue_index != interp->continue_count)
-		{
-			interp->continue_count = continue_index;
-			continue;
-		}
-		if (break_index != interp->break_count)
-		{
-			interp->break_count = break_index;
-			break;
-		}
-		bool value = interp_eval_statement(interp, while_cond, &cond);
-		Assert(value);
+		if (!memory)
+			return;
+		stack_t stack  = {};
+		stack.ss_flags = SS_DISABLE;
+		sigaltstack(&stack, nullptr);
+		free(memory);
 	}
-}
+};
 
-static void interp_eval_if(Interpreter *interp, Code_Node_If *root)
+static thread_local Interp_Signal_Stack interp_signal_stack;
+static thread_local uint8_t *           interp_native_base = nullptr;
+
+static inline bool interp_in_guard(uint8_t *address, uint8_t *memory, size_t size)
 {
-	auto cond = interp_eval_root_expression(interp, (Code_Node_Expression *)root->condition);
-	if (EvaluationTypeValue(cond, bool))
-	{
-		interp_eval_statement(interp, (Code_Node_Statement *)root->true_statement, nullptr);
-	}
-	else
-	{
-		if (root->false_statement)
-			interp_eval_statement(interp, (Code_Node_Statement *)root->false_statement, nullptr);
-	}
+	return memory && address >= memory + size && address < memory + size + INTERP_GUARD_SIZE;
 }
 
-static void interp_eval_for(Interpreter *interp, Code_Node_For *root)
+static void interp_guard_handler(int signal_number, siginfo_t *info, void *context)
 {
-	auto for_init = root->initialization;
-	auto for_cond = root->condition;
-	auto for_incr = root->increment;
-	auto for_body = root->body;
-	
-	Evaluation_Value cond;
-	
-	interp_eval_statement(interp, for_init, nullptr);
-	bool value = interp_eval_statement(interp, for_cond, &cond);
-	Assert(value);
-	
-	auto return_index = interp->return_count;
-	auto break_index = interp->break_count;
-	auto continue_index = interp->continue_count;
-	while (EvaluationTypeValue(cond, bool))
+	auto frame = interp_guard_top;
+	if (frame)
 	{
-		interp_eval_statement(interp, for_body, nullptr);
-		if (return_index != interp->return_count)
-			break;
-		if (continue_index != interp->continue_count)
+		auto address = (uint8_t *)info->si_addr;
+		auto interp  = frame->interp;
+
+		const char *error = nullptr;
+		if (interp_in_guard(address, interp->stack, interp->stack_size))
+			error = "Stack overflow";
+		else if (interp_in_guard(address, interp->global, interp->global_size))
+			error = "Access past the end of the globals";
+		else if (interp_native_base && address + INTERP_GUARD_SIZE >= interp_native_base &&
+				 address < interp_native_base + INTERP_GUARD_SIZE)
+			error = "Stack overflow"; // Native code of the JIT recursing past interp_native_limit
+
+		if (error)
 		{
-			interp->continue_count = continue_index;
-			continue;
+			interp->runtime_error = error;
+			longjmp(frame->recover, 1);
 		}
-		if (break_index != interp->break_count)
-		{
-			interp->break_count = break_index;
-			break;
-		}
-		bool value;
-		value = interp_eval_statement(interp, for_incr, nullptr);
-		Assert(value);
-		value = interp_eval_statement(interp, for_cond, &cond);
-		Assert(value);
 	}
+
+	// Not one of the guards, the fault takes its default action once the handler returns
+	signal(signal_number, SIG_DFL);
 }
 
-static bool interp_eval_statement(Interpreter *interp, Code_Node_Statement *root, Evaluation_Value *out_value)
+static void interp_install_guard_handler()
 {
-	Assert(root->symbol_table);
-
-	interp->current_row = root->source_row;
-	interp->intercept(interp, INTERCEPT_STATEMENT, root);
+	struct sigaction action = {};
+	action.sa_sigaction     = interp_guard_handler;
+	action.sa_flags         = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGSEGV, &action, nullptr);
+	sigaction(SIGBUS, &action, nullptr);
+}
 
-	Evaluation_Value value;
-	Evaluation_Value *dst = out_value ? out_value : &value;
+static void interp_arm_guards()
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, interp_install_guard_handler);
 
-	switch (root->node->kind)
+	if (!interp_signal_stack.memory)
 	{
-		case CODE_NODE_EXPRESSION: 
-			*dst = interp_eval_root_expression(interp, (Code_Node_Expression *)root->node);
-			return true;
-		
-		case CODE_NODE_ASSIGNMENT:
-			*dst = interp_eval_assignment(interp, (Code_Node_Assignment *)root->node);
-			return true;
-		
-		case CODE_NODE_BLOCK:
-			interp_eval_block(interp, (Code_Node_Block *)root->node, false);
-			return false;
-		
-		case CODE_NODE_IF:
-			interp_eval_if(interp, (Code_Node_If *)root->node);
-			return false;
-		
-		case CODE_NODE_FOR:
-			interp_eval_for(interp, (Code_Node_For *)root->node);
-			return false;
-		
-		case CODE_NODE_WHILE:
-			interp_eval_while(interp, (Code_Node_While *)root->node);
-			return false;
-		
-		case CODE_NODE_DO:
-			interp_eval_do(interp, (Code_Node_Do *)root->node);
-			return false;
-		
-		NoDefaultCase();
-	}
+		const size_t size = 64 * 1024;
+
+		stack_t stack;
+		stack.ss_sp    = malloc(size);
+		stack.ss_size  = size;
+		stack.ss_flags = 0;
+		if (stack.ss_sp && sigaltstack(&stack, nullptr) == 0)
+			interp_signal_stack.memory = stack.ss_sp;
+		else
+			free(stack.ss_sp);
 
-	Unreachable();
-	
-	return false;
+		interp_native_base = interp_native_stack_base();
+		if (interp_native_base)
+			interp_native_limit = interp_native_base + INTERP_NATIVE_STACK_RESERVE;
+	}
 }
 
-static void interp_eval_block(Interpreter *interp, Code_Node_Block *root, bool isproc)
+#else
+
+static void interp_arm_guards() {}
+
+#endif
+
+bool interp_protect(Interpreter *interp, Interp_Protected_Proc proc, void *data)
 {
-	if (isproc)
-	{
-		interp->intercept(interp, INTERCEPT_PROCEDURE_CALL, root);
-	}
+	if (interp->runtime_error)
+		return false;
 
-	auto return_index = interp->return_count;
-	auto break_index = interp->break_count;
-	auto continue_index = interp->continue_count;
-	for (auto statement = root->statement_head; statement; statement = statement->next)
-	{
-		interp_eval_statement(interp, statement, nullptr);
+	interp_arm_guards();
 
-		if (return_index != interp->return_count)
-		{
-			if (isproc)
-				interp->return_count -= 1;
-			break;
-		}
+	Interp_Guard_Frame frame;
+	frame.interp     = interp;
+	frame.prev       = interp_guard_top;
+	interp_guard_top = &frame;
 
-		if (break_index != interp->break_count || continue_index != interp->continue_count)
-			break;
+	// @Note: The handler jumps out of a signal handler, SA_NODEFER keeps the signal unblocked afterwards
+	if (setjmp(frame.recover) == 0)
+	{
+		proc(interp, data);
 	}
-
-	if (isproc)
+	else
 	{
-		interp->intercept(interp, INTERCEPT_PROCEDURE_RETURN, root);
+		interp->stack_top         = 0;
+		interp->tail_call         = nullptr;
+		interp->current_procedure = nullptr;
 	}
-}
 
-//
-//
-//
+	interp_guard_top = frame.prev;
+	return interp->runtime_error == nullptr;
+}
 
-void interp_init(Interpreter *interp, Code_Type_Resolver *resolver, size_t stack_size, size_t bss_size)
+template <Intercept_Policy Policy>
+static void interp_run_globals(Interpreter *interp, void *data)
 {
-	interp->stack  = new uint8_t[stack_size];
-	interp->global = new uint8_t[bss_size];
-	interp->stack_size = stack_size;
-	interp->global_size = bss_size;
-	interp->resolver = resolver;
-	memset(interp->stack, 0, stack_size);
-	memset(interp->global, 0, bss_size);
+	for (auto expr : *(Array_View<Code_Node_Assignment *> *)data)
+		interp_eval_assignment<Policy>(interp, expr);
 }
 
+template <Intercept_Policy Policy>
 void interp_eval_globals(Interpreter *interp, Array_View<Code_Node_Assignment *> exprs)
 {
-	for (auto expr : exprs)
-		interp_eval_assignment(interp, expr);
+	interp_protect(interp, interp_run_globals<Policy>, &exprs);
 }
 
 #include "JsonWriter.h"
 
-Code_Node_Procedure_Call *interp_find_main(Interpreter *interp) {
-	auto resolver = interp->resolver;
+Code_Node_Procedure_Call *interp_find_main(Code_Type_Resolver *resolver) {
 	auto main_proc = code_type_resolver_find(resolver, "main");
 
 	if (!main_proc) {
@@ -1559,10 +1323,42 @@ Code_Node_Procedure_Call *interp_find_main(Interpreter *interp) {
 	//proc_call->source_row = main_proc->location.start_row;
 	proc_call->flags = main_proc->flags;
 	proc_call->procedure = expr;
+	proc_call->callee = &main_proc->address;
 
 	return proc_call;
 }
 
+template <Intercept_Policy Policy>
+static void interp_run_procedure(Interpreter *interp, void *data)
+{
+	interp_eval_procedure_call<Policy>(interp, (Code_Node_Procedure_Call *)data);
+}
+
+template <Intercept_Policy Policy>
 void interp_evaluate_procedure(Interpreter *interp, Code_Node_Procedure_Call *proc) {
-	interp_eval_procedure_call(interp, proc);
+	interp_protect(interp, interp_run_procedure<Policy>, proc);
 }
+
+void interp_call(Interpreter *interp, Code_Value_Procedure procedure, Code_Type_Procedure *type, uint8_t *frame)
+{
+	auto prev_top  = interp->stack_top;
+	auto prev_proc = interp->current_procedure;
+
+	interp->stack_top         = (uint64_t)(frame - interp->stack);
+	interp->current_procedure = type;
+
+	interp_invoke<INTERCEPT_POLICY_NONE>(interp, procedure);
+
+	interp->current_procedure = prev_proc;
+	interp->stack_top         = prev_top;
+}
+
+template void interp_eval_globals<INTERCEPT_POLICY_NONE>(Interpreter *interp, Array_View<Code_Node_Assignment *> exprs);
+template void interp_eval_globals<INTERCEPT_POLICY_STATEMENT>(Interpreter *interp, Array_View<Code_Node_Assignment *> exprs);
+template void interp_eval_globals<INTERCEPT_POLICY_PROCEDURE>(Interpreter *interp, Array_View<Code_Node_Assignment *> exprs);
+template void interp_eval_globals<INTERCEPT_POLICY_ALL>(Interpreter *interp, Array_View<Code_Node_Assignment *> exprs);
+
+template void interp_evaluate_procedure<INTERCEPT_POLICY_NONE>(Interpreter *interp, Code_Node_Procedure_Call *proc);
+template void interp_evaluate_procedure<INTERCEPT_POLICY_STATEMENT>(Interpreter *interp, Code_Node_Procedure_Call *proc);
+template void interp_evaluate_procedure<INTERCEPT_POLICY_PROCEDURE>(Interpreter *interp, Code_Node_Procedure_Call *proc);
+template void interp_evaluate_procedure<INTERCEPT_POLICY_ALL>(Interpreter *interp, Code_Node_Procedure_Call *proc);
@@ -9,6 +9,25 @@ enum Intercept_Kind
 	INTERCEPT_PROCEDURE_RETURN
 };
 
+// Selects which intercepts the interpreter is instantiated with, untraced execution pays nothing for hooks
+enum Intercept_Policy
+{
+	INTERCEPT_POLICY_NONE      = 0,
+	INTERCEPT_POLICY_STATEMENT = 0x1, // INTERCEPT_STATEMENT, also keeps current_row and current_row_procedure updated
+	INTERCEPT_POLICY_PROCEDURE = 0x2, // INTERCEPT_PROCEDURE_CALL and INTERCEPT_PROCEDURE_RETURN
+	INTERCEPT_POLICY_ALL       = INTERCEPT_POLICY_STATEMENT | INTERCEPT_POLICY_PROCEDURE
+};
+
+// How a statement completed, anything but INTERP_COMPLETION_NORMAL unwinds the enclosing statements
+// until the loop (break, continue) or the procedure (return) that handles it
+enum Interp_Completion
+{
+	INTERP_COMPLETION_NORMAL,
+	INTERP_COMPLETION_BREAK,
+	INTERP_COMPLETION_CONTINUE,
+	INTERP_COMPLETION_RETURN,
+};
+
 typedef void(*Intercep_Proc)(struct Interpreter *interp, Intercept_Kind intercept, struct Code_Node *node);
 
 inline void intercept_default(struct Interpreter *interp, Intercept_Kind intercept, struct Code_Node *statement){};
@@ -20,26 +39,57 @@ struct Interpreter
 	uint8_t *global = nullptr;
 	uint64_t global_size = 0;
 	uint64_t stack_top = 0;
-	int64_t  return_count = 0;
-	int64_t break_count = 0;
-	int64_t continue_count = 0;
+	struct Code_Node_Procedure_Call *tail_call = nullptr;
 	struct Code_Type_Procedure *current_procedure = nullptr;
 	Symbol_Table *global_symbol_table = nullptr;
 	struct Heap_Allocator *heap = nullptr;
 
+	// Records allocate and free by the source row they are called from when set
+	struct Heap_Profile *heap_profile = nullptr;
+
 	uint64_t current_row = 0;
+	struct Code_Type_Procedure *current_row_procedure = nullptr; // The procedure current_row is in
+
+	// Totals of the inline caches of the bytecode indirect call sites
+	uint64_t call_cache_hits = 0;
+	uint64_t call_cache_misses = 0;
 
 	struct Code_Type_Resolver *resolver = nullptr;
 
 	Intercep_Proc intercept = intercept_default;
 	void *user_context = nullptr;
+
+	// Hot procedures and loops are compiled to native code when set, only with INTERCEPT_POLICY_NONE
+	struct Jit *jit = nullptr;
+
+	// Set when the program was stopped by a runtime error, nothing runs on this interpreter after that
+	const char *runtime_error = nullptr;
 };
 
+// The stack and the globals are reserved with a guard region after them and are zero filled by the OS as
+// they are touched, so starting an interpreter does not clear the whole stack up front
 void            interp_init(Interpreter *interp, struct Code_Type_Resolver *resolver, size_t stack_size, size_t bss_size);
+void            interp_free(Interpreter *interp);
+
+typedef void (*Interp_Protected_Proc)(Interpreter *interp, void *data);
 
+// Runs (proc) so that an overflow of the interpreter stack or of the native stack stops the program with
+// (runtime_error) set instead of corrupting memory. Returns false when the program was stopped.
+// interp_eval_globals and interp_evaluate_procedure already run protected
+bool interp_protect(Interpreter *interp, Interp_Protected_Proc proc, void *data);
+
+// Stops the program running under interp_protect
+[[noreturn]] void interp_runtime_error(Interpreter *interp, const char *error);
+
+template <Intercept_Policy Policy>
 void interp_eval_globals(Interpreter *interp, Array_View<Code_Node_Assignment *> exprs);
-Code_Node_Procedure_Call *interp_find_main(Interpreter *interp);
+Code_Node_Procedure_Call *interp_find_main(struct Code_Type_Resolver *resolver);
+template <Intercept_Policy Policy>
 void interp_evaluate_procedure(Interpreter *interp, Code_Node_Procedure_Call *proc);
 
+// Calls the procedure with its frame at (frame), used by native code to call back into the interpreter
+void interp_call(Interpreter *interp, Code_Value_Procedure procedure, Code_Type_Procedure *type, uint8_t *frame);
+
 int64_t interp_evaluate_constant_expression(Code_Node_Expression *root);
+Code_Value interp_evaluate_constant_value(Code_Node *root);
 
@@ -0,0 +1,1295 @@
+#include "Jit.h"
+
+#include <stddef.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_NATIVE 1
+#else
+#define JIT_NATIVE 0
+#endif
+
+//
+// Code generation is a single pass over the resolved tree. Fixed registers:
+//   rbx = Interpreter *, r12 = frame (stack + stack_top), r13 = global
+// Scalars are produced in rax (char and bool zero extended) or xmm0 (real), aggregates and
+// lvalues as their address in rax. Intermediate values are pushed on the native stack.
+//
+
+enum Jit_Register : uint32_t
+{
+	JIT_RAX, JIT_RCX, JIT_RDX, JIT_RBX, JIT_RSP, JIT_RBP, JIT_RSI, JIT_RDI,
+	JIT_R8, JIT_R9, JIT_R10, JIT_R11, JIT_R12, JIT_R13, JIT_R14, JIT_R15,
+};
+
+enum Jit_Condition : uint32_t
+{
+	JIT_CC_B  = 0x2,
+	JIT_CC_AE = 0x3,
+	JIT_CC_E  = 0x4,
+	JIT_CC_NE = 0x5,
+	JIT_CC_BE = 0x6,
+	JIT_CC_A  = 0x7,
+	JIT_CC_P  = 0xA,
+	JIT_CC_NP = 0xB,
+	JIT_CC_L  = 0xC,
+	JIT_CC_GE = 0xD,
+	JIT_CC_LE = 0xE,
+	JIT_CC_G  = 0xF,
+};
+
+// Where the result of an expression is left
+enum Jit_Value
+{
+	JIT_VALUE_NONE,
+	JIT_VALUE_INT,     // rax
+	JIT_VALUE_REAL,    // xmm0
+	JIT_VALUE_ADDRESS, // rax points to the value
+};
+
+// Size of the registers saved by the prologue below rbp
+constexpr int32_t JIT_SAVED_SIZE = 4 * sizeof(uint64_t);
+
+struct Jit_Fixup
+{
+	uint32_t position;
+	uint32_t label;
+};
+
+struct Jit_Loop
+{
+	uint32_t break_label;
+	uint32_t continue_label;
+};
+
+struct Jit_Compiler
+{
+	Jit *            jit       = nullptr;
+	Code_Node_Block *procedure = nullptr; // Null when compiling a loop
+
+	Array<uint8_t>   code;
+	Array<int64_t>   labels;
+	Array<Jit_Fixup> fixups;
+	Array<Jit_Loop>  loops;
+
+	uint32_t body_label   = 0;
+	uint32_t return_label = 0;
+
+	uint32_t pushed         = 0; // 8 byte values pushed on top of the native frame
+	uint32_t temporary_size = 0; // Below the saved registers
+	bool     failed         = false;
+};
+
+static Jit_Value jit_emit_expression(Jit_Compiler *compiler, Code_Node *root);
+static void      jit_emit_statement(Jit_Compiler *compiler, Code_Node_Statement *root);
+
+//
+//
+//
+
+static inline void jit_byte(Jit_Compiler *compiler, uint8_t value)
+{
+	compiler->code.Add(value);
+}
+
+static inline void jit_u32(Jit_Compiler *compiler, uint32_t value)
+{
+	memcpy(compiler->code.AddN(sizeof(value)), &value, sizeof(value));
+}
+
+static inline void jit_u64(Jit_Compiler *compiler, uint64_t value)
+{
+	memcpy(compiler->code.AddN(sizeof(value)), &value, sizeof(value));
+}
+
+static inline Jit_Value jit_fail(Jit_Compiler *compiler)
+{
+	compiler->failed = true;
+	return JIT_VALUE_NONE;
+}
+
+static inline int32_t jit_displacement(Jit_Compiler *compiler, uint64_t offset)
+{
+	if (offset > INT32_MAX)
+	{
+		jit_fail(compiler);
+		return 0;
+	}
+	return (int32_t)offset;
+}
+
+// [prefix] [rex] opcode, where opcode carries its 0x0F escape in the upper byte
+static void jit_opcode(Jit_Compiler *compiler, uint8_t prefix, bool wide, uint32_t reg, uint32_t rm, uint32_t opcode)
+{
+	if (prefix)
+		jit_byte(compiler, prefix);
+
+	uint8_t rex = 0x40 | (wide ? 0x8 : 0) | ((reg & 8) ? 0x4 : 0) | ((rm & 8) ? 0x1 : 0);
+	if (rex != 0x40)
+		jit_byte(compiler, rex);
+
+	if (opcode > 0xFF)
+		jit_byte(compiler, (uint8_t)(opcode >> 8));
+	jit_byte(compiler, (uint8_t)opcode);
+}
+
+// op reg, rm
+static void jit_rr(Jit_Compiler *compiler, uint8_t prefix, uint32_t opcode, bool wide, uint32_t reg, uint32_t rm)
+{
+	jit_opcode(compiler, prefix, wide, reg, rm, opcode);
+	jit_byte(compiler, (uint8_t)(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// op reg, [base + displacement]
+static void jit_rm(Jit_Compiler *compiler, uint8_t prefix, uint32_t opcode, bool wide, uint32_t reg, uint32_t base, int32_t displacement)
+{
+	jit_opcode(compiler, prefix, wide, reg, base, opcode);
+	jit_byte(compiler, (uint8_t)(0x80 | ((reg & 7) << 3) | (base & 7)));
+	if ((base & 7) == JIT_RSP)
+		jit_byte(compiler, 0x24);
+	jit_u32(compiler, (uint32_t)displacement);
+}
+
+static void jit_mov_imm(Jit_Compiler *compiler, uint32_t reg, uint64_t value)
+{
+	if (value <= UINT32_MAX)
+	{
+		jit_opcode(compiler, 0, false, 0, reg, 0xB8 + (reg & 7));
+		jit_u32(compiler, (uint32_t)value);
+	}
+	else
+	{
+		jit_opcode(compiler, 0, true, 0, reg, 0xB8 + (reg & 7));
+		jit_u64(compiler, value);
+	}
+}
+
+static inline void jit_mov(Jit_Compiler *compiler, uint32_t dst, uint32_t src)
+{
+	jit_rr(compiler, 0, 0x8B, true, dst, src);
+}
+
+static inline void jit_lea(Jit_Compiler *compiler, uint32_t dst, uint32_t base, int32_t displacement)
+{
+	jit_rm(compiler, 0, 0x8D, true, dst, base, displacement);
+}
+
+// add, or, and, sub, xor, cmp and test in their (rm, reg) form
+static inline void jit_alu(Jit_Compiler *compiler, uint32_t opcode, bool wide, uint32_t dst, uint32_t src)
+{
+	jit_rr(compiler, 0, opcode, wide, src, dst);
+}
+
+static inline void jit_alu_imm(Jit_Compiler *compiler, uint32_t extension, uint32_t dst, int32_t value)
+{
+	jit_rr(compiler, 0, 0x81, true, extension, dst);
+	jit_u32(compiler, (uint32_t)value);
+}
+
+static inline void jit_movzx_byte(Jit_Compiler *compiler, uint32_t reg)
+{
+	jit_rr(compiler, 0, 0x0FB6, false, reg, reg);
+}
+
+static inline void jit_setcc(Jit_Compiler *compiler, Jit_Condition cc, uint32_t reg)
+{
+	jit_rr(compiler, 0, 0x0F90 + cc, false, 0, reg);
+}
+
+static void jit_push(Jit_Compiler *compiler, Jit_Value value)
+{
+	if (value == JIT_VALUE_REAL)
+		jit_rr(compiler, 0x66, 0x0F7E, true, 0, JIT_RAX); // movq rax, xmm0
+	jit_byte(compiler, 0x50 + JIT_RAX);
+	compiler->pushed += 1;
+}
+
+// Pops into rcx, or xmm1 for reals
+static void jit_pop(Jit_Compiler *compiler, Jit_Value value)
+{
+	jit_byte(compiler, 0x58 + JIT_RCX);
+	compiler->pushed -= 1;
+	if (value == JIT_VALUE_REAL)
+		jit_rr(compiler, 0x66, 0x0F6E, true, 1, JIT_RCX); // movq xmm1, rcx
+}
+
+static void jit_call(Jit_Compiler *compiler, uint32_t reg)
+{
+	bool pad = (compiler->pushed & 1) != 0;
+	if (pad)
+		jit_alu_imm(compiler, 5, JIT_RSP, 8);
+	jit_rr(compiler, 0, 0xFF, false, 2, reg);
+	if (pad)
+		jit_alu_imm(compiler, 0, JIT_RSP, 8);
+}
+
+static inline void jit_call_function(Jit_Compiler *compiler, void *function)
+{
+	jit_mov_imm(compiler, JIT_RAX, (uint64_t)function);
+	jit_call(compiler, JIT_RAX);
+}
+
+// Copies (size) bytes from the address in (src) to [base + displacement], clobbers the caller saved registers
+static void jit_copy(Jit_Compiler *compiler, uint32_t base, int32_t displacement, uint32_t src, uint64_t size)
+{
+	Assert(base != JIT_RSI);
+	if (src != JIT_RSI)
+		jit_mov(compiler, JIT_RSI, src);
+	jit_lea(compiler, JIT_RDI, base, displacement);
+	jit_mov_imm(compiler, JIT_RDX, size);
+	jit_call_function(compiler, (void *)memmove);
+}
+
+//
+//
+//
+
+static uint32_t jit_label(Jit_Compiler *compiler)
+{
+	compiler->labels.Add(-1);
+	return (uint32_t)(compiler->labels.count - 1);
+}
+
+static inline void jit_bind(Jit_Compiler *compiler, uint32_t label)
+{
+	compiler->labels[label] = compiler->code.count;
+}
+
+static inline void jit_rel32(Jit_Compiler *compiler, uint32_t label)
+{
+	compiler->fixups.Add(Jit_Fixup{ (uint32_t)compiler->code.count, label });
+	jit_u32(compiler, 0);
+}
+
+static inline void jit_jump(Jit_Compiler *compiler, uint32_t label)
+{
+	jit_byte(compiler, 0xE9);
+	jit_rel32(compiler, label);
+}
+
+static inline void jit_branch(Jit_Compiler *compiler, Jit_Condition cc, uint32_t label)
+{
+	jit_byte(compiler, 0x0F);
+	jit_byte(compiler, (uint8_t)(0x80 + cc));
+	jit_rel32(compiler, label);
+}
+
+static inline Jit_Condition jit_invert(Jit_Condition cc)
+{
+	return (Jit_Condition)(cc ^ 1);
+}
+
+//
+//
+//
+
+static Jit_Value jit_value_kind(Code_Type *type)
+{
+	switch (type->kind)
+	{
+		case CODE_TYPE_CHARACTER:
+		case CODE_TYPE_BOOL:
+		case CODE_TYPE_INTEGER:
+		case CODE_TYPE_POINTER: return JIT_VALUE_INT;
+		case CODE_TYPE_REAL: return JIT_VALUE_REAL;
+		default: return JIT_VALUE_ADDRESS;
+	}
+}
+
+// Loads the scalar at the address in (base) into rax or xmm0
+static Jit_Value jit_load(Jit_Compiler *compiler, Code_Type *type, uint32_t base)
+{
+	auto kind = jit_value_kind(type);
+	if (kind == JIT_VALUE_REAL)
+		jit_rm(compiler, 0xF2, 0x0F10, false, 0, base, 0);
+	else if (type->runtime_size == 1)
+		jit_rm(compiler, 0, 0x0FB6, false, JIT_RAX, base, 0);
+	else
+		jit_rm(compiler, 0, 0x8B, true, JIT_RAX, base, 0);
+	return kind;
+}
+
+// Stores a value held in (src), the xmm register with that number for reals, to [base + displacement]
+static void jit_store(Jit_Compiler *compiler, Jit_Value value, Code_Type *type, uint32_t base, int32_t displacement, uint32_t src)
+{
+	switch (value)
+	{
+		case JIT_VALUE_INT: {
+			if (type->runtime_size == 1)
+				jit_rm(compiler, 0, 0x88, false, src, base, displacement);
+			else
+				jit_rm(compiler, 0, 0x89, true, src, base, displacement);
+		}
+		break;
+
+		case JIT_VALUE_REAL: {
+			jit_rm(compiler, 0xF2, 0x0F11, false, src, base, displacement);
+		}
+		break;
+
+		case JIT_VALUE_ADDRESS: {
+			jit_copy(compiler, base, displacement, src, type->runtime_size);
+		}
+		break;
+
+		NoDefaultCase();
+	}
+}
+
+// Evaluates an rvalue: scalars end up in a register, aggregates stay as their address
+static Jit_Value jit_emit_value(Jit_Compiler *compiler, Code_Node *root)
+{
+	auto value = jit_emit_expression(compiler, root);
+	if (value == JIT_VALUE_ADDRESS && root->type)
+	{
+		if (jit_value_kind(root->type) != JIT_VALUE_ADDRESS)
+			return jit_load(compiler, root->type, JIT_RAX);
+	}
+	return value;
+}
+
+static Jit_Value jit_emit_scalar(Jit_Compiler *compiler, Code_Node *root)
+{
+	auto value = jit_emit_value(compiler, root);
+	if (value != JIT_VALUE_INT && value != JIT_VALUE_REAL)
+		return jit_fail(compiler);
+	return value;
+}
+
+//
+//
+//
+
+static void jit_emit_callee(Jit_Compiler *compiler, const Symbol_Address *callee)
+{
+	auto value   = new Code_Value_Procedure;
+	value->block = callee->kind == Symbol_Address::CODE ? callee->code : nullptr;
+	value->ccall = callee->kind == Symbol_Address::CCALL ? callee->ccall : nullptr;
+	compiler->jit->constants.Add(value);
+	jit_mov_imm(compiler, JIT_RAX, (uint64_t)value);
+}
+
+static Jit_Value jit_emit_literal(Jit_Compiler *compiler, Code_Node_Literal *node)
+{
+	auto kind = jit_value_kind(node->type);
+	if (kind == JIT_VALUE_ADDRESS)
+	{
+		jit_mov_imm(compiler, JIT_RAX, (uint64_t)&node->data);
+		return JIT_VALUE_ADDRESS;
+	}
+
+	uint64_t bits = 0;
+	memcpy(&bits, &node->data, node->type->runtime_size);
+	jit_mov_imm(compiler, JIT_RAX, bits);
+
+	if (kind == JIT_VALUE_REAL)
+		jit_rr(compiler, 0x66, 0x0F6E, true, 0, JIT_RAX); // movq xmm0, rax
+
+	return kind;
+}
+
+// Adds (index * scale) to the address in rax
+static void jit_emit_index(Jit_Compiler *compiler, Code_Node *index, uint64_t scale)
+{
+	jit_push(compiler, JIT_VALUE_ADDRESS);
+	if (jit_emit_scalar(compiler, index) != JIT_VALUE_INT || scale > INT32_MAX)
+		jit_fail(compiler);
+	jit_rr(compiler, 0, 0x69, true, JIT_RAX, JIT_RAX); // imul rax, rax, scale
+	jit_u32(compiler, (uint32_t)scale);
+	jit_pop(compiler, JIT_VALUE_INT);
+	jit_alu(compiler, 0x01, true, JIT_RAX, JIT_RCX);
+}
+
+static Jit_Value jit_emit_address(Jit_Compiler *compiler, Code_Node_Address *node)
+{
+	if (node->subscript)
+	{
+		if (jit_emit_expression(compiler, node->subscript->expression) != JIT_VALUE_ADDRESS)
+			return jit_fail(compiler);
+
+		// @Note: Array views and strings keep their data pointer after the count
+		auto kind = node->subscript->expression->type->kind;
+		if (kind == CODE_TYPE_ARRAY_VIEW || kind == CODE_TYPE_STRUCT)
+			jit_rm(compiler, 0, 0x8B, true, JIT_RAX, JIT_RAX, (int32_t)offsetof(String, data));
+
+		if (node->offset)
+			jit_alu_imm(compiler, 0, JIT_RAX, jit_displacement(compiler, node->offset));
+
+		jit_emit_index(compiler, node->subscript->subscript, node->subscript->type->runtime_size);
+	}
+	else
+	{
+		uint32_t base   = JIT_R12;
+		uint64_t offset = node->offset;
+
+		if (node->address)
+		{
+			switch (node->address->kind)
+			{
+				case Symbol_Address::STACK: base = JIT_R12; break;
+				case Symbol_Address::GLOBAL: base = JIT_R13; break;
+
+				case Symbol_Address::CODE:
+				case Symbol_Address::CCALL: {
+					jit_emit_callee(compiler, node->address);
+					return JIT_VALUE_ADDRESS;
+				}
+
+				NoDefaultCase();
+			}
+			offset += node->address->offset;
+		}
+
+		jit_lea(compiler, JIT_RAX, base, jit_displacement(compiler, offset));
+	}
+
+	for (int64_t index = 0; index < node->index_count; ++index)
+		jit_emit_index(compiler, node->indices[index].expression, node->indices[index].stride);
+
+	return JIT_VALUE_ADDRESS;
+}
+
+static Jit_Value jit_emit_offset(Jit_Compiler *compiler, Code_Node_Offset *node)
+{
+	if (jit_emit_expression(compiler, node->expression) != JIT_VALUE_ADDRESS)
+		return jit_fail(compiler);
+	jit_alu_imm(compiler, 0, JIT_RAX, jit_displacement(compiler, node->offset));
+	return JIT_VALUE_ADDRESS;
+}
+
+// Sets rax to 1 when the scalar in xmm0 is not zero
+static void jit_emit_real_truth(Jit_Compiler *compiler)
+{
+	jit_rr(compiler, 0x66, 0x0F57, false, 1, 1);  // xorpd xmm1, xmm1
+	jit_rr(compiler, 0x66, 0x0F2E, false, 0, 1);  // ucomisd xmm0, xmm1
+	jit_setcc(compiler, JIT_CC_NE, JIT_RAX);
+	jit_setcc(compiler, JIT_CC_P, JIT_RCX);
+	jit_alu(compiler, 0x09, false, JIT_RAX, JIT_RCX);
+	jit_movzx_byte(compiler, JIT_RAX);
+}
+
+static Jit_Value jit_emit_type_cast(Jit_Compiler *compiler, Code_Node_Type_Cast *node)
+{
+	auto to   = node->type->kind;
+	auto from = node->child->type->kind;
+
+	if (to == CODE_TYPE_ARRAY_VIEW)
+	{
+		if (from != CODE_TYPE_STATIC_ARRAY || jit_emit_expression(compiler, node->child) != JIT_VALUE_ADDRESS)
+			return jit_fail(compiler);
+
+		compiler->temporary_size += sizeof(Array_View<uint8_t>);
+		int32_t slot = -(JIT_SAVED_SIZE + (int32_t)compiler->temporary_size);
+
+		jit_rm(compiler, 0, 0x89, true, JIT_RAX, JIT_RBP, slot + (int32_t)offsetof(Array_View<uint8_t>, data));
+		jit_mov_imm(compiler, JIT_RCX, ((Code_Type_Static_Array *)node->child->type)->element_count);
+		jit_rm(compiler, 0, 0x89, true, JIT_RCX, JIT_RBP, slot + (int32_t)offsetof(Array_View<uint8_t>, count));
+		jit_lea(compiler, JIT_RAX, JIT_RBP, slot);
+		return JIT_VALUE_ADDRESS;
+	}
+
+	auto value = jit_emit_scalar(compiler, node->child);
+	if (compiler->failed)
+		return JIT_VALUE_NONE;
+
+	switch (to)
+	{
+		case CODE_TYPE_REAL: {
+			if (value != JIT_VALUE_INT)
+				return jit_fail(compiler);
+			jit_rr(compiler, 0xF2, 0x0F2A, true, 0, JIT_RAX); // cvtsi2sd xmm0, rax
+			return JIT_VALUE_REAL;
+		}
+
+		case CODE_TYPE_CHARACTER:
+		case CODE_TYPE_INTEGER: {
+			if (value == JIT_VALUE_REAL)
+				jit_rr(compiler, 0xF2, 0x0F2C, true, JIT_RAX, 0); // cvttsd2si rax, xmm0
+			if (to == CODE_TYPE_CHARACTER)
+				jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+
+		case CODE_TYPE_BOOL: {
+			if (value == JIT_VALUE_REAL)
+			{
+				jit_emit_real_truth(compiler);
+			}
+			else
+			{
+				jit_alu(compiler, 0x85, true, JIT_RAX, JIT_RAX);
+				jit_setcc(compiler, JIT_CC_NE, JIT_RAX);
+				jit_movzx_byte(compiler, JIT_RAX);
+			}
+			return JIT_VALUE_INT;
+		}
+
+		case CODE_TYPE_POINTER: {
+			if (from != CODE_TYPE_POINTER)
+				return jit_fail(compiler);
+			return JIT_VALUE_INT;
+		}
+	}
+
+	return jit_fail(compiler);
+}
+
+static Jit_Value jit_emit_unary_operator(Jit_Compiler *compiler, Code_Node_Unary_Operator *node)
+{
+	switch (node->operation)
+	{
+		case UNARY_OPERATION_PLUS: return jit_emit_expression(compiler, node->child);
+
+		case UNARY_OPERATION_MINUS_CHAR:
+		case UNARY_OPERATION_MINUS_INT:
+		case UNARY_OPERATION_BITWISE_NOT_CHAR:
+		case UNARY_OPERATION_BITWISE_NOT_INT: {
+			if (jit_emit_scalar(compiler, node->child) != JIT_VALUE_INT)
+				return jit_fail(compiler);
+
+			bool minus = node->operation == UNARY_OPERATION_MINUS_CHAR || node->operation == UNARY_OPERATION_MINUS_INT;
+			jit_rr(compiler, 0, 0xF7, true, minus ? 3 : 2, JIT_RAX); // neg, not
+
+			if (node->operation == UNARY_OPERATION_MINUS_CHAR || node->operation == UNARY_OPERATION_BITWISE_NOT_CHAR)
+				jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+
+		case UNARY_OPERATION_MINUS_REAL: {
+			if (jit_emit_scalar(compiler, node->child) != JIT_VALUE_REAL)
+				return jit_fail(compiler);
+			jit_mov_imm(compiler, JIT_RAX, 0x8000000000000000ull);
+			jit_rr(compiler, 0x66, 0x0F6E, true, 1, JIT_RAX); // movq xmm1, rax
+			jit_rr(compiler, 0x66, 0x0F57, false, 0, 1);      // xorpd xmm0, xmm1
+			return JIT_VALUE_REAL;
+		}
+
+		case UNARY_OPERATION_LOGICAL_NOT_BOOL: {
+			if (jit_emit_scalar(compiler, node->child) != JIT_VALUE_INT)
+				return jit_fail(compiler);
+			jit_rr(compiler, 0, 0x83, false, 6, JIT_RAX); // xor eax, 1
+			jit_byte(compiler, 1);
+			return JIT_VALUE_INT;
+		}
+
+		case UNARY_OPERATION_DEREFERENCE: {
+			if (jit_emit_scalar(compiler, node->child) != JIT_VALUE_INT)
+				return jit_fail(compiler);
+			return JIT_VALUE_ADDRESS;
+		}
+
+		case UNARY_OPERATION_POINTER_TO: {
+			if (jit_emit_expression(compiler, node->child) != JIT_VALUE_ADDRESS)
+				return jit_fail(compiler);
+			return JIT_VALUE_INT;
+		}
+	}
+
+	return jit_fail(compiler);
+}
+
+// Finds the condition code of a comparison of two integers, chars, pointers or bools
+static bool jit_comparison(Binary_Operation operation, Jit_Condition *cc)
+{
+	switch (operation)
+	{
+		case BINARY_OPERATION_GT_INT: *cc = JIT_CC_G; return true;
+		case BINARY_OPERATION_LT_INT: *cc = JIT_CC_L; return true;
+		case BINARY_OPERATION_GE_INT: *cc = JIT_CC_GE; return true;
+		case BINARY_OPERATION_LE_INT: *cc = JIT_CC_LE; return true;
+
+		case BINARY_OPERATION_GT_CHAR:
+		case BINARY_OPERATION_GT_POINTER: *cc = JIT_CC_A; return true;
+		case BINARY_OPERATION_LT_CHAR:
+		case BINARY_OPERATION_LT_POINTER: *cc = JIT_CC_B; return true;
+		case BINARY_OPERATION_GE_CHAR:
+		case BINARY_OPERATION_GE_POINTER: *cc = JIT_CC_AE; return true;
+		case BINARY_OPERATION_LE_CHAR:
+		case BINARY_OPERATION_LE_POINTER: *cc = JIT_CC_BE; return true;
+
+		case BINARY_OPERATION_EQ_CHAR:
+		case BINARY_OPERATION_EQ_INT:
+		case BINARY_OPERATION_EQ_BOOL:
+		case BINARY_OPERATION_EQ_POINTER: *cc = JIT_CC_E; return true;
+		case BINARY_OPERATION_NE_CHAR:
+		case BINARY_OPERATION_NE_INT:
+		case BINARY_OPERATION_NE_BOOL:
+		case BINARY_OPERATION_NE_POINTER: *cc = JIT_CC_NE; return true;
+	}
+	return false;
+}
+
+// Applies the operation to rax/xmm0 (left) and rcx/xmm1 (right), leaving the result in rax/xmm0
+static Jit_Value jit_emit_operation(Jit_Compiler *compiler, Binary_Operation operation)
+{
+	Jit_Condition cc;
+	if (jit_comparison(operation, &cc))
+	{
+		jit_alu(compiler, 0x39, true, JIT_RAX, JIT_RCX);
+		jit_setcc(compiler, cc, JIT_RAX);
+		jit_movzx_byte(compiler, JIT_RAX);
+		return JIT_VALUE_INT;
+	}
+
+	switch (operation)
+	{
+		case BINARY_OPERATION_ADD_INT:
+		case BINARY_OPERATION_ADD_POINTER: jit_alu(compiler, 0x01, true, JIT_RAX, JIT_RCX); return JIT_VALUE_INT;
+		case BINARY_OPERATION_SUB_INT:
+		case BINARY_OPERATION_SUB_POINTER: jit_alu(compiler, 0x29, true, JIT_RAX, JIT_RCX); return JIT_VALUE_INT;
+		case BINARY_OPERATION_AND_INT:
+		case BINARY_OPERATION_AND_CHAR: jit_alu(compiler, 0x21, true, JIT_RAX, JIT_RCX); return JIT_VALUE_INT;
+		case BINARY_OPERATION_XOR_INT:
+		case BINARY_OPERATION_XOR_CHAR: jit_alu(compiler, 0x31, true, JIT_RAX, JIT_RCX); return JIT_VALUE_INT;
+		case BINARY_OPERATION_OR_INT:
+		case BINARY_OPERATION_OR_CHAR: jit_alu(compiler, 0x09, true, JIT_RAX, JIT_RCX); return JIT_VALUE_INT;
+		case BINARY_OPERATION_MUL_INT: jit_rr(compiler, 0, 0x0FAF, true, JIT_RAX, JIT_RCX); return JIT_VALUE_INT;
+
+		case BINARY_OPERATION_DIV_INT:
+		case BINARY_OPERATION_MOD_INT: {
+			jit_byte(compiler, 0x48); // cqo
+			jit_byte(compiler, 0x99);
+			jit_rr(compiler, 0, 0xF7, true, 7, JIT_RCX); // idiv rcx
+			if (operation == BINARY_OPERATION_MOD_INT)
+				jit_mov(compiler, JIT_RAX, JIT_RDX);
+			return JIT_VALUE_INT;
+		}
+
+		case BINARY_OPERATION_SHR_INT: jit_rr(compiler, 0, 0xD3, true, 7, JIT_RAX); return JIT_VALUE_INT; // sar rax, cl
+		case BINARY_OPERATION_SHL_INT: jit_rr(compiler, 0, 0xD3, true, 4, JIT_RAX); return JIT_VALUE_INT;
+		case BINARY_OPERATION_SHR_CHAR: jit_rr(compiler, 0, 0xD3, false, 5, JIT_RAX); return JIT_VALUE_INT;
+
+		// @Note: Chars are promoted to int by the interpreter and truncated back to 8 bits
+		case BINARY_OPERATION_ADD_CHAR:
+		case BINARY_OPERATION_SUB_CHAR:
+		case BINARY_OPERATION_MUL_CHAR:
+		case BINARY_OPERATION_SHL_CHAR: {
+			if (operation == BINARY_OPERATION_ADD_CHAR) jit_alu(compiler, 0x01, false, JIT_RAX, JIT_RCX);
+			else if (operation == BINARY_OPERATION_SUB_CHAR) jit_alu(compiler, 0x29, false, JIT_RAX, JIT_RCX);
+			else if (operation == BINARY_OPERATION_MUL_CHAR) jit_rr(compiler, 0, 0x0FAF, false, JIT_RAX, JIT_RCX);
+			else jit_rr(compiler, 0, 0xD3, false, 4, JIT_RAX);
+			jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+
+		case BINARY_OPERATION_DIV_CHAR:
+		case BINARY_OPERATION_MOD_CHAR: {
+			jit_alu(compiler, 0x31, false, JIT_RDX, JIT_RDX);
+			jit_rr(compiler, 0, 0xF7, false, 6, JIT_RCX); // div ecx
+			if (operation == BINARY_OPERATION_MOD_CHAR)
+				jit_mov(compiler, JIT_RAX, JIT_RDX);
+			jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+
+		case BINARY_OPERATION_ADD_REAL: jit_rr(compiler, 0xF2, 0x0F58, false, 0, 1); return JIT_VALUE_REAL;
+		case BINARY_OPERATION_SUB_REAL: jit_rr(compiler, 0xF2, 0x0F5C, false, 0, 1); return JIT_VALUE_REAL;
+		case BINARY_OPERATION_MUL_REAL: jit_rr(compiler, 0xF2, 0x0F59, false, 0, 1); return JIT_VALUE_REAL;
+		case BINARY_OPERATION_DIV_REAL: jit_rr(compiler, 0xF2, 0x0F5E, false, 0, 1); return JIT_VALUE_REAL;
+
+		// @Note: ucomisd leaves the unordered case in PF, NaN compares false except for !=
+		case BINARY_OPERATION_GT_REAL:
+		case BINARY_OPERATION_GE_REAL: {
+			jit_rr(compiler, 0x66, 0x0F2E, false, 0, 1);
+			jit_setcc(compiler, operation == BINARY_OPERATION_GT_REAL ? JIT_CC_A : JIT_CC_AE, JIT_RAX);
+			jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+
+		case BINARY_OPERATION_LT_REAL:
+		case BINARY_OPERATION_LE_REAL: {
+			jit_rr(compiler, 0x66, 0x0F2E, false, 1, 0);
+			jit_setcc(compiler, operation == BINARY_OPERATION_LT_REAL ? JIT_CC_A : JIT_CC_AE, JIT_RAX);
+			jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+
+		case BINARY_OPERATION_EQ_REAL:
+		case BINARY_OPERATION_NE_REAL: {
+			bool equal = operation == BINARY_OPERATION_EQ_REAL;
+			jit_rr(compiler, 0x66, 0x0F2E, false, 0, 1);
+			jit_setcc(compiler, equal ? JIT_CC_E : JIT_CC_NE, JIT_RAX);
+			jit_setcc(compiler, equal ? JIT_CC_NP : JIT_CC_P, JIT_RCX);
+			jit_alu(compiler, equal ? 0x21 : 0x09, false, JIT_RAX, JIT_RCX);
+			jit_movzx_byte(compiler, JIT_RAX);
+			return JIT_VALUE_INT;
+		}
+	}
+
+	return jit_fail(compiler);
+}
+
+static void jit_emit_branch(Jit_Compiler *compiler, Code_Node *root, bool when, uint32_t label);
+
+static Jit_Value jit_emit_condition_value(Jit_Compiler *compiler, Code_Node *root)
+{
+	auto is_false = jit_label(compiler);
+	auto done     = jit_label(compiler);
+	jit_emit_branch(compiler, root, false, is_false);
+	jit_mov_imm(compiler, JIT_RAX, 1);
+	jit_jump(compiler, done);
+	jit_bind(compiler, is_false);
+	jit_mov_imm(compiler, JIT_RAX, 0);
+	jit_bind(compiler, done);
+	return JIT_VALUE_INT;
+}
+
+static Jit_Value jit_emit_binary_operator(Jit_Compiler *compiler, Code_Node_Binary_Operator *node)
+{
+	if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND || node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
+		return jit_emit_condition_value(compiler, node);
+
+	auto operation = node->operation;
+	bool compound  = operation >= BINARY_OPERATION_COMPOUND_ADD_CHAR && operation <= BINARY_OPERATION_COMPOUND_OR_INT;
+
+	// @Note: Same evaluation order as the interpreter, right operand first
+	auto right = jit_emit_scalar(compiler, node->right);
+	if (compiler->failed)
+		return JIT_VALUE_NONE;
+	jit_push(compiler, right);
+
+	if (compound)
+	{
+		static_assert(BINARY_OPERATION_COMPOUND_OR_INT - BINARY_OPERATION_COMPOUND_ADD_CHAR ==
+			BINARY_OPERATION_OR_INT - BINARY_OPERATION_ADD_CHAR, "Compound operations must mirror the arithmetic operations");
+
+		if (jit_emit_expression(compiler, node->left) != JIT_VALUE_ADDRESS)
+			return jit_fail(compiler);
+
+		jit_mov(compiler, JIT_RSI, JIT_RAX);
+		jit_pop(compiler, right);
+
+		auto type  = node->left->type;
+		auto value = jit_load(compiler, type, JIT_RSI);
+		jit_emit_operation(compiler, (Binary_Operation)(operation - BINARY_OPERATION_COMPOUND_ADD_CHAR + BINARY_OPERATION_ADD_CHAR));
+		jit_store(compiler, value, type, JIT_RSI, 0, JIT_RAX);
+
+		jit_mov(compiler, JIT_RAX, JIT_RSI);
+		return JIT_VALUE_ADDRESS;
+	}
+
+	jit_emit_scalar(compiler, node->left);
+	jit_pop(compiler, right);
+	return jit_emit_operation(compiler, operation);
+}
+
+// Jumps to (label) when the condition evaluates to (when), && and || are short circuited
+static void jit_emit_branch(Jit_Compiler *compiler, Code_Node *root, bool when, uint32_t label)
+{
+	switch (root->kind)
+	{
+		case CODE_NODE_EXPRESSION: {
+			jit_emit_branch(compiler, ((Code_Node_Expression *)root)->child, when, label);
+			return;
+		}
+
+		case CODE_NODE_UNARY_OPERATOR: {
+			auto node = (Code_Node_Unary_Operator *)root;
+			if (node->op_kind == UNARY_OPERATOR_LOGICAL_NOT)
+			{
+				jit_emit_branch(compiler, node->child, !when, label);
+				return;
+			}
+		}
+		break;
+
+		case CODE_NODE_BINARY_OPERATOR: {
+			auto node = (Code_Node_Binary_Operator *)root;
+			if (node->op_kind == BINARY_OPERATOR_LOGICAL_AND || node->op_kind == BINARY_OPERATOR_LOGICAL_OR)
+			{
+				// a && b jumps on false as soon as one of them is false, a || b on true as soon as one is true
+				bool shortcut = node->op_kind == BINARY_OPERATOR_LOGICAL_OR;
+				if (when == shortcut)
+				{
+					jit_emit_branch(compiler, node->left, when, label);
+					jit_emit_branch(compiler, node->right, when, label);
+				}
+				else
+				{
+					auto skip = jit_label(compiler);
+					jit_emit_branch(compiler, node->left, shortcut, skip);
+					jit_emit_branch(compiler, node->right, when, label);
+					jit_bind(compiler, skip);
+				}
+				return;
+			}
+
+			Jit_Condition cc;
+			if (jit_comparison(node->operation, &cc))
+			{
+				auto right = jit_emit_scalar(compiler, node->right);
+				jit_push(compiler, right);
+				jit_emit_scalar(compiler, node->left);
+				jit_pop(compiler, right);
+				jit_alu(compiler, 0x39, true, JIT_RAX, JIT_RCX);
+				jit_branch(compiler, when ? cc : jit_invert(cc), label);
+				return;
+			}
+		}
+		break;
+
+		case CODE_NODE_TYPE_CAST: {
+			auto node = (Code_Node_Type_Cast *)root;
+			if (node->type->kind == CODE_TYPE_BOOL)
+			{
+				jit_emit_branch(compiler, node->child, when, label);
+				return;
+			}
+		}
+		break;
+	}
+
+	auto value = jit_emit_scalar(compiler, root);
+	if (value == JIT_VALUE_REAL)
+		jit_emit_real_truth(compiler);
+	else
+		jit_alu(compiler, 0x85, true, JIT_RAX, JIT_RAX);
+	jit_branch(compiler, when ? JIT_CC_NE : JIT_CC_E, label);
+}
+
+//
+//
+//
+
+static void jit_emit_arguments(Jit_Compiler *compiler, Code_Node_Procedure_Call *root)
+{
+	uint64_t offset = root->stack_top;
+	for (int64_t index = 0; index < root->variadic_count; ++index)
+	{
+		auto variadic = root->variadics[index];
+		auto value    = jit_emit_value(compiler, variadic);
+		if (value == JIT_VALUE_NONE)
+		{
+			jit_fail(compiler);
+			return;
+		}
+
+		// @Note: The value is stored before its Code_Type *, same as interp_eval_arguments
+		jit_store(compiler, value, variadic->type, JIT_R12, jit_displacement(compiler, offset + sizeof(Code_Type *)), JIT_RAX);
+		jit_mov_imm(compiler, JIT_RAX, (uint64_t)variadic->type);
+		jit_rm(compiler, 0, 0x89, true, JIT_RAX, JIT_R12, jit_displacement(compiler, offset));
+
+		offset += sizeof(Code_Type *) + variadic->type->runtime_size;
+	}
+
+	for (int64_t index = 0; index < root->parameter_count; ++index)
+	{
+		auto parameter = root->parameters[index];
+		auto value     = jit_emit_value(compiler, parameter);
+		if (value == JIT_VALUE_NONE)
+		{
+			jit_fail(compiler);
+			return;
+		}
+
+		auto slot = root->frame_offset + root->parameter_offsets[index];
+		jit_store(compiler, value, parameter->type, JIT_R12, jit_displacement(compiler, slot), JIT_RAX);
+	}
+}
+
+static void jit_call_procedure(Interpreter *interp, Code_Value_Procedure *procedure, Code_Node_Procedure_Call *call, uint8_t *frame)
+{
+	interp_call(interp, *procedure, call->procedure_type, frame);
+}
+
+// Calls the procedure value at the address in rax with its frame at r12 + frame_offset, the interpreter
+// picks the native code of the callee once it is compiled
+static void jit_emit_call(Jit_Compiler *compiler, Code_Node_Procedure_Call *call)
+{
+	jit_mov(compiler, JIT_RSI, JIT_RAX);
+	jit_mov(compiler, JIT_RDI, JIT_RBX);
+	jit_mov_imm(compiler, JIT_RDX, (uint64_t)call);
+	jit_lea(compiler, JIT_RCX, JIT_R12, jit_displacement(compiler, call->frame_offset));
+	jit_call_function(compiler, (void *)jit_call_procedure);
+}
+
+static Jit_Value jit_emit_procedure_call(Jit_Compiler *compiler, Code_Node_Procedure_Call *root)
+{
+	jit_emit_arguments(compiler, root);
+
+	if (root->callee)
+	{
+		jit_emit_callee(compiler, root->callee);
+	}
+	else
+	{
+		if (jit_emit_expression(compiler, root->procedure) != JIT_VALUE_ADDRESS)
+			return jit_fail(compiler);
+	}
+	jit_emit_call(compiler, root);
+
+	if (!root->type)
+		return JIT_VALUE_NONE;
+
+	jit_lea(compiler, JIT_RAX, JIT_R12, jit_displacement(compiler, root->frame_offset));
+	return JIT_VALUE_ADDRESS;
+}
+
+static void jit_emit_assignment(Jit_Compiler *compiler, Code_Node_Assignment *node)
+{
+	auto value = jit_emit_value(compiler, node->value);
+	if (value == JIT_VALUE_NONE)
+	{
+		jit_fail(compiler);
+		return;
+	}
+
+	jit_push(compiler, value);
+	if (jit_emit_expression(compiler, node->destination) != JIT_VALUE_ADDRESS)
+		jit_fail(compiler);
+	jit_pop(compiler, value);
+
+	jit_store(compiler, value, node->value->type, JIT_RAX, 0, value == JIT_VALUE_REAL ? 1 : JIT_RCX);
+}
+
+static Jit_Value jit_emit_expression(Jit_Compiler *compiler, Code_Node *root)
+{
+	if (compiler->failed)
+		return JIT_VALUE_NONE;
+
+	switch (root->kind)
+	{
+		case CODE_NODE_LITERAL: return jit_emit_literal(compiler, (Code_Node_Literal *)root);
+		case CODE_NODE_ADDRESS: return jit_emit_address(compiler, (Code_Node_Address *)root);
+		case CODE_NODE_OFFSET: return jit_emit_offset(compiler, (Code_Node_Offset *)root);
+		case CODE_NODE_TYPE_CAST: return jit_emit_type_cast(compiler, (Code_Node_Type_Cast *)root);
+		case CODE_NODE_UNARY_OPERATOR: return jit_emit_unary_operator(compiler, (Code_Node_Unary_Operator *)root);
+		case CODE_NODE_BINARY_OPERATOR: return jit_emit_binary_operator(compiler, (Code_Node_Binary_Operator *)root);
+		case CODE_NODE_EXPRESSION: return jit_emit_expression(compiler, ((Code_Node_Expression *)root)->child);
+		case CODE_NODE_PROCEDURE_CALL: return jit_emit_procedure_call(compiler, (Code_Node_Procedure_Call *)root);
+
+		case CODE_NODE_ASSIGNMENT: {
+			jit_emit_assignment(compiler, (Code_Node_Assignment *)root);
+			return JIT_VALUE_NONE;
+		}
+	}
+
+	return jit_fail(compiler);
+}
+
+//
+//
+//
+
+static void jit_emit_return(Jit_Compiler *compiler, Code_Node_Return *node)
+{
+	// The resolver leaves tail_call unset when an address into this frame has escaped, so the jump is free to overwrite it
+	if (node->tail_call)
+	{
+		auto call = node->tail_call;
+		jit_emit_arguments(compiler, call);
+
+		if (compiler->procedure && call->callee->code == compiler->procedure)
+		{
+			// @Note: Same as interp_reuse_frame, the staged parameters move down into the current frame
+			if (call->parameter_count)
+			{
+				auto last  = call->parameter_count - 1;
+				auto begin = call->parameter_offsets[0];
+				auto end   = call->parameter_offsets[last] + call->parameters[last]->type->runtime_size;
+				jit_lea(compiler, JIT_RAX, JIT_R12, jit_displacement(compiler, call->frame_offset + begin));
+				jit_copy(compiler, JIT_R12, jit_displacement(compiler, begin), JIT_RAX, end - begin);
+			}
+			jit_jump(compiler, compiler->body_label);
+			return;
+		}
+
+		// Any other callee is left to the trampoline of the interpreter, same as interp_eval_return
+		jit_mov_imm(compiler, JIT_RAX, (uint64_t)call);
+		jit_rm(compiler, 0, 0x89, true, JIT_RAX, JIT_RBX, (int32_t)offsetof(Interpreter, tail_call));
+	}
+	else if (node->expression)
+	{
+		auto value = jit_emit_value(compiler, node->expression);
+		if (value == JIT_VALUE_NONE)
+		{
+			jit_fail(compiler);
+			return;
+		}
+		jit_store(compiler, value, node->expression->type, JIT_R12, 0, JIT_RAX);
+	}
+
+	jit_jump(compiler, compiler->return_label);
+}
+
+static void jit_emit_for(Jit_Compiler *compiler, Code_Node_For *node, bool initialize)
+{
+	auto top  = jit_label(compiler);
+	auto next = jit_label(compiler);
+	auto exit = jit_label(compiler);
+
+	if (initialize)
+		jit_emit_statement(compiler, node->initialization);
+
+	jit_bind(compiler, top);
+	jit_emit_branch(compiler, node->condition->node, false, exit);
+
+	compiler->loops.Add(Jit_Loop{ exit, next });
+	jit_emit_statement(compiler, node->body);
+	compiler->loops.RemoveLast();
+
+	jit_bind(compiler, next);
+	jit_emit_statement(compiler, node->increment);
+	jit_jump(compiler, top);
+	jit_bind(compiler, exit);
+}
+
+static void jit_emit_while(Jit_Compiler *compiler, Code_Node_While *node)
+{
+	auto top  = jit_label(compiler);
+	auto exit = jit_label(compiler);
+
+	jit_bind(compiler, top);
+	jit_emit_branch(compiler, node->condition->node, false, exit);
+
+	compiler->loops.Add(Jit_Loop{ exit, top });
+	jit_emit_statement(compiler, node->body);
+	compiler->loops.RemoveLast();
+
+	jit_jump(compiler, top);
+	jit_bind(compiler, exit);
+}
+
+static void jit_emit_do(Jit_Compiler *compiler, Code_Node_Do *node, bool at_condition)
+{
+	auto top       = jit_label(compiler);
+	auto condition = jit_label(compiler);
+	auto exit      = jit_label(compiler);
+
+	if (at_condition)
+		jit_jump(compiler, condition);
+
+	jit_bind(compiler, top);
+	compiler->loops.Add(Jit_Loop{ exit, condition });
+	jit_emit_statement(compiler, node->body);
+	compiler->loops.RemoveLast();
+
+	jit_bind(compiler, condition);
+	jit_emit_branch(compiler, node->condition->node, true, top);
+	jit_bind(compiler, exit);
+}
+
+static void jit_emit_if(Jit_Compiler *compiler, Code_Node_If *node)
+{
+	auto otherwise = jit_label(compiler);
+	jit_emit_branch(compiler, node->condition, false, otherwise);
+	jit_emit_statement(compiler, node->true_statement);
+
+	if (node->false_statement)
+	{
+		auto done = jit_label(compiler);
+		jit_jump(compiler, done);
+		jit_bind(compiler, otherwise);
+		jit_emit_statement(compiler, node->false_statement);
+		jit_bind(compiler, done);
+	}
+	else
+	{
+		jit_bind(compiler, otherwise);
+	}
+}
+
+static void jit_emit_block(Jit_Compiler *compiler, Code_Node_Block *block)
+{
+	for (auto statement = block->statement_head; statement && !compiler->failed; statement = statement->next)
+		jit_emit_statement(compiler, statement);
+}
+
+static void jit_emit_statement(Jit_Compiler *compiler, Code_Node_Statement *root)
+{
+	if (compiler->failed)
+		return;
+
+	Assert(compiler->pushed == 0);
+
+	switch (root->node->kind)
+	{
+		case CODE_NODE_EXPRESSION: {
+			auto child = ((Code_Node_Expression *)root->node)->child;
+			switch (child->kind)
+			{
+				case CODE_NODE_RETURN: jit_emit_return(compiler, (Code_Node_Return *)child); break;
+				case CODE_NODE_BREAK: jit_jump(compiler, compiler->loops.Last().break_label); break;
+				case CODE_NODE_CONTINUE: jit_jump(compiler, compiler->loops.Last().continue_label); break;
+				default: jit_emit_expression(compiler, child); break;
+			}
+		}
+		break;
+
+		case CODE_NODE_ASSIGNMENT: jit_emit_assignment(compiler, (Code_Node_Assignment *)root->node); break;
+		case CODE_NODE_BLOCK: jit_emit_block(compiler, (Code_Node_Block *)root->node); break;
+		case CODE_NODE_IF: jit_emit_if(compiler, (Code_Node_If *)root->node); break;
+		case CODE_NODE_FOR: jit_emit_for(compiler, (Code_Node_For *)root->node, true); break;
+		case CODE_NODE_WHILE: jit_emit_while(compiler, (Code_Node_While *)root->node); break;
+		case CODE_NODE_DO: jit_emit_do(compiler, (Code_Node_Do *)root->node, false); break;
+
+		default: jit_fail(compiler); break;
+	}
+}
+
+//
+//
+//
+
+static Code_Jit_Proc jit_finalize(Jit *jit, Jit_Compiler *compiler)
+{
+#if JIT_NATIVE
+	for (auto &fixup : compiler->fixups)
+	{
+		auto target = compiler->labels[fixup.label];
+		Assert(target >= 0);
+		int32_t relative = (int32_t)(target - (int64_t)(fixup.position + sizeof(int32_t)));
+		memcpy(compiler->code.data + fixup.position, &relative, sizeof(relative));
+	}
+
+	size_t size   = AlignPower2Up((size_t)compiler->code.count, (size_t)4096);
+	void * memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return nullptr;
+
+	memcpy(memory, compiler->code.data, compiler->code.count);
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(memory, size);
+		return nullptr;
+	}
+
+	jit->regions.Add(Jit::Region{ memory, size });
+	return (Code_Jit_Proc)memory;
+#else
+	return nullptr;
+#endif
+}
+
+// Compiles either a procedure body or a loop entered at its condition into
+// int code(Interpreter *interp, uint8_t *frame), returning an Interp_Completion
+static Code_Jit_Proc jit_compile(Jit *jit, Code_Node_Block *procedure, Code_Node *loop)
+{
+	Jit_Compiler compiler;
+	compiler.jit          = jit;
+	compiler.procedure    = procedure;
+	compiler.body_label   = jit_label(&compiler);
+	compiler.return_label = jit_label(&compiler);
+
+	// push rbp; mov rbp, rsp; push rbx, r12, r13, r14; sub rsp, temporaries
+	// @Note: r14 is unused, saving it keeps rsp 16 byte aligned for calls
+	jit_byte(&compiler, 0x50 + JIT_RBP);
+	jit_mov(&compiler, JIT_RBP, JIT_RSP);
+	jit_byte(&compiler, 0x50 + JIT_RBX);
+	jit_byte(&compiler, 0x41);
+	jit_byte(&compiler, 0x50 + (JIT_R12 & 7));
+	jit_byte(&compiler, 0x41);
+	jit_byte(&compiler, 0x50 + (JIT_R13 & 7));
+	jit_byte(&compiler, 0x41);
+	jit_byte(&compiler, 0x50 + (JIT_R14 & 7));
+	jit_alu_imm(&compiler, 5, JIT_RSP, 0);
+	auto temporaries = compiler.code.count - sizeof(uint32_t);
+
+	jit_mov(&compiler, JIT_RBX, JIT_RDI);
+	jit_mov(&compiler, JIT_R12, JIT_RSI);
+	jit_rm(&compiler, 0, 0x8B, true, JIT_R13, JIT_RDI, (int32_t)offsetof(Interpreter, global));
+
+	jit_bind(&compiler, compiler.body_label);
+
+	if (procedure)
+	{
+		jit_emit_block(&compiler, procedure);
+	}
+	else
+	{
+		switch (loop->kind)
+		{
+			case CODE_NODE_FOR: jit_emit_for(&compiler, (Code_Node_For *)loop, false); break;
+			case CODE_NODE_WHILE: jit_emit_while(&compiler, (Code_Node_While *)loop); break;
+			case CODE_NODE_DO: jit_emit_do(&compiler, (Code_Node_Do *)loop, true); break;
+			NoDefaultCase();
+		}
+	}
+
+	auto epilogue = jit_label(&compiler);
+	jit_mov_imm(&compiler, JIT_RAX, INTERP_COMPLETION_NORMAL);
+	jit_jump(&compiler, epilogue);
+
+	jit_bind(&compiler, compiler.return_label);
+	jit_mov_imm(&compiler, JIT_RAX, INTERP_COMPLETION_RETURN);
+
+	// lea rsp, [rbp - saved]; pop r14, r13, r12, rbx; pop rbp; ret
+	jit_bind(&compiler, epilogue);
+	jit_lea(&compiler, JIT_RSP, JIT_RBP, -JIT_SAVED_SIZE);
+	jit_byte(&compiler, 0x41);
+	jit_byte(&compiler, 0x58 + (JIT_R14 & 7));
+	jit_byte(&compiler, 0x41);
+	jit_byte(&compiler, 0x58 + (JIT_R13 & 7));
+	jit_byte(&compiler, 0x41);
+	jit_byte(&compiler, 0x58 + (JIT_R12 & 7));
+	jit_byte(&compiler, 0x58 + JIT_RBX);
+	jit_byte(&compiler, 0x58 + JIT_RBP);
+	jit_byte(&compiler, 0xC3);
+
+	if (compiler.failed)
+	{
+		jit->rejected += 1;
+		return nullptr;
+	}
+
+	uint32_t temporary_size = AlignPower2Up(compiler.temporary_size, 16);
+	memcpy(compiler.code.data + temporaries, &temporary_size, sizeof(temporary_size));
+
+	auto code = jit_finalize(jit, &compiler);
+
+	Free(&compiler.code);
+	Free(&compiler.labels);
+	Free(&compiler.fixups);
+	Free(&compiler.loops);
+
+	return code;
+}
+
+//
+//
+//
+
+Jit *jit_create(Interpreter *interp, uint32_t threshold)
+{
+#if JIT_NATIVE
+	auto jit       = new Jit;
+	jit->interp    = interp;
+	jit->threshold = threshold;
+	return jit;
+#else
+	return nullptr;
+#endif
+}
+
+void jit_destroy(Jit *jit)
+{
+#if JIT_NATIVE
+	for (auto &region : jit->regions)
+		munmap(region.memory, region.size);
+#endif
+	for (auto constant : jit->constants)
+		delete constant;
+	Free(&jit->regions);
+	Free(&jit->constants);
+	delete jit;
+}
+
+Code_Jit_Proc jit_compile_procedure(Jit *jit, Code_Node_Block *block)
+{
+	auto code = jit_compile(jit, block, nullptr);
+	if (code)
+		jit->procedures_compiled += 1;
+	block->jit.code   = code;
+	block->jit.failed = code == nullptr;
+	return code;
+}
+
+Code_Jit_Proc jit_compile_loop(Jit *jit, Code_Node *loop, Code_Jit_State *state)
+{
+	auto code = jit_compile(jit, nullptr, loop);
+	if (code)
+		jit->loops_compiled += 1;
+	state->code   = code;
+	state->failed = code == nullptr;
+	return code;
+}
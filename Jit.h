@@ -0,0 +1,61 @@
+#pragma once
+#include "CodeNode.h"
+#include "Interp.h"
+
+//
+// Tiers hot procedure bodies and loops of the tree walker up to x86-64 code. Native code uses
+// the same stack layout as the interpreter: locals stay at their Symbol_Address::STACK offsets
+// from the frame, callee frames and variadics are placed at the offsets computed by the resolver
+// and calls go through interp_call, so both tiers can call each other at any point.
+// A node that uses anything the JIT does not handle is marked failed and stays interpreted.
+//
+// Loops are entered at their condition, so the interpreter can switch to native code between
+// two iterations of a loop that is already running.
+//
+
+constexpr uint32_t JIT_DEFAULT_THRESHOLD = 1000;
+
+struct Jit
+{
+	Interpreter *interp    = nullptr;
+	uint32_t     threshold = JIT_DEFAULT_THRESHOLD; // Calls of a procedure or iterations of a loop
+
+	struct Region
+	{
+		void * memory;
+		size_t size;
+	};
+
+	Array<Region>                  regions;
+	Array<Code_Value_Procedure *>  constants;
+
+	int64_t procedures_compiled = 0;
+	int64_t loops_compiled      = 0;
+	int64_t rejected            = 0;
+};
+
+// Returns nullptr when native code can not be generated on this platform
+Jit *jit_create(Interpreter *interp, uint32_t threshold = JIT_DEFAULT_THRESHOLD);
+void jit_destroy(Jit *jit);
+
+Code_Jit_Proc jit_compile_procedure(Jit *jit, Code_Node_Block *block);
+Code_Jit_Proc jit_compile_loop(Jit *jit, Code_Node *loop, Code_Jit_State *state);
+
+inline Code_Jit_Proc jit_hot_procedure(Jit *jit, Code_Node_Block *block)
+{
+	auto state = &block->jit;
+	if (state->code || state->failed)
+		return state->code;
+	if (++state->hotness < jit->threshold)
+		return nullptr;
+	return jit_compile_procedure(jit, block);
+}
+
+inline Code_Jit_Proc jit_hot_loop(Jit *jit, Code_Node *loop, Code_Jit_State *state)
+{
+	if (state->code || state->failed)
+		return state->code;
+	if (++state->hotness < jit->threshold)
+		return nullptr;
+	return jit_compile_loop(jit, loop, state);
+}
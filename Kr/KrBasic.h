@@ -455,7 +455,7 @@ struct Table {
 		if (IndexTableRemove<K, V, Hash_Method>(&index, hash_method, key, storage)) {
 			storage.count -= 1;
 			if (index.used_count < index.used_count_shrink_threshold && index.slot_count_pow2 > TABLE_BUCKET_SIZE)
-				IndexTableAllocate(&index, index.slot_count_pow2 >> 2, storage.allocator);
+				IndexTableAllocate(&index, Maximum(index.slot_count_pow2 >> 2, TABLE_BUCKET_SIZE), storage.allocator);
 			else if (index.tombstone_count > index.tombstone_count_threshold)
 				IndexTableAllocate(&index, index.slot_count_pow2, storage.allocator);
 		}
@@ -538,7 +538,7 @@ struct STable {
 			storage.count -= 1;
 
 			if (index.used_count < index.used_count_shrink_threshold && index.slot_count_pow2 > TABLE_BUCKET_SIZE)
-				IndexTableAllocate(&index, index.slot_count_pow2 >> 2, storage.allocator);
+				IndexTableAllocate(&index, Maximum(index.slot_count_pow2 >> 2, TABLE_BUCKET_SIZE), storage.allocator);
 			else if (index.tombstone_count > index.tombstone_count_threshold)
 				IndexTableAllocate(&index, index.slot_count_pow2, storage.allocator);
 		}
@@ -422,6 +422,12 @@ bool VirtualMemoryFree(void *ptr, size_t size) {
 	return VirtualFree(ptr, 0, MEM_RELEASE);
 }
 
+bool VirtualMemoryZero(void *ptr, size_t size) {
+	if (!VirtualFree(ptr, size, MEM_DECOMMIT))
+		return false;
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
 #endif
 
 #if PLATFORM_LINUX == 1 || PLATFORM_MAC == 1
@@ -465,4 +471,14 @@ bool VirtualMemoryFree(void *ptr, size_t size) {
 	return munmap(ptr, size) == 0;
 }
 
+bool VirtualMemoryZero(void *ptr, size_t size) {
+#if PLATFORM_LINUX == 1
+	return madvise(ptr, size, MADV_DONTNEED) == 0;
+#else
+	// MADV_DONTNEED does not guarantee zero pages here, so the range is mapped over with fresh ones
+	void *result = mmap(ptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+	return result != MAP_FAILED;
+#endif
+}
+
 #endif
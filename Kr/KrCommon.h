@@ -460,3 +460,5 @@ void *VirtualMemoryAllocate(void *ptr, size_t size);
 bool VirtualMemoryCommit(void *ptr, size_t size);
 bool VirtualMemoryDecommit(void *ptr, size_t size);
 bool VirtualMemoryFree(void *ptr, size_t size);
+// Gives the committed pages back to the OS, they stay committed and read as zero when touched again
+bool VirtualMemoryZero(void *ptr, size_t size);
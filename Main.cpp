@@ -8,6 +8,9 @@
 
 #include "StringBuilder.h"
 #include "StdLib.h"
+#include "Bytecode.h"
+#include "Optimizer.h"
+#include "ProgramCache.h"
 
 //
 //
@@ -434,6 +437,22 @@ static void intercept(Interpreter *interp, Intercept_Kind intercept, Code_Node *
 
 		json->end_object();
 	}
+
+	// The snapshots of a long execution are sent as they are produced, instead of at the end
+	auto stream = context->stream;
+	if (stream && json->builder->written >= stream->threshold)
+	{
+		context->trace_written += json->builder->written;
+		stream->flush(stream, json->builder);
+	}
+
+	// The snapshot is written whole before the program is stopped, so the response stays valid
+	if (context->trace_limit && context->trace_written + json->builder->written > context->trace_limit)
+		interp_runtime_error(interp, "Trace output limit exceeded");
+
+	// Nothing reads the rest of the trace once the client has left
+	if (stream && stream->closed)
+		interp_runtime_error(interp, "Connection closed");
 }
 
 void json_write_syntax_node(Json_Writer *json, Syntax_Node *root)
@@ -873,10 +892,86 @@ static void json_write_symbol_table(Json_Writer *json, const Array_View<Key_Valu
 	json->end_array();
 }
 
-bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, String_Builder *builder)
+// @Note: The error handlers of the server jump out of the front end, so the arena of a failed compile
+// stays here and the next compile of the thread reuses it
+static thread_local Memory_Arena *CompileArena;
+
+// Returns null when the code has errors, they are written to (builder)
+static Compiled_Program *CompileProgram(String code, String_Builder *builder, bool optimize)
+{
+	if (!CompileArena)
+		CompileArena = MemoryArenaAllocate(MegaBytes(128));
+
+	auto arena = CompileArena;
+	MemoryArenaReset(arena);
+
+	auto prev_allocator = ThreadContext.allocator;
+	Defer{ ThreadContext.allocator = prev_allocator; };
+
+	ThreadContext.allocator = MemoryArenaAllocator(arena);
+
+	// The trees refer to the code, it must live as long as the program
+	code = StrDuplicateArena(code, arena);
+
+	Parser parser;
+	parser_init(&parser, code, builder);
+
+	auto node = parse_global_scope(&parser);
+
+	if (parser.error_count)
+		return nullptr;
+
+	auto resolver = code_type_resolver_create(builder);
+
+	include_basic(resolver);
+
+	auto exprs = code_type_resolve(resolver, node);
+
+	if (code_type_resolver_error_count(resolver))
+		return nullptr;
+
+	Code_Optimize_Stats optimize_stats;
+	if (optimize)
+		optimize_stats = code_optimize(resolver, exprs);
+
+	auto main_proc = interp_find_main(resolver);
+
+	if (!main_proc)
+		return nullptr;
+
+	auto program            = new Compiled_Program;
+	program->arena          = arena;
+	program->resolver       = resolver;
+	program->exprs          = exprs;
+	program->main_proc      = main_proc;
+	program->bss_size       = code_type_resolver_bss_allocated(resolver);
+	program->optimize_stats = optimize_stats;
+	program->code           = code;
+	program->optimized      = optimize;
+	program->size           = MemoryArenaUsedSize(arena);
+
+	CompileArena = nullptr;
+
+	return program;
+}
+
+static void ReleaseProgram(Program_Cache *cache, Compiled_Program *program, bool cached)
+{
+	if (cached) {
+		program_cache_release(cache, program);
+	} else if (!CompileArena) {
+		CompileArena = program->arena;
+	} else {
+		program_free(program);
+	}
+}
+
+bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, String_Builder *builder, String_Builder_Stream *stream, int64_t trace_limit, Program_Cache *cache, bool bytecode, bool optimize, bool heap_profile)
 {
 	Interp_User_Context context;
 	context.json.builder = builder;
+	context.stream = stream;
+	context.trace_limit = trace_limit;
 
 	context.console_in = input;
 
@@ -890,33 +985,33 @@ bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, Strin
 	auto temp = BeginTemporaryMemory(arena);
 	Defer{ EndTemporaryMemory(&temp); };
 
-	Parser parser;
-	parser_init(&parser, code, context.json.builder);
-
 	context.json.write_key("error");
 	context.json.begin_string_value();
 
-	auto node = parse_global_scope(&parser);
+	Compiled_Program *compiled = cache ? program_cache_acquire(cache, code, optimize) : nullptr;
+	bool              cached   = compiled != nullptr;
 
-	if (parser.error_count) {
-		context.json.end_string_value();
-		context.json.end_object();
-		return false;
-	}
+	if (!compiled) {
+		compiled = CompileProgram(code, context.json.builder, optimize);
 
-	auto resolver = code_type_resolver_create(context.json.builder);
+		if (!compiled) {
+			context.json.end_string_value();
+			context.json.end_object();
+			return false;
+		}
 
-	include_basic(resolver);
+		if (cache)
+			cached = program_cache_insert(cache, compiled);
+	}
 
-	auto exprs = code_type_resolve(resolver, node);
+	Defer{ ReleaseProgram(cache, compiled, cached); };
 
-	if (code_type_resolver_error_count(resolver)) {
-		context.json.end_string_value();
-		context.json.end_object();
-		return false;
-	}
+	auto resolver  = compiled->resolver;
+	auto exprs     = compiled->exprs;
+	auto main_proc = compiled->main_proc;
 
 	Heap_Allocator heap_allocator;
+	Heap_Profile   heap_profiler;
 
 	const uint32_t stack_size = 1024 * 1024 * 4;
 
@@ -925,15 +1020,15 @@ bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, Strin
 	interp.user_context = &context;
 	interp.global_symbol_table = code_type_resolver_global_symbol_table(resolver);
 	interp.heap = &heap_allocator;
-	interp_init(&interp, resolver, stack_size, code_type_resolver_bss_allocated(resolver));
-
-	interp_eval_globals(&interp, exprs);
-	auto main_proc = interp_find_main(&interp);
-
-	if (!main_proc) {
-		context.json.end_string_value();
-		context.json.end_object();
-		return false;
+	interp.heap_profile = heap_profile ? &heap_profiler : nullptr;
+	interp_init(&interp, resolver, stack_size, compiled->bss_size);
+
+	Bytecode_Program *program = nullptr;
+	if (bytecode) {
+		program = bytecode_compile(&interp, exprs, main_proc, INTERCEPT_POLICY_ALL);
+		bytecode_eval_globals(&interp, program);
+	} else {
+		interp_eval_globals<INTERCEPT_POLICY_ALL>(&interp, exprs);
 	}
 
 	context.json.end_string_value();
@@ -945,7 +1040,10 @@ bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, Strin
 	context.prev_count = count;
 	context.first_count = count;
 
-	interp_evaluate_procedure(&interp, main_proc);
+	if (program)
+		bytecode_evaluate_procedure(&interp, program);
+	else
+		interp_evaluate_procedure<INTERCEPT_POLICY_ALL>(&interp, main_proc);
 
 	count = clock();
 	float ms = ((count - context.first_count) * 1000.0f) / (float)CLOCKS_PER_SEC;
@@ -953,12 +1051,28 @@ bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, Strin
 	context.json.end_array();
 
 	context.json.write_key_value("exe_time", ms);
-	context.json.write_key_value("bss_size", code_type_resolver_bss_allocated(resolver));
+	context.json.write_key_value("bss_size", compiled->bss_size);
 	context.json.write_key_value("stack_size", stack_size);
 	context.json.write_key_value("heap_allocated", heap_allocator.total_allocated);
 	context.json.write_key_value("heap_freed", heap_allocator.total_freed);
 	context.json.write_key_value("heap_leaked", heap_allocator.total_allocated - heap_allocator.total_freed);
 
+	if (interp.heap_profile) {
+		context.json.write_key("heap_profile");
+		heap_profile_write_json(interp.heap_profile, &context.json);
+	} else {
+		context.json.write_key_null("heap_profile");
+	}
+
+	context.json.write_key_value("nodes_eliminated", code_optimize_eliminated(compiled->optimize_stats));
+	context.json.write_key_value("call_cache_hits", interp.call_cache_hits);
+	context.json.write_key_value("call_cache_misses", interp.call_cache_misses);
+
+	if (interp.runtime_error)
+		context.json.write_key_value_formatted("runtime_error", "%", interp.runtime_error);
+	else
+		context.json.write_key_null("runtime_error");
+
 	context.json.write_key("map");
 	json_write_symbol_table(&context.json, interp.global_symbol_table->map.storage);
 
@@ -967,5 +1081,9 @@ bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, Strin
 
 	context.json.end_object();
 
+	interp_free(&interp);
+	heap_release(&heap_allocator);
+	heap_profile_release(&heap_profiler);
+
 	return true;
 }
@@ -0,0 +1,483 @@
+#include "Optimizer.h"
+#include "Interp.h"
+
+struct Code_Optimizer
+{
+	// Keyed by the Symbol_Address of constants whose value is a literal
+	Table<uint64_t, Code_Node_Literal *> constants;
+	Table<uint64_t, bool>                visited;
+	Array<Code_Node_Block *>             pending;
+
+	Code_Optimize_Stats stats;
+};
+
+//
+//
+//
+
+static int64_t code_optimizer_count(Code_Node *root)
+{
+	if (!root)
+		return 0;
+
+	switch (root->kind)
+	{
+		case CODE_NODE_LITERAL:
+		case CODE_NODE_BREAK:
+		case CODE_NODE_CONTINUE:
+			return 1;
+
+		case CODE_NODE_ADDRESS: {
+			auto    node  = (Code_Node_Address *)root;
+			int64_t count = 1;
+			if (node->subscript)
+				count += 1 + code_optimizer_count(node->subscript->expression) + code_optimizer_count(node->subscript->subscript);
+			for (int64_t index = 0; index < node->index_count; ++index)
+				count += code_optimizer_count(node->indices[index].expression);
+			return count;
+		}
+
+		case CODE_NODE_TYPE_CAST: return 1 + code_optimizer_count(((Code_Node_Type_Cast *)root)->child);
+		case CODE_NODE_UNARY_OPERATOR: return 1 + code_optimizer_count(((Code_Node_Unary_Operator *)root)->child);
+		case CODE_NODE_EXPRESSION: return 1 + code_optimizer_count(((Code_Node_Expression *)root)->child);
+		case CODE_NODE_RETURN: return 1 + code_optimizer_count(((Code_Node_Return *)root)->expression);
+		case CODE_NODE_OFFSET: return 1 + code_optimizer_count(((Code_Node_Offset *)root)->expression);
+		case CODE_NODE_STATEMENT: return 1 + code_optimizer_count(((Code_Node_Statement *)root)->node);
+
+		case CODE_NODE_BINARY_OPERATOR: {
+			auto node = (Code_Node_Binary_Operator *)root;
+			return 1 + code_optimizer_count(node->left) + code_optimizer_count(node->right);
+		}
+
+		case CODE_NODE_ASSIGNMENT: {
+			auto node = (Code_Node_Assignment *)root;
+			return 1 + code_optimizer_count(node->destination) + code_optimizer_count(node->value);
+		}
+
+		case CODE_NODE_PROCEDURE_CALL: {
+			auto    node  = (Code_Node_Procedure_Call *)root;
+			int64_t count = 1 + code_optimizer_count(node->procedure);
+			for (int64_t index = 0; index < node->parameter_count; ++index)
+				count += code_optimizer_count(node->parameters[index]);
+			for (int64_t index = 0; index < node->variadic_count; ++index)
+				count += code_optimizer_count(node->variadics[index]);
+			return count;
+		}
+
+		case CODE_NODE_IF: {
+			auto node = (Code_Node_If *)root;
+			return 1 + code_optimizer_count(node->condition) + code_optimizer_count(node->true_statement) +
+				code_optimizer_count(node->false_statement);
+		}
+
+		case CODE_NODE_FOR: {
+			auto node = (Code_Node_For *)root;
+			return 1 + code_optimizer_count(node->initialization) + code_optimizer_count(node->condition) +
+				code_optimizer_count(node->increment) + code_optimizer_count(node->body);
+		}
+
+		case CODE_NODE_WHILE: {
+			auto node = (Code_Node_While *)root;
+			return 1 + code_optimizer_count(node->condition) + code_optimizer_count(node->body);
+		}
+
+		case CODE_NODE_DO: {
+			auto node = (Code_Node_Do *)root;
+			return 1 + code_optimizer_count(node->body) + code_optimizer_count(node->condition);
+		}
+
+		case CODE_NODE_BLOCK: {
+			int64_t count = 1;
+			for (auto statement = ((Code_Node_Block *)root)->statement_head; statement; statement = statement->next)
+				count += code_optimizer_count(statement);
+			return count;
+		}
+
+		NoDefaultCase();
+	}
+
+	return 0;
+}
+
+//
+//
+//
+
+static void code_optimizer_visit_procedure(Code_Optimizer *optimizer, Code_Node_Block *block)
+{
+	if (!block || optimizer->visited.Find((uint64_t)block))
+		return;
+	optimizer->visited.Put((uint64_t)block, true);
+	optimizer->pending.Add(block);
+}
+
+static inline bool code_optimizer_is_scalar(Code_Type *type)
+{
+	auto kind = type->kind;
+	return kind == CODE_TYPE_CHARACTER || kind == CODE_TYPE_INTEGER || kind == CODE_TYPE_REAL || kind == CODE_TYPE_BOOL;
+}
+
+static Code_Node_Literal *code_optimizer_literal(Code_Node *root)
+{
+	while (root->kind == CODE_NODE_EXPRESSION)
+		root = ((Code_Node_Expression *)root)->child;
+
+	if (root->kind == CODE_NODE_LITERAL && code_optimizer_is_scalar(root->type))
+		return (Code_Node_Literal *)root;
+	return nullptr;
+}
+
+static bool code_optimizer_truth(Code_Node_Literal *literal)
+{
+	switch (literal->type->kind)
+	{
+		case CODE_TYPE_CHARACTER: return (Kano_Char)literal->data.integer.value != 0;
+		case CODE_TYPE_INTEGER: return literal->data.integer.value != 0;
+		case CODE_TYPE_REAL: return literal->data.real.value != 0.0;
+		case CODE_TYPE_BOOL: return literal->data.boolean.value;
+		NoDefaultCase();
+	}
+	return false;
+}
+
+static Code_Node_Literal *code_optimizer_make_literal(Code_Type *type, Code_Value value)
+{
+	auto node   = new Code_Node_Literal;
+	node->type  = type;
+	node->flags = SYMBOL_BIT_CONST_EXPR;
+	node->data  = value;
+	return node;
+}
+
+static Code_Node *code_optimizer_fold(Code_Optimizer *optimizer, Code_Node *root)
+{
+	optimizer->stats.folded += 1;
+	return code_optimizer_make_literal(root->type, interp_evaluate_constant_value(root));
+}
+
+static Code_Node *code_optimize_expression(Code_Optimizer *optimizer, Code_Node *root);
+
+static Code_Node_Expression *code_optimize_root_expression(Code_Optimizer *optimizer, Code_Node_Expression *root)
+{
+	root->child = code_optimize_expression(optimizer, root->child);
+	return root;
+}
+
+static void code_optimize_subscript(Code_Optimizer *optimizer, Code_Node_Address *node)
+{
+	if (node->subscript)
+	{
+		code_optimize_root_expression(optimizer, node->subscript->expression);
+		code_optimize_root_expression(optimizer, node->subscript->subscript);
+	}
+
+	for (int64_t index = 0; index < node->index_count; ++index)
+		code_optimize_root_expression(optimizer, node->indices[index].expression);
+}
+
+static Code_Node *code_optimize_address(Code_Optimizer *optimizer, Code_Node_Address *node)
+{
+	if (node->subscript || node->index_count)
+	{
+		code_optimize_subscript(optimizer, node);
+		return node;
+	}
+
+	if (!node->address)
+		return node;
+
+	if (node->address->kind == Symbol_Address::CODE && node->type->kind == CODE_TYPE_PROCEDURE)
+	{
+		code_optimizer_visit_procedure(optimizer, node->address->code);
+		return node;
+	}
+
+	auto constant = optimizer->constants.Find((uint64_t)node->address);
+	if (constant && node->offset == 0)
+	{
+		optimizer->stats.folded += 1;
+		return code_optimizer_make_literal(node->type, (*constant)->data);
+	}
+
+	return node;
+}
+
+static Code_Node *code_optimize_type_cast(Code_Optimizer *optimizer, Code_Node_Type_Cast *node)
+{
+	code_optimize_root_expression(optimizer, node->child);
+
+	if (code_optimizer_is_scalar(node->type) && code_optimizer_literal(node->child))
+		return code_optimizer_fold(optimizer, node);
+
+	return node;
+}
+
+static Code_Node *code_optimize_unary_operator(Code_Optimizer *optimizer, Code_Node_Unary_Operator *node)
+{
+	node->child = code_optimize_expression(optimizer, node->child);
+
+	switch (node->op_kind)
+	{
+		case UNARY_OPERATOR_PLUS:
+		case UNARY_OPERATOR_MINUS:
+		case UNARY_OPERATOR_BITWISE_NOT:
+		case UNARY_OPERATOR_LOGICAL_NOT: {
+			if (code_optimizer_literal(node->child))
+				return code_optimizer_fold(optimizer, node);
+		}
+		break;
+	}
+
+	return node;
+}
+
+static Code_Node *code_optimize_binary_operator(Code_Optimizer *optimizer, Code_Node_Binary_Operator *node)
+{
+	node->left  = code_optimize_expression(optimizer, node->left);
+	node->right = code_optimize_expression(optimizer, node->right);
+
+	auto op_kind = node->op_kind;
+
+	if (op_kind >= BINARY_OPERATOR_COMPOUND_ADDITION && op_kind <= BINARY_OPERATOR_COMPOUND_BITWISE_OR)
+		return node;
+
+	auto left  = code_optimizer_literal(node->left);
+	auto right = code_optimizer_literal(node->right);
+
+	// The right operand of && and || is never evaluated once the left operand decides the result
+	if (left && (op_kind == BINARY_OPERATOR_LOGICAL_AND || op_kind == BINARY_OPERATOR_LOGICAL_OR))
+	{
+		bool value = code_optimizer_truth(left);
+		if (value == (op_kind == BINARY_OPERATOR_LOGICAL_OR))
+		{
+			Code_Value result;
+			result.boolean.value = value;
+			optimizer->stats.folded += 1;
+			return code_optimizer_make_literal(node->type, result);
+		}
+	}
+
+	if (!left || !right || !code_optimizer_is_scalar(node->type))
+		return node;
+
+	// Division by zero and the overflowing INT64_MIN / -1 trap, they are left for the runtime
+	switch (node->operation)
+	{
+		case BINARY_OPERATION_DIV_CHAR:
+		case BINARY_OPERATION_MOD_CHAR: {
+			if (!code_optimizer_truth(right))
+				return node;
+		}
+		break;
+
+		case BINARY_OPERATION_DIV_INT:
+		case BINARY_OPERATION_MOD_INT: {
+			if (!code_optimizer_truth(right))
+				return node;
+			if (right->data.integer.value == -1 && left->data.integer.value == INT64_MIN)
+				return node;
+		}
+		break;
+	}
+
+	return code_optimizer_fold(optimizer, node);
+}
+
+static Code_Node *code_optimize_procedure_call(Code_Optimizer *optimizer, Code_Node_Procedure_Call *node)
+{
+	code_optimize_root_expression(optimizer, node->procedure);
+	for (int64_t index = 0; index < node->parameter_count; ++index)
+		code_optimize_root_expression(optimizer, node->parameters[index]);
+	for (int64_t index = 0; index < node->variadic_count; ++index)
+		code_optimize_root_expression(optimizer, node->variadics[index]);
+	return node;
+}
+
+static Code_Node *code_optimize_assignment(Code_Optimizer *optimizer, Code_Node_Assignment *node)
+{
+	code_optimize_root_expression(optimizer, node->value);
+
+	// The destination itself must not be replaced by the value of the constant
+	auto destination = node->destination->child;
+	if (destination->kind == CODE_NODE_ADDRESS)
+		code_optimize_subscript(optimizer, (Code_Node_Address *)destination);
+	else
+		code_optimize_root_expression(optimizer, node->destination);
+
+	if (destination->kind == CODE_NODE_ADDRESS && (destination->flags & SYMBOL_BIT_CONSTANT))
+	{
+		auto address = (Code_Node_Address *)destination;
+		auto value   = code_optimizer_literal(node->value);
+
+		if (!address->subscript && !address->index_count && address->address && address->offset == 0 && value && value->type->kind == address->type->kind)
+			optimizer->constants.Put((uint64_t)address->address, value);
+	}
+
+	return node;
+}
+
+static Code_Node *code_optimize_expression(Code_Optimizer *optimizer, Code_Node *root)
+{
+	switch (root->kind)
+	{
+		case CODE_NODE_LITERAL: {
+			if (root->type->kind == CODE_TYPE_PROCEDURE)
+				code_optimizer_visit_procedure(optimizer, ((Code_Node_Literal *)root)->data.procedure.block);
+			return root;
+		}
+
+		case CODE_NODE_EXPRESSION: {
+			auto node   = (Code_Node_Expression *)root;
+			node->child = code_optimize_expression(optimizer, node->child);
+			// Nested expressions are only wrappers, a literal can take their place
+			if (code_optimizer_literal(node->child))
+				return node->child;
+			return node;
+		}
+
+		case CODE_NODE_ADDRESS: return code_optimize_address(optimizer, (Code_Node_Address *)root);
+		case CODE_NODE_TYPE_CAST: return code_optimize_type_cast(optimizer, (Code_Node_Type_Cast *)root);
+		case CODE_NODE_UNARY_OPERATOR: return code_optimize_unary_operator(optimizer, (Code_Node_Unary_Operator *)root);
+		case CODE_NODE_BINARY_OPERATOR: return code_optimize_binary_operator(optimizer, (Code_Node_Binary_Operator *)root);
+		case CODE_NODE_ASSIGNMENT: return code_optimize_assignment(optimizer, (Code_Node_Assignment *)root);
+		case CODE_NODE_PROCEDURE_CALL: return code_optimize_procedure_call(optimizer, (Code_Node_Procedure_Call *)root);
+
+		case CODE_NODE_OFFSET: {
+			code_optimize_root_expression(optimizer, ((Code_Node_Offset *)root)->expression);
+			return root;
+		}
+
+		case CODE_NODE_RETURN: {
+			auto node = (Code_Node_Return *)root;
+			if (node->expression)
+				node->expression = code_optimize_expression(optimizer, node->expression);
+			return root;
+		}
+
+		case CODE_NODE_BREAK:
+		case CODE_NODE_CONTINUE:
+			return root;
+
+		NoDefaultCase();
+	}
+
+	return root;
+}
+
+//
+//
+//
+
+static void code_optimize_statement(Code_Optimizer *optimizer, Code_Node_Statement *root);
+
+static void code_optimize_block(Code_Optimizer *optimizer, Code_Node_Block *root)
+{
+	for (auto statement = root->statement_head; statement; statement = statement->next)
+		code_optimize_statement(optimizer, statement);
+}
+
+static void code_optimize_if(Code_Optimizer *optimizer, Code_Node_Statement *statement, Code_Node_If *root)
+{
+	code_optimize_root_expression(optimizer, root->condition);
+	code_optimize_statement(optimizer, root->true_statement);
+	if (root->false_statement)
+		code_optimize_statement(optimizer, root->false_statement);
+
+	auto condition = code_optimizer_literal(root->condition);
+	if (!condition)
+		return;
+
+	// The if statement becomes a block with the taken branch, so that the branch keeps its own statement
+	auto taken  = code_optimizer_truth(condition) ? root->true_statement : root->false_statement;
+	auto block  = new Code_Node_Block;
+	block->type = root->type;
+
+	if (taken)
+	{
+		taken->next            = nullptr;
+		block->statement_head  = taken;
+		block->statement_count = 1;
+	}
+
+	block->symbols.parent = statement->symbol_table;
+
+	statement->node = block;
+	optimizer->stats.branches_removed += 1;
+}
+
+static void code_optimize_statement(Code_Optimizer *optimizer, Code_Node_Statement *root)
+{
+	switch (root->node->kind)
+	{
+		case CODE_NODE_EXPRESSION: code_optimize_root_expression(optimizer, (Code_Node_Expression *)root->node); break;
+		case CODE_NODE_ASSIGNMENT: code_optimize_assignment(optimizer, (Code_Node_Assignment *)root->node); break;
+		case CODE_NODE_BLOCK: code_optimize_block(optimizer, (Code_Node_Block *)root->node); break;
+		case CODE_NODE_IF: code_optimize_if(optimizer, root, (Code_Node_If *)root->node); break;
+
+		case CODE_NODE_FOR: {
+			auto node = (Code_Node_For *)root->node;
+			code_optimize_statement(optimizer, node->initialization);
+			code_optimize_statement(optimizer, node->condition);
+			code_optimize_statement(optimizer, node->increment);
+			code_optimize_statement(optimizer, node->body);
+		}
+		break;
+
+		case CODE_NODE_WHILE: {
+			auto node = (Code_Node_While *)root->node;
+			code_optimize_statement(optimizer, node->condition);
+			code_optimize_statement(optimizer, node->body);
+		}
+		break;
+
+		case CODE_NODE_DO: {
+			auto node = (Code_Node_Do *)root->node;
+			code_optimize_statement(optimizer, node->body);
+			code_optimize_statement(optimizer, node->condition);
+		}
+		break;
+
+		NoDefaultCase();
+	}
+}
+
+//
+//
+//
+
+Code_Optimize_Stats code_optimize(Code_Type_Resolver *resolver, Array_View<Code_Node_Assignment *> exprs)
+{
+	Code_Optimizer optimizer;
+
+	for (auto expr : exprs)
+	{
+		optimizer.stats.nodes_before += code_optimizer_count(expr);
+		code_optimize_assignment(&optimizer, expr);
+		optimizer.stats.nodes_after += code_optimizer_count(expr);
+	}
+
+	// Procedures declared as constants are not part of the global assignments
+	auto symbols = code_type_resolver_global_symbol_table(resolver);
+	for (auto &pair : symbols->map)
+	{
+		auto symbol = pair.value;
+		if (symbol->address.kind == Symbol_Address::CODE && symbol->type && symbol->type->kind == CODE_TYPE_PROCEDURE)
+			code_optimizer_visit_procedure(&optimizer, symbol->address.code);
+	}
+
+	while (optimizer.pending.count)
+	{
+		auto block = optimizer.pending.Last();
+		optimizer.pending.RemoveLast();
+
+		optimizer.stats.nodes_before += code_optimizer_count(block);
+		code_optimize_block(&optimizer, block);
+		optimizer.stats.nodes_after += code_optimizer_count(block);
+	}
+
+	Free(&optimizer.constants);
+	Free(&optimizer.visited);
+	Free(&optimizer.pending);
+
+	return optimizer.stats;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "CodeNode.h"
+#include "Resolver.h"
+
+struct Code_Optimize_Stats
+{
+	int64_t nodes_before     = 0;
+	int64_t nodes_after      = 0;
+	int64_t folded           = 0; // Constant subtrees replaced by a literal
+	int64_t branches_removed = 0; // If statements with a constant condition
+};
+
+inline int64_t code_optimize_eliminated(const Code_Optimize_Stats &stats)
+{
+	return stats.nodes_before - stats.nodes_after;
+}
+
+// Runs between code_type_resolve and execution. Folds constant subtrees into literals, replaces
+// constants that have a constant value with their value and removes the dead branch of if statements
+// whose condition is constant. The trees are rewritten in place.
+Code_Optimize_Stats code_optimize(Code_Type_Resolver *resolver, Array_View<Code_Node_Assignment *> exprs);
@@ -3,8 +3,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-static bool     ParseTableInitialize = false;
-
 static uint32_t UnaryOperatorPrecedence[_TOKEN_KIND_COUNT];
 static uint32_t BinaryOperatorPrecedence[_TOKEN_KIND_COUNT];
 
@@ -1153,11 +1151,9 @@ void parser_init(Parser *parser, String content, String_Builder *error)
 
 	parser->parsing             = true;
 
-	if (!ParseTableInitialize)
-	{
-		parser_init_precedence();
-		ParseTableInitialize = true;
-	}
+	// @Note: The server parses on several threads at once, the precedence tables are filled in only once
+	static bool initialized = (parser_init_precedence(), true);
+	(void)initialized;
 
 	lexer_next(&parser->lexer);
 }
@@ -486,6 +486,13 @@ void print_code(Code_Node *root, FILE *fp, int child_indent, const char *title)
 			fprintf(fp, "Address(stack:+0x%zx)", node->offset);
 			print_code_type(root, child_indent, fp);
 		}
+
+		for (int64_t index = 0; index < node->index_count; ++index)
+		{
+			char title[64];
+			snprintf(title, sizeof(title), "Index(*0x%zx)", (size_t)node->indices[index].stride);
+			print_code(node->indices[index].expression, fp, child_indent, title);
+		}
 	}
 	break;
 
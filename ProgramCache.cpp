@@ -0,0 +1,155 @@
+#include "ProgramCache.h"
+
+#if PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+struct Program_Cache
+{
+#if PLATFORM_WINDOWS
+	SRWLOCK lock = SRWLOCK_INIT;
+#else
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+	Table<String, Compiled_Program *> programs[2]; // By (optimized)
+	Compiled_Program *                first = nullptr;
+	Compiled_Program *                last  = nullptr;
+
+	uint64_t size  = 0;
+	uint64_t limit = 0;
+};
+
+static void program_cache_lock(Program_Cache *cache)
+{
+#if PLATFORM_WINDOWS
+	AcquireSRWLockExclusive(&cache->lock);
+#else
+	pthread_mutex_lock(&cache->lock);
+#endif
+}
+
+static void program_cache_unlock(Program_Cache *cache)
+{
+#if PLATFORM_WINDOWS
+	ReleaseSRWLockExclusive(&cache->lock);
+#else
+	pthread_mutex_unlock(&cache->lock);
+#endif
+}
+
+static void program_cache_unlink(Program_Cache *cache, Compiled_Program *program)
+{
+	if (program->prev)
+		program->prev->next = program->next;
+	else
+		cache->first = program->next;
+	if (program->next)
+		program->next->prev = program->prev;
+	else
+		cache->last = program->prev;
+	program->prev = program->next = nullptr;
+}
+
+static void program_cache_push_front(Program_Cache *cache, Compiled_Program *program)
+{
+	program->prev = nullptr;
+	program->next = cache->first;
+	if (cache->first)
+		cache->first->prev = program;
+	else
+		cache->last = program;
+	cache->first = program;
+}
+
+Program_Cache *program_cache_create(uint64_t limit)
+{
+	auto cache   = new Program_Cache;
+	cache->limit = limit;
+	return cache;
+}
+
+Compiled_Program *program_cache_acquire(Program_Cache *cache, String code, bool optimized)
+{
+	program_cache_lock(cache);
+
+	Compiled_Program *program = nullptr;
+	if (auto found = cache->programs[optimized].Find(code))
+	{
+		program = *found;
+		program->references += 1;
+		program_cache_unlink(cache, program);
+		program_cache_push_front(cache, program);
+	}
+
+	program_cache_unlock(cache);
+	return program;
+}
+
+bool program_cache_insert(Program_Cache *cache, Compiled_Program *program)
+{
+	program->references = 1;
+	program->cached     = false;
+
+	if (program->size > cache->limit)
+		return false;
+
+	Array<Compiled_Program *> evicted;
+
+	program_cache_lock(cache);
+
+	// Another execution compiled the same code in the meantime
+	auto programs = &cache->programs[program->optimized];
+	if (programs->Find(program->code))
+	{
+		program_cache_unlock(cache);
+		return false;
+	}
+
+	program->cached = true;
+	programs->Put(program->code, program);
+	program_cache_push_front(cache, program);
+	cache->size += program->size;
+
+	while (cache->size > cache->limit)
+	{
+		auto victim = cache->last;
+		program_cache_unlink(cache, victim);
+		cache->programs[victim->optimized].Remove(victim->code);
+		cache->size -= victim->size;
+		victim->cached = false;
+		if (!victim->references)
+			evicted.Add(victim);
+	}
+
+	program_cache_unlock(cache);
+
+	for (auto victim : evicted)
+		program_free(victim);
+	Free(&evicted);
+
+	return true;
+}
+
+void program_cache_release(Program_Cache *cache, Compiled_Program *program)
+{
+	program_cache_lock(cache);
+	Assert(program->references);
+	program->references -= 1;
+	bool unused = !program->references && !program->cached;
+	program_cache_unlock(cache);
+
+	if (unused)
+		program_free(program);
+}
+
+void program_free(Compiled_Program *program)
+{
+	// The program lives in its own arena
+	MemoryArenaFree(program->arena);
+}
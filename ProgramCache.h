@@ -0,0 +1,49 @@
+#pragma once
+#include "Kr/KrBasic.h"
+#include "CodeNode.h"
+#include "Optimizer.h"
+
+//
+// Keeps the programs that went through the front end, so that requests resubmitting the same code with
+// another input skip the parser and the resolver. A compiled program is only read after it is built:
+// every execution runs its own Interpreter over it, which also holds the inline caches of the call
+// sites, so one program serves any number of executions at the same time. The server never runs the
+// JIT, the only thing that still writes to the trees.
+//
+// Programs are looked up by their code and evicted in least recently used order once their total size
+// is above the limit of the cache. An evicted program is freed when its last execution releases it.
+//
+
+struct Compiled_Program
+{
+	Memory_Arena *                     arena     = nullptr; // Everything the front end allocated, the program included
+	struct Code_Type_Resolver *        resolver  = nullptr;
+	Array_View<Code_Node_Assignment *> exprs;               // Initializers of the globals
+	Code_Node_Procedure_Call *         main_proc = nullptr;
+	uint64_t                           bss_size  = 0;
+	Code_Optimize_Stats                optimize_stats;
+
+	String code;              // Copied into the arena, the trees refer to it
+	bool   optimized = false; // The optimizer rewrites the trees, so both variants of a code are cached apart
+
+	uint64_t          size       = 0; // Bytes counted against the limit of the cache
+	uint32_t          references = 0;
+	bool              cached     = false;
+	Compiled_Program *prev       = nullptr; // Most recently used first
+	Compiled_Program *next       = nullptr;
+};
+
+struct Program_Cache;
+
+Program_Cache *program_cache_create(uint64_t limit);
+
+// Returns the program compiled from (code) with a reference taken, or null when it is not cached
+Compiled_Program *program_cache_acquire(Program_Cache *cache, String code, bool optimized);
+
+// Takes over the program with a reference for the caller. Returns false when the cache keeps another
+// program for the same code or the program alone is above the limit, the caller still owns it then.
+bool program_cache_insert(Program_Cache *cache, Compiled_Program *program);
+
+void program_cache_release(Program_Cache *cache, Compiled_Program *program);
+
+void program_free(Compiled_Program *program);
@@ -156,6 +156,79 @@ static Binary_Operator_Kind token_to_binary_operator(Token_Kind kind)
 	return _BINARY_OPERATOR_COUNT;
 }
 
+static Unary_Operation code_unary_operation(Unary_Operator_Kind kind, Code_Type_Kind operand)
+{
+	switch (kind)
+	{
+		case UNARY_OPERATOR_PLUS:
+			return UNARY_OPERATION_PLUS;
+		case UNARY_OPERATOR_MINUS:
+			if (operand == CODE_TYPE_CHARACTER) return UNARY_OPERATION_MINUS_CHAR;
+			if (operand == CODE_TYPE_INTEGER) return UNARY_OPERATION_MINUS_INT;
+			if (operand == CODE_TYPE_REAL) return UNARY_OPERATION_MINUS_REAL;
+			break;
+		case UNARY_OPERATOR_BITWISE_NOT:
+			if (operand == CODE_TYPE_CHARACTER) return UNARY_OPERATION_BITWISE_NOT_CHAR;
+			if (operand == CODE_TYPE_INTEGER) return UNARY_OPERATION_BITWISE_NOT_INT;
+			break;
+		case UNARY_OPERATOR_LOGICAL_NOT:
+			if (operand == CODE_TYPE_BOOL) return UNARY_OPERATION_LOGICAL_NOT_BOOL;
+			break;
+		case UNARY_OPERATOR_POINTER_TO:
+			return UNARY_OPERATION_POINTER_TO;
+		case UNARY_OPERATOR_DEREFERENCE:
+			return UNARY_OPERATION_DEREFERENCE;
+			NoDefaultCase();
+	}
+
+	Unreachable();
+	return _UNARY_OPERATION_COUNT;
+}
+
+#define BINARY_OPERATION_NONE _BINARY_OPERATION_COUNT
+
+// Columns are the operand types: character, integer, real, bool and pointer
+static const Binary_Operation BinaryOperations[_BINARY_OPERATOR_COUNT][5] = {
+	{ BINARY_OPERATION_ADD_CHAR, BINARY_OPERATION_ADD_INT, BINARY_OPERATION_ADD_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_ADD_POINTER },
+	{ BINARY_OPERATION_SUB_CHAR, BINARY_OPERATION_SUB_INT, BINARY_OPERATION_SUB_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_SUB_POINTER },
+	{ BINARY_OPERATION_MUL_CHAR, BINARY_OPERATION_MUL_INT, BINARY_OPERATION_MUL_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_DIV_CHAR, BINARY_OPERATION_DIV_INT, BINARY_OPERATION_DIV_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_MOD_CHAR, BINARY_OPERATION_MOD_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_SHR_CHAR, BINARY_OPERATION_SHR_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_SHL_CHAR, BINARY_OPERATION_SHL_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_AND_CHAR, BINARY_OPERATION_AND_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_XOR_CHAR, BINARY_OPERATION_XOR_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_OR_CHAR, BINARY_OPERATION_OR_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_GT_CHAR, BINARY_OPERATION_GT_INT, BINARY_OPERATION_GT_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_GT_POINTER },
+	{ BINARY_OPERATION_LT_CHAR, BINARY_OPERATION_LT_INT, BINARY_OPERATION_LT_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_LT_POINTER },
+	{ BINARY_OPERATION_GE_CHAR, BINARY_OPERATION_GE_INT, BINARY_OPERATION_GE_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_GE_POINTER },
+	{ BINARY_OPERATION_LE_CHAR, BINARY_OPERATION_LE_INT, BINARY_OPERATION_LE_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_LE_POINTER },
+	{ BINARY_OPERATION_EQ_CHAR, BINARY_OPERATION_EQ_INT, BINARY_OPERATION_EQ_REAL, BINARY_OPERATION_EQ_BOOL, BINARY_OPERATION_EQ_POINTER },
+	{ BINARY_OPERATION_NE_CHAR, BINARY_OPERATION_NE_INT, BINARY_OPERATION_NE_REAL, BINARY_OPERATION_NE_BOOL, BINARY_OPERATION_NE_POINTER },
+	{ BINARY_OPERATION_COMPOUND_ADD_CHAR, BINARY_OPERATION_COMPOUND_ADD_INT, BINARY_OPERATION_COMPOUND_ADD_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_COMPOUND_ADD_POINTER },
+	{ BINARY_OPERATION_COMPOUND_SUB_CHAR, BINARY_OPERATION_COMPOUND_SUB_INT, BINARY_OPERATION_COMPOUND_SUB_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_COMPOUND_SUB_POINTER },
+	{ BINARY_OPERATION_COMPOUND_MUL_CHAR, BINARY_OPERATION_COMPOUND_MUL_INT, BINARY_OPERATION_COMPOUND_MUL_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_DIV_CHAR, BINARY_OPERATION_COMPOUND_DIV_INT, BINARY_OPERATION_COMPOUND_DIV_REAL, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_MOD_CHAR, BINARY_OPERATION_COMPOUND_MOD_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_SHR_CHAR, BINARY_OPERATION_COMPOUND_SHR_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_SHL_CHAR, BINARY_OPERATION_COMPOUND_SHL_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_AND_CHAR, BINARY_OPERATION_COMPOUND_AND_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_XOR_CHAR, BINARY_OPERATION_COMPOUND_XOR_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_COMPOUND_OR_CHAR, BINARY_OPERATION_COMPOUND_OR_INT, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE, BINARY_OPERATION_NONE },
+	{ BINARY_OPERATION_LOGICAL_AND_CHAR, BINARY_OPERATION_LOGICAL_AND_INT, BINARY_OPERATION_LOGICAL_AND_REAL, BINARY_OPERATION_LOGICAL_AND_BOOL, BINARY_OPERATION_LOGICAL_AND_POINTER },
+	{ BINARY_OPERATION_LOGICAL_OR_CHAR, BINARY_OPERATION_LOGICAL_OR_INT, BINARY_OPERATION_LOGICAL_OR_REAL, BINARY_OPERATION_LOGICAL_OR_BOOL, BINARY_OPERATION_LOGICAL_OR_POINTER },
+};
+
+#undef BINARY_OPERATION_NONE
+
+static Binary_Operation code_binary_operation(Binary_Operator_Kind kind, Code_Type_Kind operand)
+{
+	Assert(operand >= CODE_TYPE_CHARACTER && operand <= CODE_TYPE_POINTER);
+	auto operation = BinaryOperations[kind][operand - CODE_TYPE_CHARACTER];
+	Assert(operation != _BINARY_OPERATION_COUNT);
+	return operation;
+}
+
 static inline uint32_t next_power2(uint32_t n)
 {
 	n--;
@@ -235,6 +308,14 @@ struct Code_Type_Resolver
 	uint32_t                         virtual_address[2] = {0, 0};
 	Symbol_Address::Kind             address_kind       = Symbol_Address::CODE;
 
+	// Highest stack address used by the procedure being resolved, becomes the frame size of its block
+	uint32_t                         stack_peak         = 0;
+
+	// Set once the procedure being resolved hands out an address into its frame, which rules out
+	// its returns reusing that frame for the callee
+	bool                             frame_escapes      = false;
+	Array<Code_Node_Return *>        tail_calls;
+
 	int error_count = 0;
 	String_Builder *error = nullptr;
 	
@@ -377,6 +458,24 @@ static Code_Node_Type_Cast *code_type_cast(Code_Node *node, Code_Type *to_type,
 	return nullptr;
 }
 
+static bool code_type_holds_static_array(Code_Type *type)
+{
+	if (type->kind == CODE_TYPE_STATIC_ARRAY)
+		return true;
+
+	if (type->kind == CODE_TYPE_STRUCT)
+	{
+		auto strt = (Code_Type_Struct *)type;
+		for (int64_t index = 0; index < strt->member_count; ++index)
+		{
+			if (code_type_holds_static_array(strt->members[index].type))
+				return true;
+		}
+	}
+
+	return false;
+}
+
 static bool code_type_are_same(Code_Type *a, Code_Type *b, bool recurse_pointer_type)
 {
 	Assert(a && b);
@@ -618,10 +717,65 @@ static Code_Node_Return *code_resolve_return(Code_Type_Resolver *resolver, Symbo
 	{
 		Unreachable();
 	}
+
+	// The result of a call returned as is, is already in the return slot if the callee takes over the frame
+	if (node->expression && node->expression->kind == CODE_NODE_PROCEDURE_CALL)
+	{
+		auto call = (Code_Node_Procedure_Call *)node->expression;
+		if (call->callee && call->callee->kind == Symbol_Address::CODE && !call->procedure_type->is_variadic)
+		{
+			node->tail_call = call;
+			resolver->tail_calls.Add(node);
+		}
+	}
 	
 	return node;
 }
 
+// Drops the tail calls of the procedure just resolved if its frame escapes, arguments may point into it
+static void code_resolve_tail_calls(Code_Type_Resolver *resolver, int64_t first_tail_call)
+{
+	if (resolver->frame_escapes)
+	{
+		for (int64_t index = first_tail_call; index < resolver->tail_calls.count; ++index)
+			resolver->tail_calls[index]->tail_call = nullptr;
+	}
+	resolver->tail_calls.count = first_tail_call;
+}
+
+static const Symbol_Address *code_resolve_callee(Code_Node_Expression *procedure)
+{
+	if (procedure->child->kind != CODE_NODE_ADDRESS)
+		return nullptr;
+
+	auto address = (Code_Node_Address *)procedure->child;
+	if (address->subscript || address->index_count || !address->address)
+		return nullptr;
+
+	if (address->address->kind == Symbol_Address::CODE || address->address->kind == Symbol_Address::CCALL)
+		return address->address;
+
+	return nullptr;
+}
+
+// Moves the stack top of the procedure being resolved, keeping track of the space its frame needs
+static void code_resolve_stack_top(Code_Type_Resolver *resolver, uint64_t top)
+{
+	resolver->virtual_address[Symbol_Address::STACK] = (uint32_t)top;
+	resolver->stack_peak = Maximum(resolver->stack_peak, (uint32_t)top);
+}
+
+// Places the parameter in the next slot of the callee frame. Calls made while evaluating the parameter
+// get their frames after the slots that are already written, so arguments go straight into their slots
+static uint64_t code_resolve_parameter_slot(Code_Type_Resolver *resolver, Code_Node_Procedure_Call *node, int64_t index,
+	Code_Type *type, uint64_t offset)
+{
+	offset = AlignPower2Up(offset, (uint64_t)type->alignment);
+	node->parameter_offsets[index] = offset;
+	code_resolve_stack_top(resolver, node->frame_offset + offset);
+	return offset + type->runtime_size;
+}
+
 static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver *resolver, Symbol_Table *symbols,
 	Syntax_Node_Procedure_Call *root)
 {
@@ -636,6 +790,7 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 			auto node             = new Code_Node_Procedure_Call;
 			node->procedure_type  = proc;
 			node->procedure       = procedure;
+			node->callee          = code_resolve_callee(procedure);
 			node->type            = proc->return_type;
 			
 			node->parameter_count = root->parameter_count;
@@ -644,14 +799,16 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 			auto stack_top        = resolver->virtual_address[Symbol_Address::STACK];
 			node->stack_top       = stack_top;
 
-			if (proc->return_type)
-			{
-				resolver->virtual_address[Symbol_Address::STACK] += proc->return_type->runtime_size;
-			}
+			node->frame_offset      = AlignPower2Up(stack_top, CODE_FRAME_ALIGNMENT);
+			node->parameter_offsets = new uint64_t[node->parameter_count];
+
+			uint64_t offset = proc->return_type ? proc->return_type->runtime_size : 0;
 			
 			uint32_t param_index  = 0;
 			for (auto param = root->parameters; param; param = param->next, ++param_index)
 			{
+				offset = code_resolve_parameter_slot(resolver, node, param_index, proc->arguments[param_index], offset);
+
 				auto code_param = code_resolve_root_expression(resolver, symbols, param->expression);
 
 				if (!code_param->type)
@@ -675,8 +832,6 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 							proc->name, proc->arguments[param_index], code_param->type, param_index + 1);
 					}
 				}
-
-				resolver->virtual_address[Symbol_Address::STACK] += proc->arguments[param_index]->runtime_size;
 				
 				node->parameters[param_index] = code_param;
 			}
@@ -690,6 +845,7 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 			auto node             = new Code_Node_Procedure_Call;
 			node->procedure_type  = proc;
 			node->procedure       = procedure;
+			node->callee          = code_resolve_callee(procedure);
 			node->type            = proc->return_type;
 			
 			node->parameter_count = proc->argument_count;
@@ -698,57 +854,21 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 			auto stack_top = resolver->virtual_address[Symbol_Address::STACK];
 			node->stack_top = stack_top;
 
-			if (proc->return_type)
-			{
-				resolver->virtual_address[Symbol_Address::STACK] += proc->return_type->runtime_size;
-			}
-			
-			uint32_t param_index  = 0;
-			auto     param        = root->parameters;
-			for (; param_index < proc->argument_count - 1; param = param->next, ++param_index)
-			{
-				auto code_param = code_resolve_root_expression(resolver, symbols, param->expression);
-
-				if (!code_param->type)
-				{
-					report_error(resolver, param,
-						"Type mismatch, expected argument of type % but got void", proc->arguments[param_index]);
-				}
-				
-				if (!code_type_are_same(proc->arguments[param_index], code_param->type))
-				{
-					auto cast = code_type_cast(code_param->child, proc->arguments[param_index]);
-					
-					if (cast)
-					{
-						code_param->child = cast;
-						code_param->type = cast->type;
-					}
-					else
-					{
-						report_error(resolver, param, 
-							"Type mismatch, expected argument of type % but got %",
-							proc->arguments[param_index], code_param->type);
-					}
-				}
-
-				resolver->virtual_address[Symbol_Address::STACK] += proc->arguments[param_index]->runtime_size;
-				
-				node->parameters[param_index] = code_param;
-			}
+			auto param = root->parameters;
+			for (uint32_t param_index = 0; param_index < proc->argument_count - 1; ++param_index)
+				param = param->next;
 
-			resolver->virtual_address[Symbol_Address::STACK] = stack_top;
-			if (proc->return_type)
-			{
-				resolver->virtual_address[Symbol_Address::STACK] += proc->return_type->runtime_size;
-			}
+			auto void_ptr_type = symbol_table_find(&resolver->symbols, "*void")->type;
 			
 			Code_Node *child = nullptr;
 			
+			// @Note: Variadics are resolved first, because their size decides where the callee frame starts.
+			// They are packed unaligned as [Code_Type *][value] pairs, and calls made while evaluating one
+			// of them get their frames at its pair
 			if (root->parameter_count >= proc->argument_count)
 			{
 				auto address         = new Code_Node_Address;
-				address->type        = symbol_table_find(&resolver->symbols, "*void")->type;
+				address->type        = void_ptr_type;
 				address->subscript   = nullptr;
 				address->offset      = stack_top;
 				
@@ -756,6 +876,7 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 				pointer_to->type     = address->type;
 				pointer_to->child    = address;
 				pointer_to->op_kind  = UNARY_OPERATOR_POINTER_TO;
+				pointer_to->operation = UNARY_OPERATION_POINTER_TO;
 				child                = pointer_to;
 				
 				auto va_arg_count    = root->parameter_count - proc->argument_count + 1;
@@ -767,12 +888,15 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 				for (; param; param = param->next, ++index)
 				{
 					Assert(index < va_arg_count);
+
+					code_resolve_stack_top(resolver, stack_top + node->variadics_size);
+
 					auto code_param        = code_resolve_root_expression(resolver, symbols, param->expression);
 
 					if (!code_param->type)
 					{
 						report_error(resolver, param,
-							"Type mismatch, expected argument of type % but got void", proc->arguments[param_index]);
+							"Type mismatch, expected argument of type % but got void", proc->arguments[proc->argument_count - 1]);
 					}
 
 					if (code_param->child->type->kind == CODE_TYPE_CHARACTER)
@@ -783,7 +907,8 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 						code_param->type  = int_type;
 					}
 
-					resolver->virtual_address[Symbol_Address::STACK] += code_param->type->runtime_size;
+					node->variadics_size += sizeof(Code_Type *);
+					node->variadics_size += code_param->type->runtime_size;
 
 					node->variadics[index] = code_param;
 				}
@@ -791,11 +916,52 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 			else
 			{
 				auto null_ptr                = new Code_Node_Literal;
-				null_ptr->type               = symbol_table_find(&resolver->symbols, "*void")->type;
+				null_ptr->type               = void_ptr_type;
 				null_ptr->data.pointer.value = 0;
 				child                        = null_ptr;
 			}
 
+			node->frame_offset      = AlignPower2Up(stack_top + node->variadics_size, CODE_FRAME_ALIGNMENT);
+			node->parameter_offsets = new uint64_t[node->parameter_count];
+			code_resolve_stack_top(resolver, node->frame_offset);
+
+			uint64_t offset = proc->return_type ? proc->return_type->runtime_size : 0;
+			
+			param = root->parameters;
+			for (uint32_t param_index = 0; param_index < proc->argument_count - 1; param = param->next, ++param_index)
+			{
+				offset = code_resolve_parameter_slot(resolver, node, param_index, proc->arguments[param_index], offset);
+
+				auto code_param = code_resolve_root_expression(resolver, symbols, param->expression);
+
+				if (!code_param->type)
+				{
+					report_error(resolver, param,
+						"Type mismatch, expected argument of type % but got void", proc->arguments[param_index]);
+				}
+				
+				if (!code_type_are_same(proc->arguments[param_index], code_param->type))
+				{
+					auto cast = code_type_cast(code_param->child, proc->arguments[param_index]);
+					
+					if (cast)
+					{
+						code_param->child = cast;
+						code_param->type = cast->type;
+					}
+					else
+					{
+						report_error(resolver, param, 
+							"Type mismatch, expected argument of type % but got %",
+							proc->arguments[param_index], code_param->type);
+					}
+				}
+				
+				node->parameters[param_index] = code_param;
+			}
+
+			code_resolve_parameter_slot(resolver, node, node->parameter_count - 1, void_ptr_type, offset);
+
 			resolver->virtual_address[Symbol_Address::STACK] = stack_top;
 			
 			auto va_arg                                = new Code_Node_Expression;
@@ -818,6 +984,23 @@ static Code_Node_Procedure_Call *code_resolve_procedure_call(Code_Type_Resolver
 	return nullptr;
 }
 
+// Returns the address node that the expression reduces to, if further member offsets and static array
+// subscripts can be collapsed into it instead of nesting new nodes over it
+static Code_Node_Address *code_resolve_strided_address(Code_Node *root)
+{
+	while (root->kind == CODE_NODE_EXPRESSION)
+		root = ((Code_Node_Expression *)root)->child;
+
+	if (root->kind != CODE_NODE_ADDRESS)
+		return nullptr;
+
+	auto node = (Code_Node_Address *)root;
+	if (node->address && node->address->kind != Symbol_Address::STACK && node->address->kind != Symbol_Address::GLOBAL)
+		return nullptr;
+
+	return node;
+}
+
 static Code_Node_Address *code_resolve_subscript(Code_Type_Resolver *resolver, Symbol_Table *symbols,
 	Syntax_Node_Subscript *root)
 {
@@ -859,6 +1042,27 @@ static Code_Node_Address *code_resolve_subscript(Code_Type_Resolver *resolver, S
 				Assert(expr_type_is_string);
 				node->type = symbol_table_find(&resolver->symbols, "byte", false)->type;
 			}
+
+			if (expression->type->kind == CODE_TYPE_STATIC_ARRAY)
+			{
+				auto base = code_resolve_strided_address(expression);
+				if (base)
+				{
+					auto indices = new Code_Address_Index[base->index_count + 1];
+					for (int64_t index = 0; index < base->index_count; ++index)
+						indices[index] = base->indices[index];
+
+					indices[base->index_count].expression = subscript;
+					indices[base->index_count].stride     = node->type->runtime_size;
+
+					base->indices     = indices;
+					base->index_count += 1;
+					base->type        = node->type;
+					base->flags       = node->flags;
+
+					return base;
+				}
+			}
 			
 			auto address   = new Code_Node_Address;
 			address->type  = node->type;
@@ -925,12 +1129,14 @@ static Code_Node_Block *code_resolve_procedure(Code_Type_Resolver *resolver, Syn
 	proc_symbols->parent = &resolver->symbols;
 
 	auto stack_top = resolver->virtual_address[Symbol_Address::STACK];
+	auto stack_peak = resolver->stack_peak;
 	auto address_kind = resolver->address_kind;
 
+	resolver->stack_peak = 0;
 	if (proc_type->return_type)
-		resolver->virtual_address[Symbol_Address::STACK] = proc_type->return_type->runtime_size;
+		code_resolve_stack_top(resolver, proc_type->return_type->runtime_size);
 	else
-		resolver->virtual_address[Symbol_Address::STACK] = 0;
+		code_resolve_stack_top(resolver, 0);
 
 	resolver->address_kind = Symbol_Address::STACK;
 
@@ -954,11 +1160,21 @@ static Code_Node_Block *code_resolve_procedure(Code_Type_Resolver *resolver, Syn
 		}
 	}
 
+	auto frame_escapes      = resolver->frame_escapes;
+	auto first_tail_call    = resolver->tail_calls.count;
+	resolver->frame_escapes = false;
+
 	resolver->return_stack.Add(proc_type->return_type);
 	auto procedure_body = code_resolve_block(resolver, proc_symbols, (int64_t)proc->location.start_row, proc->body);
 	resolver->return_stack.count -= 1;
 
+	code_resolve_tail_calls(resolver, first_tail_call);
+	resolver->frame_escapes = frame_escapes;
+
+	procedure_body->frame_size = resolver->stack_peak;
+
 	resolver->virtual_address[Symbol_Address::STACK] = stack_top;
+	resolver->stack_peak = stack_peak;
 	resolver->address_kind = address_kind;
 
 	*type = proc_type;
@@ -1063,6 +1279,7 @@ static Code_Node_Unary_Operator *code_resolve_unary_operator(Code_Type_Resolver
 				node->type    = op.output;
 				node->child   = child;
 				node->op_kind = op_kind;
+				node->operation = code_unary_operation(op_kind, child->type->kind);
 				
 				if (child->flags & SYMBOL_BIT_CONST_EXPR)
 					node->flags |= SYMBOL_BIT_CONST_EXPR;
@@ -1082,10 +1299,15 @@ static Code_Node_Unary_Operator *code_resolve_unary_operator(Code_Type_Resolver
 		node->type      = type;
 		node->child     = child;
 		node->op_kind   = op_kind;
+		node->operation = UNARY_OPERATION_POINTER_TO;
 		
 		if (child->flags & SYMBOL_BIT_CONST_EXPR)
 			node->flags |= SYMBOL_BIT_CONST_EXPR;
 		
+		auto address = code_resolve_strided_address(child);
+		if (!address || !address->address || address->address->kind != Symbol_Address::GLOBAL)
+			resolver->frame_escapes = true;
+		
 		return node;
 	}
 	
@@ -1102,6 +1324,7 @@ static Code_Node_Unary_Operator *code_resolve_unary_operator(Code_Type_Resolver
 				node->type = type;
 				node->child = child;
 				node->op_kind = op_kind;
+				node->operation = UNARY_OPERATION_DEREFERENCE;
 
 				if (child->flags & SYMBOL_BIT_CONST_EXPR)
 					node->flags |= SYMBOL_BIT_CONST_EXPR;
@@ -1144,6 +1367,7 @@ static Code_Node *code_resolve_binary_operator(Code_Type_Resolver *resolver, Sym
 			node->type    = ptr_type->base_type;
 			node->child   = left;
 			node->op_kind = UNARY_OPERATOR_DEREFERENCE;
+			node->operation = UNARY_OPERATION_DEREFERENCE;
 			node->flags   = left->flags;
 
 			left = node;
@@ -1225,6 +1449,14 @@ static Code_Node *code_resolve_binary_operator(Code_Type_Resolver *resolver, Sym
 
 		Assert(offset_type);
 
+		auto base = code_resolve_strided_address(left);
+		if (base)
+		{
+			base->offset += offset_value;
+			base->type    = offset_type;
+			return base;
+		}
+
 		Code_Node_Expression *expression = new Code_Node_Expression;
 		expression->child = left;
 		expression->flags = left->flags;
@@ -1247,58 +1479,45 @@ static Code_Node *code_resolve_binary_operator(Code_Type_Resolver *resolver, Sym
 		
 		auto &operators = resolver->binary_operators[op_kind];
 		
-		for (auto bucket = &operators.first; bucket; bucket = bucket->next)
+		// @Note: The first pass only accepts operators whose parameters match the operands exactly, so that
+		// operands are not implicitly casted to an operator registered earlier (bool && bool used to become char && char)
+		for (int pass = 0; pass < 2; ++pass)
 		{
-			uint32_t count = ((bucket == operators.last) ? operators.index : ArrayCount(bucket->data));
-			for (uint32_t index = 0; index < count; ++index) {
-				const auto &op = bucket->data[index];
-				bool left_match  = false;
-				bool right_match = false;
-				
-				if (code_type_are_same(op.parameters[0], left->type, false))
-				{
-					left_match = true;
-				}
-				else
-				{
-					auto cast_left = code_type_cast(left, op.parameters[0]);
-					if (cast_left)
-					{
-						left       = cast_left;
-						left_match = true;
-					}
-				}
-				
-				if (code_type_are_same(op.parameters[1], right->type))
-				{
-					right_match = true;
-				}
-				else
-				{
-					auto cast_right = code_type_cast(right, op.parameters[1]);
-					if (cast_right)
-					{
-						right       = cast_right;
-						right_match = true;
-					}
-				}
-				
-				if (left_match && right_match && (!op.compound || (op.compound && (left->flags & SYMBOL_BIT_LVALUE))))
-				{
-					auto node     = new Code_Node_Binary_Operator;
+			bool allow_cast = (pass == 1);
 
-					auto type = op.output;
+			for (auto bucket = &operators.first; bucket; bucket = bucket->next)
+			{
+				uint32_t count = ((bucket == operators.last) ? operators.index : ArrayCount(bucket->data));
+				for (uint32_t index = 0; index < count; ++index) {
+					const auto &op = bucket->data[index];
+
+					Code_Node *op_left  = left;
+					Code_Node *op_right = right;
 
-					if (op.output->kind == CODE_TYPE_POINTER && op.parameters[0]->kind == CODE_TYPE_POINTER)
-						type = left->type;
+					if (!code_type_are_same(op.parameters[0], left->type, false))
+						op_left = allow_cast ? code_type_cast(left, op.parameters[0]) : nullptr;
 
-					node->type    = type;
-					node->left    = left;
-					node->right   = right;
-					node->flags   = left->flags & right->flags;
-					node->op_kind = op_kind;
+					if (!code_type_are_same(op.parameters[1], right->type))
+						op_right = allow_cast ? code_type_cast(right, op.parameters[1]) : nullptr;
 					
-					return node;
+					if (op_left && op_right && (!op.compound || (op.compound && (op_left->flags & SYMBOL_BIT_LVALUE))))
+					{
+						auto node     = new Code_Node_Binary_Operator;
+
+						auto type = op.output;
+
+						if (op.output->kind == CODE_TYPE_POINTER && op.parameters[0]->kind == CODE_TYPE_POINTER)
+							type = op_left->type;
+
+						node->type    = type;
+						node->left    = op_left;
+						node->right   = op_right;
+						node->flags   = op_left->flags & op_right->flags;
+						node->op_kind = op_kind;
+						node->operation = code_binary_operation(op_kind, op_left->type->kind);
+						
+						return node;
+					}
 				}
 			}
 		}
@@ -1574,12 +1793,14 @@ static Code_Node_Assignment *code_resolve_declaration(Code_Type_Resolver *resolv
 			proc_symbols->parent = symbols;
 			
 			auto stack_top       = resolver->virtual_address[Symbol_Address::STACK];
+			auto stack_peak      = resolver->stack_peak;
 			auto address_kind    = resolver->address_kind;
 			
+			resolver->stack_peak = 0;
 			if (proc_type->return_type)
-				resolver->virtual_address[Symbol_Address::STACK] = proc_type->return_type->runtime_size;
+				code_resolve_stack_top(resolver, proc_type->return_type->runtime_size);
 			else
-				resolver->virtual_address[Symbol_Address::STACK] = 0;
+				code_resolve_stack_top(resolver, 0);
 			
 			resolver->address_kind = Symbol_Address::STACK;
 			
@@ -1607,11 +1828,21 @@ static Code_Node_Assignment *code_resolve_declaration(Code_Type_Resolver *resolv
 			if (!symbol->type)
 				symbol->type = proc_type;
 			
+			auto frame_escapes      = resolver->frame_escapes;
+			auto first_tail_call    = resolver->tail_calls.count;
+			resolver->frame_escapes = false;
+			
 			resolver->return_stack.Add(proc_type->return_type);
 			procedure_body = code_resolve_block(resolver, proc_symbols, (int64_t)proc->location.start_row, proc->body);
 			resolver->return_stack.count -= 1;
 			
+			code_resolve_tail_calls(resolver, first_tail_call);
+			resolver->frame_escapes = frame_escapes;
+			
+			procedure_body->frame_size = resolver->stack_peak;
+			
 			resolver->virtual_address[Symbol_Address::STACK] = stack_top;
+			resolver->stack_peak                             = stack_peak;
 			resolver->address_kind                           = address_kind;
 		};
 		
@@ -1623,6 +1854,7 @@ static Code_Node_Assignment *code_resolve_declaration(Code_Type_Resolver *resolv
 			struct_type->members                             = new Code_Type_Struct::Member[struct_type->member_count];
 			
 			auto stack_top                                   = resolver->virtual_address[Symbol_Address::STACK];
+			auto stack_peak                                  = resolver->stack_peak;
 			auto address_kind                                = resolver->address_kind;
 			resolver->address_kind                           = Symbol_Address::STACK;
 			resolver->virtual_address[Symbol_Address::STACK] = 0;
@@ -1664,6 +1896,7 @@ static Code_Node_Assignment *code_resolve_declaration(Code_Type_Resolver *resolv
 			struct_type->alignment                           = alignment;
 			
 			resolver->virtual_address[Symbol_Address::STACK] = stack_top;
+			resolver->stack_peak                             = stack_peak;
 			resolver->address_kind                           = address_kind;
 		};
 		
@@ -1758,7 +1991,16 @@ static Code_Node_Assignment *code_resolve_declaration(Code_Type_Resolver *resolv
 			symbol->address  = symbol_address_offset(address, resolver->address_kind);
 			address += size;
 			
-			resolver->virtual_address[resolver->address_kind] = address;
+			if (resolver->address_kind == Symbol_Address::STACK)
+			{
+				code_resolve_stack_top(resolver, address);
+				
+				// Static arrays in the frame are viewed in place when cast to slices
+				if (code_type_holds_static_array(symbol->type))
+					resolver->frame_escapes = true;
+			}
+			else
+				resolver->virtual_address[resolver->address_kind] = address;
 			
 			if (root->initializer)
 			{
@@ -1804,7 +2046,10 @@ static Code_Node_Assignment *code_resolve_declaration(Code_Type_Resolver *resolv
 				symbol->address         = symbol_address_offset(address_offset, resolver->address_kind);
 				address_offset += size;
 				
-				resolver->virtual_address[resolver->address_kind] = address_offset;
+				if (resolver->address_kind == Symbol_Address::STACK)
+					code_resolve_stack_top(resolver, address_offset);
+				else
+					resolver->virtual_address[resolver->address_kind] = address_offset;
 
 				if (procedure_body)
 				{
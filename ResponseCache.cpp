@@ -0,0 +1,435 @@
+#include "ResponseCache.h"
+
+#include <new>
+
+#if PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//
+// Compression of the responses, LZ77 with a single probe hash table. The compressed data is a list of
+// sequences: the count of literal bytes, the literal bytes, then the length and the offset of a match
+// into the bytes decompressed before. The last sequence has no match.
+//
+
+constexpr int64_t  LZ_MIN_MATCH  = 4;
+constexpr uint32_t LZ_HASH_BITS  = 14;
+
+static constexpr int64_t lz_compress_bound(int64_t size)
+{
+	return size + size / 128 + 16;
+}
+
+static uint32_t lz_read32(const uint8_t *src)
+{
+	uint32_t value;
+	memcpy(&value, src, sizeof(value));
+	return value;
+}
+
+static uint32_t lz_hash(uint32_t value)
+{
+	return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t *lz_write_count(uint8_t *dst, uint64_t count)
+{
+	while (count >= 0x80)
+	{
+		*dst++ = (uint8_t)(count | 0x80);
+		count >>= 7;
+	}
+	*dst++ = (uint8_t)count;
+	return dst;
+}
+
+static const uint8_t *lz_read_count(const uint8_t *src, uint64_t *count)
+{
+	uint64_t value = 0;
+	int      shift = 0;
+	while (*src & 0x80)
+	{
+		value |= (uint64_t)(*src++ & 0x7f) << shift;
+		shift += 7;
+	}
+	value |= (uint64_t)(*src++) << shift;
+	*count = value;
+	return src;
+}
+
+static uint8_t *lz_write_literals(uint8_t *dst, const uint8_t *src, int64_t count)
+{
+	dst = lz_write_count(dst, count);
+	memcpy(dst, src, count);
+	return dst + count;
+}
+
+// Returns the compressed size, (dst) must hold lz_compress_bound(size) bytes
+static int64_t lz_compress(const uint8_t *src, int64_t size, uint8_t *dst)
+{
+	uint32_t table[1 << LZ_HASH_BITS] = {};
+
+	auto    start  = dst;
+	int64_t anchor = 0;
+	int64_t pos    = 0;
+
+	while (pos + LZ_MIN_MATCH <= size)
+	{
+		auto value = lz_read32(src + pos);
+		auto slot  = lz_hash(value);
+		auto match = (int64_t)table[slot];
+
+		table[slot] = (uint32_t)pos;
+
+		if (match >= pos || lz_read32(src + match) != value)
+		{
+			pos += 1;
+			continue;
+		}
+
+		int64_t length = LZ_MIN_MATCH;
+		while (pos + length < size && src[match + length] == src[pos + length])
+			length += 1;
+
+		dst = lz_write_literals(dst, src + anchor, pos - anchor);
+		dst = lz_write_count(dst, length - LZ_MIN_MATCH);
+		dst = lz_write_count(dst, pos - match);
+
+		pos   += length;
+		anchor = pos;
+	}
+
+	dst = lz_write_literals(dst, src + anchor, size - anchor);
+
+	return dst - start;
+}
+
+static void lz_decompress(const uint8_t *src, int64_t size, uint8_t *dst)
+{
+	auto end = src + size;
+
+	while (true)
+	{
+		uint64_t literals;
+		src = lz_read_count(src, &literals);
+		memcpy(dst, src, literals);
+		src += literals;
+		dst += literals;
+
+		if (src == end)
+			break;
+
+		uint64_t length, offset;
+		src = lz_read_count(src, &length);
+		src = lz_read_count(src, &offset);
+		length += LZ_MIN_MATCH;
+
+		// The match may overlap the bytes it writes
+		auto match = dst - offset;
+		for (uint64_t index = 0; index < length; ++index)
+			dst[index] = match[index];
+		dst += length;
+	}
+}
+
+//
+//
+//
+
+// A single response is kept up to this fraction of the limit of the cache, measured before compression: the
+// repetitive traces compress so well that a response of gigabytes would be recorded before being dropped
+constexpr uint64_t RESPONSE_ENTRY_FRACTION = 4;
+
+struct Response_Key
+{
+	String code;
+	String input;
+};
+
+static bool operator==(const Response_Key &a, const Response_Key &b)
+{
+	return a.code == b.code && a.input == b.input;
+}
+
+struct Response_Key_Hash
+{
+	size_t operator()(const Response_Key key) const
+	{
+		auto seed = Murmur3Hash32(key.input.data, key.input.length, 0x31415926);
+		return Murmur3Hash32(key.code.data, key.code.length, seed);
+	}
+};
+
+// Allocated together with its key, that follows it
+struct Response_Entry
+{
+	Response_Key    key;
+	uint8_t *       data       = nullptr; // Segments of the response, taken over from its record
+	int64_t         size       = 0;
+	int64_t         capacity   = 0;
+	uint64_t        allocated  = 0; // Bytes counted against the limit of the cache
+	uint32_t        references = 0;
+	bool            cached     = false;
+	Response_Entry *prev       = nullptr; // Most recently used first
+	Response_Entry *next       = nullptr;
+};
+
+struct Response_Cache
+{
+#if PLATFORM_WINDOWS
+	SRWLOCK lock = SRWLOCK_INIT;
+#else
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+	Table<Response_Key, Response_Entry *, Response_Key_Hash> responses;
+	Response_Entry *                                         first = nullptr;
+	Response_Entry *                                         last  = nullptr;
+
+	uint64_t size  = 0;
+	uint64_t limit = 0;
+
+	Memory_Allocator allocator = ThreadContext.allocator;
+};
+
+static void response_cache_lock(Response_Cache *cache)
+{
+#if PLATFORM_WINDOWS
+	AcquireSRWLockExclusive(&cache->lock);
+#else
+	pthread_mutex_lock(&cache->lock);
+#endif
+}
+
+static void response_cache_unlock(Response_Cache *cache)
+{
+#if PLATFORM_WINDOWS
+	ReleaseSRWLockExclusive(&cache->lock);
+#else
+	pthread_mutex_unlock(&cache->lock);
+#endif
+}
+
+static void response_cache_unlink(Response_Cache *cache, Response_Entry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->first = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->last = entry->prev;
+	entry->prev = entry->next = nullptr;
+}
+
+static void response_cache_push_front(Response_Cache *cache, Response_Entry *entry)
+{
+	entry->prev = nullptr;
+	entry->next = cache->first;
+	if (cache->first)
+		cache->first->prev = entry;
+	else
+		cache->last = entry;
+	cache->first = entry;
+}
+
+static void response_entry_free(Response_Cache *cache, Response_Entry *entry)
+{
+	if (entry->data)
+		MemoryFree(entry->data, entry->capacity, cache->allocator);
+	MemoryFree(entry, sizeof(Response_Entry) + entry->key.code.length + entry->key.input.length, cache->allocator);
+}
+
+Response_Cache *response_cache_create(uint64_t limit)
+{
+	auto cache   = new Response_Cache;
+	cache->limit = limit;
+	return cache;
+}
+
+bool response_cache_find(Response_Cache *cache, String code, String input, String_Builder *builder, String_Builder_Stream *stream)
+{
+	Response_Key key = { code, input };
+
+	Response_Entry *entry = nullptr;
+
+	response_cache_lock(cache);
+
+	if (auto found = cache->responses.Find(key))
+	{
+		entry = *found;
+		entry->references += 1;
+		response_cache_unlink(cache, entry);
+		response_cache_push_front(cache, entry);
+	}
+
+	response_cache_unlock(cache);
+
+	if (!entry)
+		return false;
+
+	// @Note: The reference keeps the entry alive while the response is decompressed and streamed,
+	// which waits for the client
+	uint8_t *buffer   = nullptr;
+	uint64_t capacity = 0;
+
+	auto src = (const uint8_t *)entry->data;
+	auto end = src + entry->size;
+
+	while (src < end)
+	{
+		uint64_t size, compressed;
+		src = lz_read_count(src, &size);
+		src = lz_read_count(src, &compressed);
+
+		if (size > capacity)
+		{
+			buffer   = (uint8_t *)MemoryReallocate(capacity, size, buffer, cache->allocator);
+			capacity = size;
+		}
+
+		lz_decompress(src, compressed, buffer);
+		src += compressed;
+
+		WriteBuffer(builder, buffer, size);
+
+		if (stream && builder->written >= stream->threshold)
+			stream->flush(stream, builder);
+	}
+
+	if (buffer)
+		MemoryFree(buffer, capacity, cache->allocator);
+
+	response_cache_lock(cache);
+	entry->references -= 1;
+	bool unused = !entry->references && !entry->cached;
+	response_cache_unlock(cache);
+
+	if (unused)
+		response_entry_free(cache, entry);
+
+	return true;
+}
+
+// @Note: The records are appended to while the program executes, when the allocator of the thread is the
+// arena of the execution, so nothing is allocated here but the record itself
+void response_record_append(Response_Cache *cache, Response_Record *record, String_Builder *builder)
+{
+	if (record->dropped || !builder->written)
+		return;
+
+	record->recorded += builder->written;
+	if ((uint64_t)record->recorded > cache->limit / RESPONSE_ENTRY_FRACTION)
+	{
+		response_record_free(cache, record);
+		record->dropped = true;
+		return;
+	}
+
+	// Every bucket is compressed in place as a segment of its own
+	uint8_t temp[lz_compress_bound(STRING_BUILDER_BUCKET_SIZE)];
+
+	for (auto buk = &builder->head; buk; buk = buk->next)
+	{
+		if (!buk->written)
+			continue;
+
+		// Room for the sizes of the segment, then its compressed data
+		auto required = record->size + 2 * 10 + lz_compress_bound(buk->written);
+		if (required > record->capacity)
+		{
+			auto capacity    = Maximum(required, record->capacity * 2);
+			record->data     = (uint8_t *)MemoryReallocate(record->capacity, capacity, record->data, cache->allocator);
+			record->capacity = capacity;
+		}
+
+		auto compressed = lz_compress(buk->data, buk->written, temp);
+
+		auto dst = record->data + record->size;
+		dst      = lz_write_count(dst, buk->written);
+		dst      = lz_write_count(dst, compressed);
+		memcpy(dst, temp, compressed);
+		dst += compressed;
+
+		record->size = dst - record->data;
+	}
+}
+
+void response_record_free(Response_Cache *cache, Response_Record *record)
+{
+	if (record->data)
+		MemoryFree(record->data, record->capacity, cache->allocator);
+	record->data     = nullptr;
+	record->size     = 0;
+	record->capacity = 0;
+}
+
+void response_cache_insert(Response_Cache *cache, String code, String input, Response_Record *record)
+{
+	uint64_t allocated = sizeof(Response_Entry) + code.length + input.length + record->capacity;
+
+	if (record->dropped || allocated > cache->limit)
+	{
+		response_record_free(cache, record);
+		return;
+	}
+
+	auto memory = (uint8_t *)MemoryAllocate(sizeof(Response_Entry) + code.length + input.length, cache->allocator);
+	auto entry  = new (memory) Response_Entry;
+
+	auto key = memory + sizeof(Response_Entry);
+
+	memcpy(key, code.data, code.length);
+	entry->key.code = String(key, code.length);
+	key += code.length;
+
+	memcpy(key, input.data, input.length);
+	entry->key.input = String(key, input.length);
+
+	entry->data      = record->data;
+	entry->size      = record->size;
+	entry->capacity  = record->capacity;
+	entry->allocated = allocated;
+
+	*record = Response_Record{};
+
+	Array<Response_Entry *> evicted;
+
+	response_cache_lock(cache);
+
+	// Another execution of the same submission finished first
+	if (cache->responses.Find(entry->key))
+	{
+		evicted.Add(entry);
+	}
+	else
+	{
+		entry->cached = true;
+		cache->responses.Put(entry->key, entry);
+		response_cache_push_front(cache, entry);
+		cache->size += entry->allocated;
+
+		while (cache->size > cache->limit)
+		{
+			auto victim = cache->last;
+			response_cache_unlink(cache, victim);
+			cache->responses.Remove(victim->key);
+			cache->size -= victim->allocated;
+			victim->cached = false;
+			if (!victim->references)
+				evicted.Add(victim);
+		}
+	}
+
+	response_cache_unlock(cache);
+
+	for (auto victim : evicted)
+		response_entry_free(cache, victim);
+	Free(&evicted);
+}
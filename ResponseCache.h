@@ -0,0 +1,41 @@
+#pragma once
+#include "Kr/KrBasic.h"
+#include "StringBuilder.h"
+
+//
+// Keeps the responses of the executions by their code and input. A program only reads its code and
+// its console input, so the same submission always produces the same response, and a cached response
+// is served without compiling or executing anything. The responses are kept compressed: the traces
+// repeat the same keys and symbols for every statement and shrink by an order of magnitude.
+//
+// Responses are evicted in least recently used order once their total compressed size is above the
+// limit of the cache. An evicted response is freed when the last request reading it is done.
+//
+
+struct Response_Cache;
+
+// Response being recorded while it is generated, as a list of compressed segments: the responses that are
+// streamed are never whole in memory
+struct Response_Record
+{
+	uint8_t *data     = nullptr;
+	int64_t  size     = 0;
+	int64_t  capacity = 0;
+	int64_t  recorded = 0;     // Bytes of the response before compression
+	bool     dropped  = false; // Grew above the largest response that the cache keeps
+};
+
+Response_Cache *response_cache_create(uint64_t limit);
+
+// Writes the cached response of (code) and (input) to the builder, handing it to (stream) as it is decompressed
+// when there is one. Returns false when the response is not cached.
+bool response_cache_find(Response_Cache *cache, String code, String input, String_Builder *builder, String_Builder_Stream *stream);
+
+// Compresses the buckets of the builder as the next segments of the record, the builder is left as it is. The
+// responses longer than a fraction of the limit of the cache are dropped, they are not recorded any further.
+void response_record_append(Response_Cache *cache, Response_Record *record, String_Builder *builder);
+
+// Keeps the recorded response of (code) and (input), the cache takes over the data of the record
+void response_cache_insert(Response_Cache *cache, String code, String input, Response_Record *record);
+
+void response_record_free(Response_Cache *cache, Response_Record *record);
@@ -2,11 +2,51 @@
 #include "Resolver.h"
 #include "Interp.h"
 #include "Kr/KrString.h"
+#include "ProgramCache.h"
+#include "ResponseCache.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <setjmp.h>
 
-bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, String_Builder *builder);
+bool GenerateDebugCodeInfo(String code, String input, Memory_Arena *arena, String_Builder *builder, String_Builder_Stream *stream, int64_t trace_limit, Program_Cache *cache, bool bytecode, bool optimize, bool heap_profile);
+
+// Set by the --vm command line option, runs the requests on the bytecode VM instead of the tree walker
+static bool ExecuteBytecode = false;
+
+// Set by the --optimize command line option, runs the optimizer between resolving and execution
+static bool OptimizeCode = false;
+
+// Set by the --heap-profile command line option, adds the allocations by source row to the responses
+static bool ProfileHeap = false;
+
+// Set by the --workers=N command line option, the number of requests that are executed at the same time
+static int WorkerCount = 0;
+
+// Set by the --reactors=N command line option, the number of event loops accepting and serving connections
+static int ReactorCount = 0;
+
+// Set by the --program-cache=MB command line option, the memory kept for the compiled programs, zero disables the cache
+static uint64_t ProgramCacheLimit = MegaBytes(64);
+
+// Programs compiled by the previous requests, shared by all the workers
+static Program_Cache *Programs = nullptr;
+
+// Set by the --response-cache=MB command line option, the memory kept for the compressed responses, zero disables the cache
+static uint64_t ResponseCacheLimit = MegaBytes(64);
+
+// Responses of the previous requests by their code and input, shared by all the workers
+static Response_Cache *Responses = nullptr;
+
+// Set by the --trace-limit=MB command line option, the programs are stopped with a runtime error once their
+// response is longer, zero disables the limit
+static int64_t TraceLimit = MegaBytes(128);
+
+// Arena of each worker, reset for every request that it executes
+constexpr uint64_t WORKER_ARENA_SIZE = MegaBytes(128);
+
+// Size of the chunks of the responses that are sent while the requests execute
+constexpr int64_t STREAM_CHUNK_SIZE = KiloBytes(64);
 
 struct Request
 {
@@ -20,6 +60,13 @@ struct Code_Execution
 	String input;
 	Memory_Arena *arena;
 	String_Builder *builder;
+	String_Builder_Stream *stream;
+	int64_t trace_limit;
+	Program_Cache *programs;
+	Response_Cache *responses;
+	bool bytecode;
+	bool optimize;
+	bool heap_profile;
 	bool failed;
 };
 
@@ -53,118 +100,636 @@ static Request ParseRequest(String content)
 	return request;
 }
 
-#if PLATFORM_LINUX
-#define HTTPSERVER_IMPL
-#include "httpserver.h"
+static void ParseOptions(int argc, char **argv)
+{
+	for (int index = 1; index < argc; ++index) {
+		if (strcmp(argv[index], "--vm") == 0)
+			ExecuteBytecode = true;
+		else if (strcmp(argv[index], "--optimize") == 0)
+			OptimizeCode = true;
+		else if (strcmp(argv[index], "--heap-profile") == 0)
+			ProfileHeap = true;
+		else if (strncmp(argv[index], "--workers=", 10) == 0)
+			WorkerCount = atoi(argv[index] + 10);
+		else if (strncmp(argv[index], "--reactors=", 11) == 0)
+			ReactorCount = atoi(argv[index] + 11);
+		else if (strncmp(argv[index], "--program-cache=", 16) == 0)
+			ProgramCacheLimit = MegaBytes(strtoull(argv[index] + 16, nullptr, 10));
+		else if (strncmp(argv[index], "--response-cache=", 17) == 0)
+			ResponseCacheLimit = MegaBytes(strtoull(argv[index] + 17, nullptr, 10));
+		else if (strncmp(argv[index], "--trace-limit=", 14) == 0)
+			TraceLimit = MegaBytes(strtoull(argv[index] + 14, nullptr, 10));
+	}
+}
 
-#include <pthread.h>
+// The errors of the parser and the resolver jump back here from the worker executing the request
+static thread_local jmp_buf ExecuteRecover;
 
 static void parser_on_error(Parser *parser) {
 	Write(parser->error, "\"}");
-	pthread_exit(NULL);
+	longjmp(ExecuteRecover, 1);
 }
 
 static void code_type_resolver_on_error(Code_Type_Resolver *resolver) {
 	auto error = code_type_resolver_error_stream(resolver);
 	Write(error, "\"}");
-	pthread_exit(NULL);
+	longjmp(ExecuteRecover, 1);
 }
 
-void *ExecuteCodeThreadProc(void *param)
+// Records the chunks of a response for the cache on their way to the client
+struct Recording_Stream
 {
-	auto exe = (Code_Execution *)param;
+	String_Builder_Stream  stream;
+	String_Builder_Stream *target;
+	Response_Cache *       cache;
+	Response_Record        record;
+};
 
-	InitThreadContext(0);
+static void RecordChunk(String_Builder_Stream *stream, String_Builder *builder)
+{
+	auto recording = (Recording_Stream *)stream->context;
 
-	exe->failed = !GenerateDebugCodeInfo(exe->code, exe->input, exe->arena, exe->builder);
-	if (exe->failed)
+	// The responses that are too long to be cached are only forwarded
+	if (!recording->record.dropped)
+		response_record_append(recording->cache, &recording->record, builder);
+
+	recording->target->flush(recording->target, builder);
+	stream->closed = recording->target->closed;
+}
+
+static void ExecuteCode(Code_Execution *exe)
+{
+	if (exe->responses && response_cache_find(exe->responses, exe->code, exe->input, exe->builder, exe->stream))
 	{
-		return NULL;
+		exe->failed = false;
+		return;
 	}
 
-	return NULL;
+	auto stream = exe->stream;
+
+	Recording_Stream recording;
+	if (exe->responses && stream)
+	{
+		recording.stream.flush     = RecordChunk;
+		recording.stream.context   = &recording;
+		recording.stream.threshold = stream->threshold;
+		recording.target           = stream;
+		recording.cache            = exe->responses;
+		stream                     = &recording.stream;
+	}
+
+	auto allocator = ThreadContext.allocator;
+
+	if (setjmp(ExecuteRecover))
+	{
+		// @Note: The error has been written as the JSON response already. The jump skipped the
+		// cleanup of GenerateDebugCodeInfo, the worker resets its arena before the next request.
+		// The errors come before the first chunk, nothing was recorded.
+		ThreadContext.allocator = allocator;
+		exe->failed = false;
+		return;
+	}
+
+	exe->failed = !GenerateDebugCodeInfo(exe->code, exe->input, exe->arena, exe->builder, stream, exe->trace_limit, exe->programs, exe->bytecode, exe->optimize, exe->heap_profile);
+
+	if (exe->responses)
+	{
+		// A response stopped because the client left depends on when it left
+		if (!exe->failed && !(stream && stream->closed))
+		{
+			// The end of the response is still in the builder
+			response_record_append(exe->responses, &recording.record, exe->builder);
+			response_cache_insert(exe->responses, exe->code, exe->input, &recording.record);
+		}
+		else
+		{
+			response_record_free(exe->responses, &recording.record);
+		}
+	}
 }
 
-void handle_request(struct http_request_s *request)
+#if PLATFORM_LINUX
+#define HTTPSERVER_IMPL
+#include "httpserver.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+
+//
+// Requests are executed by a fixed pool of workers, that keep their thread context, arena and string
+// builder from one request to the next. The event loop hands the requests to the workers and goes back
+// to the other connections. Finished requests are queued back to the event loop, which is woken up
+// through an eventfd to write their responses.
+//
+// The connections are served by several event loops, the reactors, each on its own thread with its own
+// epoll and listening socket. The sockets all bind the same port with SO_REUSEPORT, so the kernel spreads
+// the incoming connections between them. A connection stays with the reactor that accepted it.
+//
+// Long responses are streamed as chunks while the request executes. The worker hands one chunk at a time
+// to the reactor, through the same queue as the finished jobs, and waits for it to be written to the
+// socket before handing over the next one: a slow client throttles the execution, instead of the response
+// piling up in memory.
+//
+// The responses are written from the buckets of the builders with writev, without being copied. The
+// buckets are taken out of the builder of the worker and released to a shared pool once written, which
+// gives them back to the workers.
+//
+
+struct Server_Reactor;
+
+struct Server_Job
 {
-	auto code = http_request_body(request);
+	struct http_request_s * request;
+	Server_Reactor *        reactor;
+	Code_Execution          exe;
+	String_Builder_Stream   stream;
+	uint8_t *               content; // Copy of the request body, that the code and the input point into
+	String_Builder::Bucket *body;
+	bool                    done;
+	Server_Job *            next;
+
+	// Chunk handed to the reactor, until it has been written
+	pthread_mutex_t         lock      = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t          written   = PTHREAD_COND_INITIALIZER;
+	String_Builder::Bucket *chunk     = nullptr;
+	bool                    closed    = false; // The session ended, the rest of the response is dropped
+	bool                    streaming = false; // Only used by the reactor, the headers have been sent
+};
 
-	String content;
-	content.data = (uint8_t *)code.buf;
-	content.length = code.len;
+// Buckets of the responses that have been written, handed back to the builders of the workers
+struct Server_Bucket_Pool
+{
+	pthread_mutex_t         lock  = PTHREAD_MUTEX_INITIALIZER;
+	String_Builder::Bucket *first = nullptr;
+	int64_t                 count = 0;
+};
 
-	Request req = ParseRequest(content);
+struct Server_Job_Queue
+{
+	pthread_mutex_t lock   = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t  signal = PTHREAD_COND_INITIALIZER;
+	Server_Job *    first  = nullptr;
+	Server_Job *    last   = nullptr;
+};
 
-	printf("Requested code::\n%s\nInput::%s\n\n", req.code.data, req.input.data);
+// Registered with the epoll of its server, which expects the callback as the first member
+struct Server_Reactor
+{
+	void (*handler)(struct epoll_event *);
+	int                   event;
+	Server_Job_Queue      finished;
+	struct http_server_s *server;
+};
 
-	auto arena = MemoryArenaAllocate(MegaBytes(128));
+static Server_Job_Queue PendingJobs;
 
-	String_Builder builder;
+static Server_Bucket_Pool BucketPool;
+
+// Buckets kept by the pool, the ones released above it are freed
+constexpr int64_t BUCKET_POOL_LIMIT = MegaBytes(16) / sizeof(String_Builder::Bucket);
+
+static void PushJob(Server_Job_Queue *queue, Server_Job *job)
+{
+	job->next = nullptr;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->last)
+		queue->last->next = job;
+	else
+		queue->first = job;
+	queue->last = job;
+	pthread_mutex_unlock(&queue->lock);
+
+	pthread_cond_signal(&queue->signal);
+}
+
+static Server_Job *WaitJob(Server_Job_Queue *queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	while (!queue->first)
+		pthread_cond_wait(&queue->signal, &queue->lock);
+
+	auto job     = queue->first;
+	queue->first = job->next;
+	if (!queue->first)
+		queue->last = nullptr;
+	pthread_mutex_unlock(&queue->lock);
+
+	return job;
+}
+
+// Takes all the jobs of the queue, in the order they were pushed
+static Server_Job *TakeJobs(Server_Job_Queue *queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	auto jobs    = queue->first;
+	queue->first = nullptr;
+	queue->last  = nullptr;
+	pthread_mutex_unlock(&queue->lock);
+	return jobs;
+}
+
+// Takes the buckets of a response out of the builder of a worker, which gets as many back from the pool
+static String_Builder::Bucket *TakeResponse(String_Builder *builder)
+{
+	auto buckets = TakeBuckets(builder);
+
+	int64_t count = 0;
+	for (auto buk = buckets; buk; buk = buk->next)
+		count += 1;
 
-	Code_Execution exe;
-	exe.arena   = arena;
-	exe.builder = &builder;
-	exe.code    = req.code;
-	exe.input   = req.input;
-	exe.failed  = false;
+	String_Builder::Bucket *refill = nullptr;
 
-	pthread_t thread;
-	int result = pthread_create(&thread, NULL, ExecuteCodeThreadProc, &exe);
-	if (result != 0)
+	pthread_mutex_lock(&BucketPool.lock);
+	for (; count && BucketPool.first; --count)
 	{
-		MemoryArenaFree(arena);
-		FreeBuilder(&builder);
-		return;
+		auto buk         = BucketPool.first;
+		BucketPool.first = buk->next;
+		BucketPool.count -= 1;
+		buk->next        = refill;
+		refill           = buk;
+	}
+	pthread_mutex_unlock(&BucketPool.lock);
+
+	GiveBuckets(builder, refill);
+
+	return buckets;
+}
+
+static void ReleaseBuckets(String_Builder::Bucket *buckets)
+{
+	pthread_mutex_lock(&BucketPool.lock);
+	while (buckets && BucketPool.count < BUCKET_POOL_LIMIT)
+	{
+		auto buk         = buckets;
+		buckets          = buk->next;
+		buk->next        = BucketPool.first;
+		BucketPool.first = buk;
+		BucketPool.count += 1;
+	}
+	pthread_mutex_unlock(&BucketPool.lock);
+
+	while (buckets)
+	{
+		auto buk = buckets;
+		buckets  = buk->next;
+		MemoryFree(buk, sizeof(*buk));
+	}
+}
+
+static void NotifyReactor(Server_Job *job)
+{
+	auto reactor = job->reactor;
+	PushJob(&reactor->finished, job);
+
+	uint64_t finished = 1;
+	ssize_t  result   = write(reactor->event, &finished, sizeof(finished));
+	(void)result;
+}
+
+// Waits for the reactor to write the chunk handed to it, returns false when the session ended
+static bool WaitChunkWritten(Server_Job *job)
+{
+	pthread_mutex_lock(&job->lock);
+	while (job->chunk && !job->closed)
+		pthread_cond_wait(&job->written, &job->lock);
+	bool closed = job->closed;
+	pthread_mutex_unlock(&job->lock);
+	return !closed;
+}
+
+// Hands what the builder holds to the reactor as the next chunk of the response
+static void StreamChunk(String_Builder_Stream *stream, String_Builder *builder)
+{
+	auto job = (Server_Job *)stream->context;
+
+	// @Note: The chunk is only read by the reactor once the job is queued to it again, and only
+	// cleared by it before that
+	if (WaitChunkWritten(job))
+	{
+		job->chunk = TakeResponse(builder);
+		NotifyReactor(job);
+	}
+	else
+	{
+		stream->closed = true;
+		ResetBuilder(builder);
+	}
+}
+
+void *WorkerThreadProc(void *param)
+{
+	InitThreadContext(0);
+
+	auto arena = MemoryArenaAllocate(WORKER_ARENA_SIZE);
+
+	String_Builder builder;
+
+	while (true)
+	{
+		auto job = WaitJob(&PendingJobs);
+
+		MemoryArenaReset(arena);
+		ResetBuilder(&builder);
+
+		job->exe.arena   = arena;
+		job->exe.builder = &builder;
+		ExecuteCode(&job->exe);
+
+		// The builder is reused by the next request, the end of the response takes its buckets
+		if (WaitChunkWritten(job))
+			job->body = TakeResponse(&builder);
+
+		job->done = true;
+		NotifyReactor(job);
 	}
 
-	pthread_join(thread, NULL);
+	return NULL;
+}
 
-	int length = 0;
-	for (auto buk = &builder.head; buk; buk = buk->next)
-		length += buk->written;
+void *ReactorThreadProc(void *param)
+{
+	auto reactor = (Server_Reactor *)param;
 
-	uint8_t *body = PushArray(arena, uint8_t, length + 1);
+	InitThreadContext(0);
 
-	int written = 0;
-	for (auto buk = &builder.head; buk; buk = buk->next)
+	http_server_listen(reactor->server);
+	return NULL;
+}
+
+static void FreeJob(Server_Job *job)
+{
+	ReleaseBuckets(job->body);
+	free(job->content);
+	delete job;
+}
+
+// The server copies the iovecs, they only have to live for the call
+static int BucketsToIovec(String_Builder::Bucket *buckets, struct iovec **iov)
+{
+	int count = 0;
+	for (auto buk = buckets; buk; buk = buk->next)
+		count += 1;
+
+	*iov = (struct iovec *)malloc(sizeof(struct iovec) * Maximum(count, 1));
+
+	int index = 0;
+	for (auto buk = buckets; buk; buk = buk->next, ++index)
 	{
-		memcpy(body + written, buk->data, buk->written);
-		written += buk->written;
+		(*iov)[index].iov_base = buk->data;
+		(*iov)[index].iov_len  = buk->written;
 	}
-	Assert(written == length);
 
-	body[length] = 0;
+	return count;
+}
+
+// @Note: The session callbacks of the server close the sessions that ended, but these responses are
+// written from the completion event instead
+static void EndSessionIfRequired(struct http_request_s *request)
+{
+	if (HTTP_FLAG_CHECK(request->flags, HTTP_END_SESSION))
+		hs_end_session(request);
+}
+
+static void ResponseWritten(struct http_request_s *request)
+{
+	FreeJob((Server_Job *)http_request_userdata(request));
+}
 
-	const char *content_type = exe.failed ? "text/plain" : "application/json";
+static void RespondJob(Server_Job *job)
+{
+	const char *content_type = job->exe.failed ? "text/plain" : "application/json";
 
-	if (exe.failed)
+	if (job->exe.failed)
 	{
 		fprintf(stdout, "Execution Error:\n");
-		fprintf(stdout, "%.*s", length, body);
+		for (auto buk = job->body; buk; buk = buk->next)
+		{
+			fprintf(stdout, "%.*s", (int)buk->written, buk->data);
+		}
 		fprintf(stdout, "\n");
 	}
 
+	auto request = job->request;
+
 	struct http_response_s *response = http_response_init();
 	http_response_status(response, 200);
 	http_response_header(response, "Content-Type", content_type);
 	http_response_header(response, "Access-Control-Allow-Origin", "*");
 	http_response_header(response, "Access-Control-Allow-Headers", "*");
-	http_response_body(response, (char *)body, length);
-	http_respond(request, response);
 
-	MemoryArenaFree(arena);
-	FreeBuilder(&builder);
+	// The job is freed once its buckets have been written, which can happen before this returns
+	struct iovec *iov;
+	int count = BucketsToIovec(job->body, &iov);
+	http_respond_iovec(request, response, iov, count, ResponseWritten);
+	free(iov);
+
+	EndSessionIfRequired(request);
+}
+
+static void ChunkWritten(struct http_request_s *request)
+{
+	auto job   = (Server_Job *)http_request_userdata(request);
+	bool ended = HTTP_FLAG_CHECK(request->flags, HTTP_SESSION_ENDED);
+
+	// The request waits for the worker again, which can take longer than the timeout
+	if (!ended)
+		request->state = HTTP_SESSION_NOP;
+
+	pthread_mutex_lock(&job->lock);
+	auto chunk  = job->chunk;
+	job->chunk  = nullptr;
+	job->closed = ended;
+	pthread_cond_signal(&job->written);
+	pthread_mutex_unlock(&job->lock);
+
+	ReleaseBuckets(chunk);
+}
+
+static void StreamWritten(struct http_request_s *request)
+{
+	auto job = (Server_Job *)http_request_userdata(request);
+	if (!HTTP_FLAG_CHECK(request->flags, HTTP_SESSION_ENDED))
+		http_respond_chunk_end(request, http_response_init());
+	FreeJob(job);
+}
+
+// (written) can be called before this returns and free the job
+static void RespondChunk(Server_Job *job, String_Builder::Bucket *buckets, void (*written)(struct http_request_s *))
+{
+	auto request = job->request;
+
+	struct http_response_s *response = http_response_init();
+	if (!job->streaming)
+	{
+		http_response_status(response, 200);
+		http_response_header(response, "Content-Type", "application/json");
+		http_response_header(response, "Access-Control-Allow-Origin", "*");
+		http_response_header(response, "Access-Control-Allow-Headers", "*");
+		job->streaming = true;
+	}
+
+	struct iovec *iov;
+	int count = BucketsToIovec(buckets, &iov);
+	http_respond_chunk_iovec(request, response, iov, count, written);
+	free(iov);
+
+	EndSessionIfRequired(request);
+}
+
+static void ServeJob(Server_Job *job)
+{
+	if (!job->done)
+	{
+		RespondChunk(job, job->chunk, ChunkWritten);
+	}
+	else if (job->closed)
+	{
+		FreeJob(job);
+	}
+	else if (!job->streaming)
+	{
+		RespondJob(job);
+	}
+	else if (job->body)
+	{
+		RespondChunk(job, job->body, StreamWritten);
+	}
+	else
+	{
+		// An empty chunk would end the response
+		auto request = job->request;
+		http_respond_chunk_end(request, http_response_init());
+		EndSessionIfRequired(request);
+		FreeJob(job);
+	}
+}
+
+static void CompletionCallback(struct epoll_event *ev)
+{
+	auto reactor = (Server_Reactor *)ev->data.ptr;
+
+	uint64_t finished = 0;
+	ssize_t  result   = read(reactor->event, &finished, sizeof(finished));
+	(void)result;
+
+	auto job = TakeJobs(&reactor->finished);
+	while (job)
+	{
+		auto next = job->next;
+		ServeJob(job);
+		job = next;
+	}
 }
 
-int main()
+void handle_request(struct http_request_s *request)
+{
+	auto code = http_request_body(request);
+
+	auto job = new Server_Job;
+
+	// @Note: The buffer of the request is released by the first chunk of a streamed response, while the
+	// code and the input are still used by the execution
+	job->content = (uint8_t *)malloc(code.len + 1);
+	memcpy(job->content, code.buf, code.len);
+	job->content[code.len] = 0;
+
+	String content;
+	content.data = job->content;
+	content.length = code.len;
+
+	Request req = ParseRequest(content);
+
+	printf("Requested code::\n%s\nInput::%s\n\n", req.code.data, req.input.data);
+
+	job->stream.flush     = StreamChunk;
+	job->stream.context   = job;
+	job->stream.threshold = STREAM_CHUNK_SIZE;
+
+	job->request          = request;
+	job->reactor          = (Server_Reactor *)http_request_server_userdata(request);
+	job->exe.arena        = nullptr;
+	job->exe.builder      = nullptr;
+	job->exe.stream       = &job->stream;
+	job->exe.trace_limit  = TraceLimit;
+	job->exe.programs     = Programs;
+	job->exe.responses    = Responses;
+	job->exe.code         = req.code;
+	job->exe.input        = req.input;
+	job->exe.bytecode     = ExecuteBytecode;
+	job->exe.optimize     = OptimizeCode;
+	job->exe.heap_profile = ProfileHeap;
+	job->exe.failed       = false;
+	job->body             = nullptr;
+	job->done             = false;
+
+	http_request_set_userdata(request, job);
+
+	PushJob(&PendingJobs, job);
+}
+
+int main(int argc, char **argv)
 {
 	InitThreadContext(0);
 
+	ParseOptions(argc, argv);
+
+	if (WorkerCount <= 0)
+		WorkerCount = (int)Maximum(sysconf(_SC_NPROCESSORS_ONLN), 1);
+
 	parser_register_error_proc(parser_on_error);
 	code_type_resolver_register_error_proc(code_type_resolver_on_error);
 
-	struct http_server_s *server = http_server_init(8000, handle_request);
-	http_server_listen(server);
+	if (ProgramCacheLimit)
+		Programs = program_cache_create(ProgramCacheLimit);
+	if (ResponseCacheLimit)
+		Responses = response_cache_create(ResponseCacheLimit);
+
+	if (ReactorCount <= 0)
+		ReactorCount = (int)Maximum(sysconf(_SC_NPROCESSORS_ONLN), 1);
+
+	auto reactors = new Server_Reactor[ReactorCount];
+
+	for (int index = 0; index < ReactorCount; ++index)
+	{
+		auto reactor     = &reactors[index];
+		reactor->handler = CompletionCallback;
+		reactor->event   = eventfd(0, EFD_NONBLOCK);
+		reactor->server  = http_server_init(8000, handle_request);
+		http_server_set_userdata(reactor->server, reactor);
+
+		struct epoll_event ev;
+		ev.events   = EPOLLIN | EPOLLET;
+		ev.data.ptr = reactor;
+		epoll_ctl(http_server_loop(reactor->server), EPOLL_CTL_ADD, reactor->event, &ev);
+	}
+
+	for (int index = 0; index < WorkerCount; ++index)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, WorkerThreadProc, nullptr) != 0)
+		{
+			fprintf(stderr, "Failed to start the worker threads\n");
+			return 1;
+		}
+		pthread_detach(thread);
+	}
+
+	// The main thread runs the first reactor
+	for (int index = 1; index < ReactorCount; ++index)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, ReactorThreadProc, &reactors[index]) != 0)
+		{
+			fprintf(stderr, "Failed to start the reactor threads\n");
+			return 1;
+		}
+		pthread_detach(thread);
+	}
+
+	http_server_listen(reactors[0].server);
 	return 0;
 }
 
@@ -179,21 +744,6 @@ int main()
 #include <http.h>
 #pragma comment(lib, "httpapi.lib")
 
-DWORD WINAPI ExecuteCodeThreadProc(void *param)
-{
-	auto exe = (Code_Execution *)param;
-
-	InitThreadContext(0);
-
-	exe->failed = !GenerateDebugCodeInfo(exe->code, exe->input, exe->arena, exe->builder);
-	if (exe->failed)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
 DWORD SendHttpResponse(HANDLE req_queue, PHTTP_REQUEST request, USHORT status, const String reason, const String content_type, const String content)
 {
 	HTTP_RESPONSE response;
@@ -228,6 +778,111 @@ DWORD SendHttpResponse(HANDLE req_queue, PHTTP_REQUEST request, USHORT status, c
 	return result;
 }
 
+// Sends the response of a request from the buckets of the builder. The response is streamed while the
+// request executes: the sends are synchronous, so a slow client throttles the execution.
+struct Response_Writer
+{
+	String_Builder_Stream stream;
+	HANDLE                req_queue;
+	HTTP_REQUEST_ID       request_id;
+	bool                  headers_sent;
+	ULONG                 result;
+};
+
+static ULONG SendBuilder(Response_Writer *writer, String_Builder *builder, bool more_data)
+{
+	// The client is gone, the rest of the response is dropped
+	if (writer->result != NO_ERROR)
+		return writer->result;
+
+	auto scratch = ThreadScratchpad();
+	auto temp = BeginTemporaryMemory(scratch);
+
+	int chunk_count = 0;
+	for (auto buk = &builder->head; buk; buk = buk->next)
+	{
+		chunk_count += 1;
+	}
+
+	HTTP_DATA_CHUNK *data = PushArrayAligned(scratch, HTTP_DATA_CHUNK, chunk_count, sizeof(size_t));
+
+	int chunk_index = 0;
+	for (auto buk = &builder->head; buk; buk = buk->next)
+	{
+		data[chunk_index].DataChunkType = HttpDataChunkFromMemory;
+		data[chunk_index].FromMemory.pBuffer = buk->data;
+		data[chunk_index].FromMemory.BufferLength = (ULONG)buk->written;
+		chunk_index += 1;
+	}
+
+	ULONG flags = more_data ? HTTP_SEND_RESPONSE_FLAG_MORE_DATA : 0;
+	DWORD bytes_sent = 0;
+
+	if (!writer->headers_sent)
+	{
+		const String origin_name = "Access-Control-Allow-Origin";
+		const String headers_name = "Access-Control-Allow-Headers";
+		const String value = "*";
+
+		HTTP_UNKNOWN_HEADER unknown_headers[2];
+		unknown_headers[0].NameLength = (USHORT)origin_name.length;
+		unknown_headers[0].RawValueLength = (USHORT)value.length;
+		unknown_headers[0].pName = (char *)origin_name.data;
+		unknown_headers[0].pRawValue = (char *)value.data;
+
+		unknown_headers[1].NameLength = (USHORT)headers_name.length;
+		unknown_headers[1].RawValueLength = (USHORT)value.length;
+		unknown_headers[1].pName = (char *)headers_name.data;
+		unknown_headers[1].pRawValue = (char *)value.data;
+
+		const String reason = "OK";
+		HTTP_RESPONSE response;
+		memset(&response, 0, sizeof(response));
+		response.StatusCode = 200;
+		response.pReason = (char *)reason.data;
+		response.ReasonLength = (USHORT)reason.length;
+
+		String content_type = "application/json";
+		response.Headers.KnownHeaders[HttpHeaderContentType].pRawValue = (char *)content_type.data;
+		response.Headers.KnownHeaders[HttpHeaderContentType].RawValueLength = (USHORT)content_type.length;
+
+		response.Headers.UnknownHeaderCount = (USHORT)ArrayCount(unknown_headers);
+		response.Headers.pUnknownHeaders = unknown_headers;
+
+		response.EntityChunkCount = (USHORT)chunk_count;
+		response.pEntityChunks = data;
+
+		writer->headers_sent = true;
+		writer->result = HttpSendHttpResponse(writer->req_queue, writer->request_id, flags, &response, NULL, &bytes_sent, NULL, 0, NULL, NULL);
+
+		if (writer->result != NO_ERROR)
+		{
+			printf("HttpSendHttpResponse failed with %lu \n", writer->result);
+		}
+	}
+	else
+	{
+		writer->result = HttpSendResponseEntityBody(writer->req_queue, writer->request_id, flags, (USHORT)chunk_count, data, &bytes_sent, NULL, 0, NULL, NULL);
+
+		if (writer->result != NO_ERROR)
+		{
+			printf("HttpSendResponseEntityBody failed with %lu \n", writer->result);
+		}
+	}
+
+	EndTemporaryMemory(&temp);
+
+	return writer->result;
+}
+
+static void SendChunk(String_Builder_Stream *stream, String_Builder *builder)
+{
+	auto result    = SendBuilder((Response_Writer *)stream->context, builder, true);
+	stream->closed = (result != NO_ERROR);
+	ResetBuilder(builder);
+}
+
+// Every worker receives and executes its own requests from the shared request queue
 void Listen(HANDLE req_queue)
 {
 	size_t request_buffer_length = sizeof(HTTP_REQUEST) + 4096;
@@ -238,6 +893,10 @@ void Listen(HANDLE req_queue)
 		return;
 	}
 
+	auto arena = MemoryArenaAllocate(WORKER_ARENA_SIZE);
+
+	String_Builder builder;
+
 	PHTTP_REQUEST request = (PHTTP_REQUEST)request_buffer;
 
 	HTTP_REQUEST_ID request_id;
@@ -290,19 +949,33 @@ void Listen(HANDLE req_queue)
 				Request req = ParseRequest(content);
 				printf("Requested code::\n%s\nInput::%s\n\n", req.code.data, req.input.data);
 
-				String_Builder builder;
-				auto arena = MemoryArenaAllocate(MegaBytes(128));
+				MemoryArenaReset(arena);
+				ResetBuilder(&builder);
+
+				Response_Writer writer;
+				writer.stream.flush     = SendChunk;
+				writer.stream.context   = &writer;
+				writer.stream.threshold = STREAM_CHUNK_SIZE;
+				writer.req_queue        = req_queue;
+				writer.request_id       = request->RequestId;
+				writer.headers_sent     = false;
+				writer.result           = NO_ERROR;
 
 				Code_Execution exe;
 				exe.arena   = arena;
 				exe.builder = &builder;
+				exe.stream  = &writer.stream;
+				exe.trace_limit = TraceLimit;
 				exe.code    = req.code;
 				exe.input   = req.input;
+				exe.programs = Programs;
+				exe.responses = Responses;
+				exe.bytecode = ExecuteBytecode;
+				exe.optimize = OptimizeCode;
+				exe.heap_profile = ProfileHeap;
 				exe.failed  = false;
 
-				HANDLE thread = CreateThread(nullptr, 0, ExecuteCodeThreadProc, &exe, 0, nullptr);
-				WaitForSingleObject(thread, INFINITE);
-				CloseHandle(thread);
+				ExecuteCode(&exe);
 
 				if (exe.failed)
 				{
@@ -314,67 +987,8 @@ void Listen(HANDLE req_queue)
 					fprintf(stdout, "\n");
 				}
 
-				const String origin_name = "Access-Control-Allow-Origin";
-				const String headers_name = "Access-Control-Allow-Headers";
-				const String value = "*";
-
-				HTTP_UNKNOWN_HEADER unknown_headers[2];
-				unknown_headers[0].NameLength = (USHORT)origin_name.length;
-				unknown_headers[0].RawValueLength = (USHORT)value.length;
-				unknown_headers[0].pName = (char *)origin_name.data;
-				unknown_headers[0].pRawValue = (char *)value.data;
-
-				unknown_headers[1].NameLength = (USHORT)headers_name.length;
-				unknown_headers[1].RawValueLength = (USHORT)value.length;
-				unknown_headers[1].pName = (char *)headers_name.data;
-				unknown_headers[1].pRawValue = (char *)value.data;
-
-				const String reason = "OK";
-				HTTP_RESPONSE response;
-				memset(&response, 0, sizeof(response));
-				response.StatusCode = 200;
-				response.pReason = (char *)reason.data;
-				response.ReasonLength = (USHORT)reason.length;
-
-				String content_type = "application/json";
-				response.Headers.KnownHeaders[HttpHeaderContentType].pRawValue = (char *)content_type.data;
-				response.Headers.KnownHeaders[HttpHeaderContentType].RawValueLength = (USHORT)content_type.length;
-
-				response.Headers.UnknownHeaderCount = (USHORT)ArrayCount(unknown_headers);
-				response.Headers.pUnknownHeaders = unknown_headers;
-
-				int chunk_count = 0;
-				for (auto buk = &builder.head; buk; buk = buk->next)
-				{
-					chunk_count += 1;
-				}
-
-				HTTP_DATA_CHUNK *data = PushArrayAligned(scratch, HTTP_DATA_CHUNK, chunk_count, sizeof(size_t));
+				result = SendBuilder(&writer, &builder, false);
 
-				int chunk_index = 0;
-				int content_len = 0;
-				for (auto buk = &builder.head; buk; buk = buk->next)
-				{
-					data[chunk_index].DataChunkType = HttpDataChunkFromMemory;
-					data[chunk_index].FromMemory.pBuffer = buk->data;
-					data[chunk_index].FromMemory.BufferLength = buk->written;
-					chunk_index += 1;
-					content_len += buk->written;
-				}
-
-				response.EntityChunkCount = chunk_count;
-				response.pEntityChunks = data;
-
-				DWORD bytes_sent = 0;
-				result = HttpSendHttpResponse(req_queue, request->RequestId, 0, &response, NULL, &bytes_sent, NULL, 0, NULL, NULL);
-
-				if (result != NO_ERROR)
-				{
-					printf("HttpSendHttpResponse failed with %lu \n", result);
-				}
-
-				MemoryArenaFree(arena);
-				FreeBuilder(&builder);
 				EndTemporaryMemory(&temp);
 			}
 			break;
@@ -416,26 +1030,39 @@ void Listen(HANDLE req_queue)
 			break;
 		}
 	}
-}
 
-static void parser_on_error(Parser *parser) {
-	Write(parser->error, "\"}");
-	ExitThread(1);
+	MemoryArenaFree(arena);
+	FreeBuilder(&builder);
 }
 
-static void code_type_resolver_on_error(Code_Type_Resolver *resolver) {
-	auto error = code_type_resolver_error_stream(resolver);
-	Write(error, "\"}");
-	ExitThread(1);
+DWORD WINAPI ListenThreadProc(void *param)
+{
+	InitThreadContext(MegaBytes(16));
+	Listen((HANDLE)param);
+	return 0;
 }
 
-int main()
+int main(int argc, char **argv)
 {
 	InitThreadContext(MegaBytes(16));
 
+	ParseOptions(argc, argv);
+
+	if (WorkerCount <= 0)
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		WorkerCount = Maximum((int)info.dwNumberOfProcessors, 1);
+	}
+
 	parser_register_error_proc(parser_on_error);
 	code_type_resolver_register_error_proc(code_type_resolver_on_error);
 
+	if (ProgramCacheLimit)
+		Programs = program_cache_create(ProgramCacheLimit);
+	if (ResponseCacheLimit)
+		Responses = response_cache_create(ResponseCacheLimit);
+
 	auto result = HttpInitialize(HTTPAPI_VERSION_1, HTTP_INITIALIZE_SERVER, NULL);
 
 	if (result != NO_ERROR)
@@ -465,6 +1092,14 @@ int main()
 		return 1;
 	}
 
+	// The main thread is one of the workers
+	for (int index = 1; index < WorkerCount; ++index)
+	{
+		HANDLE thread = CreateThread(nullptr, 0, ListenThreadProc, req_queue, 0, nullptr);
+		if (thread)
+			CloseHandle(thread);
+	}
+
 	Listen(req_queue);
 
 	CloseHandle(req_queue);
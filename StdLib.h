@@ -2,6 +2,7 @@
 #include "Interp.h"
 #include "StringBuilder.h"
 #include "HeapAllocator.h"
+#include "HeapProfile.h"
 #include "JsonWriter.h"
 #include "Kr/KrString.h"
 #pragma once
@@ -24,6 +25,10 @@ struct Interp_User_Context {
 	Array<Call_Info> callstack;
 	clock_t          prev_count;
 	clock_t          first_count;
+
+	String_Builder_Stream *stream = nullptr; // Receives the snapshots while the program runs, when the response is streamed
+	int64_t trace_written = 0; // Bytes of the response already handed to the stream
+	int64_t trace_limit   = 0; // The program is stopped once the response is longer, zero for no limit
 };
 
 enum Memory_Type {
@@ -31,6 +36,7 @@ enum Memory_Type {
 	Memory_Type_STACK,
 	Memory_Type_GLOBAL,
 	Memory_Type_HEAP,
+	Memory_Type_ARENA,
 };
 
 static const char *memory_type_string(Memory_Type type) {
@@ -38,6 +44,7 @@ static const char *memory_type_string(Memory_Type type) {
 	if (type == Memory_Type_STACK) return "stack";
 	if (type == Memory_Type_GLOBAL) return "global";
 	if (type == Memory_Type_HEAP) return "heap";
+	if (type == Memory_Type_ARENA) return "arena";
 	return "(null)";
 }
 
@@ -49,6 +56,8 @@ static Memory_Type interp_get_memory_type(Interpreter *interp, void *ptr)
 		return Memory_Type_GLOBAL;
 	if (heap_contains_memory(interp->heap, ptr))
 		return Memory_Type_HEAP;
+	if (heap_arena_contains_memory(interp->heap, ptr))
+		return Memory_Type_ARENA;
 	return Memory_Type_INVALID;
 }
 
@@ -354,15 +363,63 @@ static void basic_allocate(Interpreter *interp) {
 	morph.OffsetReturn<void *>();
 	auto size = morph.Arg<Kano_Int>();
 	auto result = heap_alloc(interp->heap, size);
+	if (interp->heap_profile) {
+		String procedure = interp->current_row_procedure ? interp->current_row_procedure->name : String("global");
+		heap_profile_allocate(interp->heap_profile, interp->current_row, procedure, result, Maximum((uint64_t)size, sizeof(uint64_t)));
+	}
 	morph.Return(result);
 }
 
 static void basic_free(Interpreter *interp) {
 	Interp_Morph morph(interp);
 	auto ptr = morph.Arg<void *>();
+	if (interp->heap_profile)
+		heap_profile_free(interp->heap_profile, ptr);
 	heap_free(interp->heap, ptr);
 }
 
+static ptrdiff_t basic_arena_argument(Interpreter *interp, void *arena) {
+	auto index = heap_arena_find(interp->heap, arena);
+	if (index < 0)
+		interp_runtime_error(interp, "Invalid arena");
+	return index;
+}
+
+static void basic_arena_create(Interpreter *interp) {
+	Interp_Morph morph(interp);
+	morph.OffsetReturn<void *>();
+	auto size = morph.Arg<Kano_Int>();
+	void *result = size >= 0 ? heap_arena_create(interp->heap, (uint64_t)size) : nullptr;
+	morph.Return(result);
+}
+
+static void basic_arena_alloc(Interpreter *interp) {
+	Interp_Morph morph(interp);
+	morph.OffsetReturn<void *>();
+	auto arena = morph.Arg<void *>();
+	auto size = morph.Arg<Kano_Int>();
+	auto memory = interp->heap->arenas[basic_arena_argument(interp, arena)];
+	// @Note: Reset arenas hand out their memory again, so it is cleared like the memory of allocate.
+	// PushSize does not check the reserved size, an arena that is full returns null
+	void *result = nullptr;
+	auto bytes = Maximum((uint64_t)size, sizeof(uint64_t));
+	if (size >= 0 && bytes + sizeof(uint64_t) <= MemoryArenaEmptySize(memory))
+		result = PushSizeAlignedZero(memory, bytes, sizeof(uint64_t));
+	morph.Return(result);
+}
+
+static void basic_arena_reset(Interpreter *interp) {
+	Interp_Morph morph(interp);
+	auto arena = morph.Arg<void *>();
+	MemoryArenaReset(interp->heap->arenas[basic_arena_argument(interp, arena)]);
+}
+
+static void basic_arena_destroy(Interpreter *interp) {
+	Interp_Morph morph(interp);
+	auto arena = morph.Arg<void *>();
+	heap_arena_destroy(interp->heap, basic_arena_argument(interp, arena));
+}
+
 static void basic_sin(Interpreter *interp) {
 	Interp_Morph morph(interp);
 	morph.OffsetReturn<double>();
@@ -425,6 +482,21 @@ static void include_basic(Code_Type_Resolver *resolver)
 	proc_builder_argument(&builder, "*void");
 	proc_builder_register(&builder, "free", basic_free);
 
+	proc_builder_argument(&builder, "int");
+	proc_builder_return(&builder, "*void");
+	proc_builder_register(&builder, "arena_create", basic_arena_create);
+
+	proc_builder_argument(&builder, "*void");
+	proc_builder_argument(&builder, "int");
+	proc_builder_return(&builder, "*void");
+	proc_builder_register(&builder, "arena_alloc", basic_arena_alloc);
+
+	proc_builder_argument(&builder, "*void");
+	proc_builder_register(&builder, "arena_reset", basic_arena_reset);
+
+	proc_builder_argument(&builder, "*void");
+	proc_builder_register(&builder, "arena_destroy", basic_arena_destroy);
+
 	proc_builder_argument(&builder, "float");
 	proc_builder_return(&builder, "float");
 	proc_builder_register(&builder, "sin", basic_sin);
@@ -8,9 +8,11 @@ static String_Builder::Bucket *StringBuilderNewBucket(String_Builder *builder) {
 		builder->free_list = new(builder->allocator) String_Builder::Bucket;
 	}
 
+	// The data is not cleared, only what has been written is ever read
 	auto buk = builder->free_list;
 	builder->free_list = buk->next;
-	*buk = String_Builder::Bucket{};
+	buk->next = nullptr;
+	buk->written = 0;
 	return buk;
 }
 
@@ -131,7 +133,36 @@ void ResetBuilder(String_Builder *builder) {
 		builder->free_list = builder->head.next;
 	}
 
-	builder->head = String_Builder::Bucket{};
+	builder->head.next = nullptr;
+	builder->head.written = 0;
+	builder->current = &builder->head;
+	builder->written = 0;
+}
+
+String_Builder::Bucket *TakeBuckets(String_Builder *builder) {
+	if (!builder->written)
+		return nullptr;
+
+	auto first = StringBuilderNewBucket(builder);
+	memcpy(first->data, builder->head.data, builder->head.written);
+	first->written = builder->head.written;
+	first->next = builder->head.next;
+
+	builder->head.next = nullptr;
+	builder->head.written = 0;
+	builder->current = &builder->head;
+	builder->written = 0;
+
+	return first;
+}
+
+void GiveBuckets(String_Builder *builder, String_Builder::Bucket *buckets) {
+	while (buckets) {
+		auto buk = buckets;
+		buckets = buckets->next;
+		buk->next = builder->free_list;
+		builder->free_list = buk;
+	}
 }
 
 void FreeBuilder(String_Builder *builder) {
@@ -21,6 +21,15 @@ struct String_Builder {
 	Memory_Allocator allocator = ThreadContext.allocator;
 };
 
+// Takes the output of a builder while it is being written, so that long outputs are sent as they are produced.
+// The writer calls (flush) once the builder holds (threshold) bytes, which consumes them and resets the builder.
+struct String_Builder_Stream {
+	void (*flush)(String_Builder_Stream *stream, String_Builder *builder) = nullptr;
+	void *context = nullptr;
+	int64_t threshold = 0;
+	bool closed = false; // Set by flush once nobody receives the stream, the writer can stop producing
+};
+
 int WriteBuffer(String_Builder *builder, void *buffer, int64_t size);
 int Write(String_Builder *builder, bool value);
 int Write(String_Builder *builder, char value);
@@ -61,3 +70,10 @@ String BuildString(String_Builder *builder, Memory_Allocator &allocator = Thread
 
 void ResetBuilder(String_Builder *builder);
 void FreeBuilder(String_Builder *builder);
+
+// Takes the written buckets out of the builder, which is left empty, so that they are sent without being copied.
+// The first bucket is part of the builder, its content is moved to a bucket of the free list.
+String_Builder::Bucket *TakeBuckets(String_Builder *builder);
+
+// Adds buckets that are not used anymore to the free list of the builder
+void GiveBuckets(String_Builder *builder, String_Builder::Bucket *buckets);
@@ -77,6 +77,9 @@
 *       request + headers cannot fit in this size the request body will be
 *       streamed in.
 *
+*     HTTP_EVENT_BATCH_SIZE - default 64 - The maximum amount of events that
+*       the event loop takes from the kernel with each call.
+*
 *   For more details see the documentation of the interface and the example
 *   below.
 *
@@ -99,6 +102,7 @@ struct http_string_s {
 struct http_server_s;
 struct http_request_s;
 struct http_response_s;
+struct iovec;
 
 // Returns the event loop id that the server is running on. This will be an
 // epoll fd when running on Linux or a kqueue on BSD. This can be used to
@@ -247,12 +251,38 @@ void http_respond(struct http_request_s* request, struct http_response_s* respon
 // request will be the response status that is set when http_respond_chunk is
 // called the first time. Any headers set for the first call will be sent as
 // the response headers. Headers set for subsequent calls will be ignored.
+// If the session ends before the chunk is written, notify_done is still
+// called, with the HTTP_SESSION_ENDED flag set on the request.
 void http_respond_chunk(
   struct http_request_s* request,
   struct http_response_s* response,
   void (*notify_done)(struct http_request_s*)
 );
 
+// Writes the response with a body made of several buffers, that are written
+// to the client with writev instead of being copied. The response body set
+// with http_response_body is ignored. The buffers must be kept until the
+// notify_done callback is called, once they have been written or the session
+// has ended, in which case the HTTP_SESSION_ENDED flag is set on the request.
+void http_respond_iovec(
+  struct http_request_s* request,
+  struct http_response_s* response,
+  struct iovec const * body,
+  int count,
+  void (*notify_done)(struct http_request_s*)
+);
+
+// Same as http_respond_chunk, with the body of the chunk made of several
+// buffers that are not copied. The buffers must be kept until notify_done is
+// called.
+void http_respond_chunk_iovec(
+  struct http_request_s* request,
+  struct http_response_s* response,
+  struct iovec const * body,
+  int count,
+  void (*notify_done)(struct http_request_s*)
+);
+
 // Ends the chunked response. Any headers set before this call will be included
 // as what the HTTP spec refers to as 'trailers' which are essentially more
 // response headers.
@@ -332,6 +362,7 @@ int main() {
 #include <assert.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 
 #ifdef KQUEUE
@@ -351,6 +382,7 @@ int main() {
 #define HTTP_MAX_TOKEN_LENGTH 8192 // 8kb
 #define HTTP_MAX_TOTAL_EST_MEM_USAGE 4294967296 // 4gb
 #define HTTP_MAX_REQUEST_BUF_SIZE 8388608 // 8mb
+#define HTTP_EVENT_BATCH_SIZE 64
 
 #define HTTP_MAX_HEADER_COUNT 127
 
@@ -378,6 +410,7 @@ int main() {
 #define HTTP_END_SESSION 0x2
 #define HTTP_AUTOMATIC 0x8
 #define HTTP_CHUNKED_RESPONSE 0x20
+#define HTTP_SESSION_ENDED 0x40
 
 // http version indicators
 #define HTTP_1_0 0
@@ -440,8 +473,12 @@ typedef struct http_request_s {
   int timerfd;
 #endif
   void (*chunk_cb)(struct http_request_s*);
+  void (*iov_cb)(struct http_request_s*);
   void* data;
   hs_stream_t stream;
+  struct iovec* iov;
+  int iov_count;
+  int iov_index;
   http_parser_t parser;
   int state;
   int socket;
@@ -449,6 +486,7 @@ typedef struct http_request_s {
   struct http_server_s* server;
   http_token_dyn_t tokens;
   char flags;
+  struct http_request_s* next_ended;
 } http_request_t;
 
 typedef struct http_server_s {
@@ -468,6 +506,7 @@ typedef struct http_server_s {
   struct sockaddr_in addr;
   void* data;
   char date[32];
+  http_request_t* ended;
 } http_server_t;
 
 typedef struct http_header_s {
@@ -1028,14 +1067,40 @@ void hs_bind_localhost(int s, struct sockaddr_in* addr, const char* ipaddr, int
   }
 }
 
+ssize_t hs_writev_client_socket(http_request_t* session) {
+  struct iovec* iov = session->iov + session->iov_index;
+  int count = session->iov_count - session->iov_index;
+  if (count > IOV_MAX) count = IOV_MAX;
+  ssize_t bytes = writev(session->socket, iov, count);
+  // Skips the buffers that were written, the next one can be partially written
+  ssize_t left = bytes;
+  while (left > 0) {
+    if ((size_t)left < iov->iov_len) {
+      iov->iov_base = (char*)iov->iov_base + left;
+      iov->iov_len -= left;
+      break;
+    }
+    left -= iov->iov_len;
+    iov++;
+    session->iov_index++;
+  }
+  return bytes;
+}
+
 int hs_write_client_socket(http_request_t* session) {
-  int bytes = write(
-    session->socket,
-    session->stream.buf + session->stream.total_bytes,
-    session->stream.length - session->stream.total_bytes
-  );
+  ssize_t bytes;
+  if (session->iov) {
+    bytes = hs_writev_client_socket(session);
+  } else {
+    bytes = write(
+      session->socket,
+      session->stream.buf + session->stream.total_bytes,
+      session->stream.length - session->stream.total_bytes
+    );
+  }
   if (bytes > 0) session->stream.total_bytes += bytes;
-  return errno == EPIPE ? 0 : 1;
+  // errno is only set by a failed write, it can be left over from another session
+  return bytes < 0 && errno == EPIPE ? 0 : 1;
 }
 
 void hs_free_buffer(http_request_t* session) {
@@ -1044,6 +1109,20 @@ void hs_free_buffer(http_request_t* session) {
     session->server->memused -= session->stream.capacity;
     session->stream.buf = NULL;
   }
+  if (session->iov) {
+    free(session->iov);
+    session->iov = NULL;
+  }
+}
+
+// The buffers of the application are not used anymore once the response has
+// been written or the session has ended.
+void hs_notify_iov_done(http_request_t* session) {
+  void (*iov_cb)(struct http_request_s*) = session->iov_cb;
+  if (iov_cb) {
+    session->iov_cb = NULL;
+    iov_cb(session);
+  }
 }
 
 void hs_init_session(http_request_t* session) {
@@ -1058,12 +1137,31 @@ void hs_init_session(http_request_t* session) {
 }
 
 void hs_end_session(http_request_t* session) {
+  if (HTTP_FLAG_CHECK(session->flags, HTTP_SESSION_ENDED)) return;
   hs_delete_events(session);
   close(session->socket);
   hs_free_buffer(session);
   free(session->tokens.buf);
   session->tokens.buf = NULL;
-  free(session);
+  // Later events of the batch being handled can still refer to the session,
+  // it is freed once the whole batch has been handled.
+  HTTP_FLAG_SET(session->flags, HTTP_SESSION_ENDED);
+  session->next_ended = session->server->ended;
+  session->server->ended = session;
+  // The application waits for its chunk to be written, it learns from the
+  // flag that the chunk was dropped.
+  if (HTTP_FLAG_CHECK(session->flags, HTTP_CHUNKED_RESPONSE)) {
+    session->chunk_cb(session);
+  }
+  hs_notify_iov_done(session);
+}
+
+void hs_free_ended_sessions(http_server_t* serv) {
+  while (serv->ended) {
+    http_request_t* session = serv->ended;
+    serv->ended = session->next_ended;
+    free(session);
+  }
 }
 
 void hs_reset_timeout(http_request_t* request, int time) {
@@ -1091,6 +1189,7 @@ void hs_write_response(http_request_t* request) {
     hs_free_buffer(request);
     request->chunk_cb(request);
   } else {
+    hs_notify_iov_done(request);
     if (HTTP_FLAG_CHECK(request->flags, HTTP_KEEP_ALIVE)) {
       request->state = HTTP_SESSION_INIT;
       hs_free_buffer(request);
@@ -1206,6 +1305,7 @@ http_server_t* http_server_init(int port, void (*handler)(http_request_t*)) {
   assert(serv != NULL);
   serv->port = port;
   serv->memused = 0;
+  serv->ended = NULL;
   serv->handler = hs_server_listen_cb;
   hs_server_init(serv);
   hs_generate_date_time(serv->date);
@@ -1453,13 +1553,16 @@ void grwprintf(grwprintf_t* ctx, char const * fmt, ...) {
   va_start(args, fmt);
 
   int bytes = vsnprintf(ctx->buf + ctx->size, ctx->capacity - ctx->size, fmt, args);
-  if (bytes + ctx->size > ctx->capacity) {
+  // The output was truncated, vsnprintf also needs room for the terminator
+  if (bytes + ctx->size >= ctx->capacity) {
     *ctx->memused -= ctx->capacity;
-    while (bytes + ctx->size > ctx->capacity) ctx->capacity *= 2;
+    while (bytes + ctx->size >= ctx->capacity) ctx->capacity *= 2;
     *ctx->memused += ctx->capacity;
     ctx->buf = (char*)realloc(ctx->buf, ctx->capacity);
     assert(ctx->buf != NULL);
-    bytes += vsnprintf(ctx->buf + ctx->size, ctx->capacity - ctx->size, fmt, args);
+    va_end(args);
+    va_start(args, fmt);
+    vsnprintf(ctx->buf + ctx->size, ctx->capacity - ctx->size, fmt, args);
   }
   ctx->size += bytes;
 
@@ -1548,12 +1651,93 @@ void http_respond_chunk(
   http_end_response(request, response, &printctx);
 }
 
+// Writes the buffered part of the response, then the buffers of the body and
+// the tail when there is one.
+void hs_end_response_iovec(
+  http_request_t* request,
+  http_response_t* response,
+  grwprintf_t* printctx,
+  struct iovec const * body,
+  int count,
+  char const * tail
+) {
+  struct iovec* iov = (struct iovec*)malloc(sizeof(struct iovec) * (count + 2));
+  int iov_count = 0;
+  iov[iov_count++] = (struct iovec){ printctx->buf, (size_t)printctx->size };
+  int64_t length = printctx->size;
+  for (int i = 0; i < count; i++) {
+    iov[iov_count++] = body[i];
+    length += body[i].iov_len;
+  }
+  if (tail) {
+    iov[iov_count++] = (struct iovec){ (void*)tail, strlen(tail) };
+    length += strlen(tail);
+  }
+  http_header_t* header = response->headers;
+  while (header) {
+    http_header_t* tmp = header;
+    header = tmp->next;
+    free(tmp);
+  }
+  hs_free_buffer(request);
+  free(response);
+  request->stream.buf = printctx->buf;
+  request->stream.total_bytes = 0;
+  request->stream.length = length;
+  request->stream.capacity = printctx->capacity;
+  request->iov = iov;
+  request->iov_count = iov_count;
+  request->iov_index = 0;
+  request->state = HTTP_SESSION_WRITE;
+  hs_write_response(request);
+}
+
+int64_t hs_iovec_length(struct iovec const * body, int count) {
+  int64_t length = 0;
+  for (int i = 0; i < count; i++) length += body[i].iov_len;
+  return length;
+}
+
+void http_respond_iovec(
+  http_request_t* request,
+  http_response_t* response,
+  struct iovec const * body,
+  int count,
+  void (*cb)(http_request_t*)
+) {
+  grwprintf_t printctx;
+  grwprintf_init(&printctx, HTTP_RESPONSE_BUF_SIZE, &request->server->memused);
+  response->content_length = (int)hs_iovec_length(body, count);
+  http_respond_headers(request, response, &printctx);
+  request->iov_cb = cb;
+  hs_end_response_iovec(request, response, &printctx, body, count, NULL);
+}
+
+void http_respond_chunk_iovec(
+  http_request_t* request,
+  http_response_t* response,
+  struct iovec const * body,
+  int count,
+  void (*cb)(http_request_t*)
+) {
+  grwprintf_t printctx;
+  grwprintf_init(&printctx, HTTP_RESPONSE_BUF_SIZE, &request->server->memused);
+  if (!HTTP_FLAG_CHECK(request->flags, HTTP_CHUNKED_RESPONSE)) {
+    HTTP_FLAG_SET(request->flags, HTTP_CHUNKED_RESPONSE);
+    http_response_header(response, "Transfer-Encoding", "chunked");
+    http_respond_headers(request, response, &printctx);
+  }
+  request->chunk_cb = cb;
+  grwprintf(&printctx, "%lX\r\n", (long)hs_iovec_length(body, count));
+  hs_end_response_iovec(request, response, &printctx, body, count, "\r\n");
+}
+
 void http_respond_chunk_end(http_request_t* request, http_response_t* response) {
   grwprintf_t printctx;
   grwprintf_init(&printctx, HTTP_RESPONSE_BUF_SIZE, &request->server->memused);
   grwprintf(&printctx, "0\r\n");
+  // The trailers end with the empty line
   http_buffer_headers(request, response, &printctx);
-  grwprintf(&printctx, "\r\n");
   HTTP_FLAG_CLEAR(request->flags, HTTP_CHUNKED_RESPONSE);
   http_end_response(request, response, &printctx);
 }
@@ -1573,7 +1757,9 @@ void hs_server_listen_cb(struct kevent* ev) {
 
 void hs_session_io_cb(struct kevent* ev) {
   http_request_t* request = (http_request_t*)ev->udata;
+  if (HTTP_FLAG_CHECK(request->flags, HTTP_SESSION_ENDED)) return;
   if (ev->filter == EVFILT_TIMER) {
+    if (request->state == HTTP_SESSION_NOP) return;
     request->timeout -= 1;
     if (request->timeout == 0) hs_end_session(request);
   } else {
@@ -1597,14 +1783,15 @@ void hs_add_server_sock_events(http_server_t* serv) {
 int http_server_listen_addr(http_server_t* serv, const char* ipaddr) {
   http_listen(serv, ipaddr);
 
-  struct kevent ev_list[1];
+  struct kevent ev_list[HTTP_EVENT_BATCH_SIZE];
 
   while (1) {
-    int nev = kevent(serv->loop, NULL, 0, ev_list, 1, NULL);
+    int nev = kevent(serv->loop, NULL, 0, ev_list, HTTP_EVENT_BATCH_SIZE, NULL);
     for (int i = 0; i < nev; i++) {
       ev_cb_t* ev_cb = (ev_cb_t*)ev_list[i].udata;
       ev_cb->handler(&ev_list[i]);
     }
+    hs_free_ended_sessions(serv);
   }
   return 0;
 }
@@ -1626,6 +1813,7 @@ int http_server_poll(http_server_t* serv) {
   if (nev <= 0) return nev;
   ev_cb_t* ev_cb = (ev_cb_t*)ev.udata;
   ev_cb->handler(&ev);
+  hs_free_ended_sessions(serv);
   return nev;
 }
 
@@ -1651,7 +1839,9 @@ void hs_server_listen_cb(struct epoll_event* ev) {
 }
 
 void hs_session_io_cb(struct epoll_event* ev) {
-  http_session((http_request_t*)ev->data.ptr);
+  http_request_t* request = (http_request_t*)ev->data.ptr;
+  if (HTTP_FLAG_CHECK(request->flags, HTTP_SESSION_ENDED)) return;
+  http_session(request);
 }
 
 void hs_server_timer_cb(struct epoll_event* ev) {
@@ -1664,9 +1854,13 @@ void hs_server_timer_cb(struct epoll_event* ev) {
 
 void hs_request_timer_cb(struct epoll_event* ev) {
   http_request_t* request = (http_request_t*)((char*)ev->data.ptr - sizeof(epoll_cb_t));
+  if (HTTP_FLAG_CHECK(request->flags, HTTP_SESSION_ENDED)) return;
   uint64_t res;
   int bytes = read(request->timerfd, &res, sizeof(res));
   (void)bytes; // suppress warning
+  // The application still owns requests that were handed to it and not
+  // responded to yet, these can take longer than the timeout.
+  if (request->state == HTTP_SESSION_NOP) return;
   request->timeout -= 1;
   if (request->timeout == 0) hs_end_session(request);
 }
@@ -1697,13 +1891,14 @@ void hs_server_init(http_server_t* serv) {
 
 int http_server_listen_addr(http_server_t* serv, const char* ipaddr) {
   http_listen(serv, ipaddr);
-  struct epoll_event ev_list[1];
+  struct epoll_event ev_list[HTTP_EVENT_BATCH_SIZE];
   while (1) {
-    int nev = epoll_wait(serv->loop, ev_list, 1, -1);
+    int nev = epoll_wait(serv->loop, ev_list, HTTP_EVENT_BATCH_SIZE, -1);
     for (int i = 0; i < nev; i++) {
       ev_cb_t* ev_cb = (ev_cb_t*)ev_list[i].data.ptr;
       ev_cb->handler(&ev_list[i]);
     }
+    hs_free_ended_sessions(serv);
   }
   return 0;
 }
@@ -1724,6 +1919,7 @@ int http_server_poll(http_server_t* serv) {
   if (nev <= 0) return nev;
   ev_cb_t* ev_cb = (ev_cb_t*)ev.data.ptr;
   ev_cb->handler(&ev);
+  hs_free_ended_sessions(serv);
   return nev;
 }
 
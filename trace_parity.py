@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# Runs every sample under the tree walker and the bytecode VM and compares the traces the server returns.
+# Both have to raise the same intercepts at the same lines with the same callstack and console, and a
+# caller variable that holds the returned value at a procedure_return of the tree walker has to hold it
+# on the VM as well. Other variable values are not compared, frames are laid out differently and what a
+# variable shows before it is written depends on the evaluator.
+#
+# Usage: ./build.sh && ./trace_parity.py
+
+import glob
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+import urllib.request
+
+ROOT   = os.path.dirname(os.path.abspath(__file__))
+SERVER = os.path.join(ROOT, 'bin', 'Kano')
+INPUT  = '##INPUT 5 3 7 2 9 4 1 8\n'
+
+def normalized(value):
+	# Stack and heap addresses differ between runs, also where a pointer is seen through an integer
+	text = json.dumps(value, sort_keys=True)
+	text = re.sub(r'0x[0-9a-f]+', 'ADDR', text)
+	text = re.sub(r'"[0-9a-f]{12}"', '"ADDR"', text)
+	return re.sub(r'"[0-9]{12,}"', '"ADDR"', text)
+
+def trace(flags, samples):
+	server = subprocess.Popen([SERVER] + flags, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+	try:
+		time.sleep(0.5)
+		traces = {}
+		for sample in samples:
+			with open(sample, 'rb') as file:
+				body = INPUT.encode() + file.read()
+			with urllib.request.urlopen('http://localhost:8000', body) as response:
+				traces[sample] = json.loads(response.read()).get('runtime', [])
+		return traces
+	finally:
+		server.kill()
+		server.wait()
+
+def frames(event):
+	return [(frame['procedure'], {v['name']: normalized(v.get('value')) for v in frame.get('variables', [])})
+		for frame in event.get('callstack', [])]
+
+def compare(name, walker, vm):
+	if len(walker) != len(vm):
+		return '%s: %d intercepts on the tree walker, %d on the VM' % (name, len(walker), len(vm))
+
+	previous = None
+	for index, (a, b) in enumerate(zip(walker, vm)):
+		for key in ('intercept', 'line_number', 'console_out', 'console_in'):
+			if a.get(key) != b.get(key):
+				return '%s: intercept %d differs in %s' % (name, index, key)
+
+		if normalized(a.get('globals')) != normalized(b.get('globals')):
+			return '%s: intercept %d differs in globals' % (name, index)
+
+		frames_a, frames_b = frames(a), frames(b)
+		if [f[0] for f in frames_a] != [f[0] for f in frames_b]:
+			return '%s: intercept %d differs in callstack' % (name, index)
+
+		if a['intercept'] == 'procedure_return' and previous and len(frames_a) >= 2:
+			caller, before = frames_a[-2][1], previous[-2][1] if len(previous) >= 2 else {}
+			for variable, value in caller.items():
+				if before.get(variable) != value and frames_b[-2][1].get(variable) != value:
+					return '%s: intercept %d, %s is %s on the tree walker and %s on the VM' % (
+						name, index, variable, value, frames_b[-2][1].get(variable))
+
+		previous = frames_a
+
+	return None
+
+def main():
+	samples = sorted(glob.glob(os.path.join(ROOT, 'Samples', '*.kn')))
+	walker  = trace([], samples)
+	vm      = trace(['--vm'], samples)
+
+	failed = 0
+	for sample in samples:
+		error = compare(os.path.basename(sample), walker[sample], vm[sample])
+		if error:
+			print(error)
+			failed += 1
+
+	print('%d of %d samples match' % (len(samples) - failed, len(samples)))
+	return 1 if failed else 0
+
+if __name__ == '__main__':
+	sys.exit(main())